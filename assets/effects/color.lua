@@ -1,6 +1,6 @@
 {
     vertex = {
-        uniformBuffers = {
+        pushConstants = {
             matrices = {
                 wvp = "mat4"
             }
@@ -0,0 +1,109 @@
+{
+    vertex = {
+        uniformBuffers = {
+            uniforms = {
+                vp = "mat4",
+                lightVp = "mat4",
+                lightPos = "vec3"
+            }
+        },
+
+        inputs = {
+            sl_Position = "vec3",
+            sl_TexCoord = "vec2",
+            sl_Normal = "vec3",
+            sl_InstanceWorld = "mat4"
+        },
+
+        outputs = {
+            uv = "vec2",
+            shadowCoord = "vec4",
+            normal = "vec3",
+            lightVec = "vec3",
+            viewVec = "vec3"
+        },
+
+        code = [[
+            void main()
+            {
+                const mat4 biasMat = SL_SHADOW_BIAS_MAT;
+
+                uv = sl_TexCoord;
+                SL_FIX_UV#uv#;
+
+                vec4 worldPos = sl_InstanceWorld * vec4(sl_Position, 1.0);
+                gl_Position = #uniforms:vp# * worldPos;
+                SL_FIX_Y#gl_Position#;
+
+                vec4 lightProjectedPos = #uniforms:lightVp# * worldPos;
+                SL_FIX_Y#lightProjectedPos#;
+                shadowCoord = biasMat * lightProjectedPos;
+
+                normal = mat3(sl_InstanceWorld) * sl_Normal;
+                lightVec = normalize(#uniforms:lightPos# - worldPos.xyz);
+                viewVec = -worldPos.xyz;			
+            }
+        ]]
+    },
+
+    fragment = {
+        samplers = {
+            mainTex = "sampler2D",
+            shadowMap = "sampler2D"
+        },
+
+        outputs = {
+            fragColor = { type = "vec4", target = 0 }
+        },
+
+        code = [[
+            const float ambient = 0.1;
+
+            float sampleShadow(vec4 coords, vec2 offset)
+            {
+                float shadow = 1.0;
+                float dist = texture(shadowMap, coords.st + offset).r;
+                if (dist < coords.z - 0.00002)
+                    shadow = ambient;
+                return shadow;
+            }
+
+            float samplePCF(vec4 coords)
+            {
+                ivec2 texDim = textureSize(shadowMap, 0);
+                float scale = 1.5;
+                float dx = scale * 1.0 / float(texDim.x);
+                float dy = scale * 1.0 / float(texDim.y);
+
+                float shadowFactor = 0.0;
+                int count = 0;
+                int range = 1;
+                
+                for (int x = -range; x <= range; x++)
+                {
+                    for (int y = -range; y <= range; y++)
+                    {
+                        shadowFactor += sampleShadow(coords, vec2(dx * x, dy * y));
+                        count++;
+                    }
+                
+                }
+                return shadowFactor / count;
+            }
+
+            void main()
+            {
+                vec3 n = normalize(normal);
+                vec3 l = normalize(lightVec);
+                vec3 v = normalize(viewVec);
+                vec3 r = normalize(-reflect(l, n));
+                float diffuse = max(dot(n, l), ambient);
+
+                vec4 coords = shadowCoord / shadowCoord.w;
+                float shadow = samplePCF(coords);
+
+                fragColor = texture(mainTex, uv) * min(diffuse, shadow);
+            }
+        ]]
+    }
+}
\ No newline at end of file
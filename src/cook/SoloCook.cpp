@@ -0,0 +1,341 @@
+/*
+ * SoloCook - offline asset cooker. Walks an asset directory and writes cooked siblings of meshes and textures
+ * next to their sources, which runtime loaders then pick up instead of parsing the sources.
+ * 
+ * Copyright (c) Aleksey Fedotov
+ * MIT license
+*/
+
+#include <Solo.h>
+#include <atomic>
+#include <thread>
+#include <algorithm>
+
+#ifdef SL_WINDOWS
+#   include <windows.h>
+#else
+#   include <dirent.h>
+#   include <sys/stat.h>
+#endif
+
+using namespace solo;
+
+namespace
+{
+    enum class AssetKind
+    {
+        Mesh,
+        Texture
+    };
+
+    enum class CookStatus
+    {
+        UpToDate,
+        Cooked,
+        Failed
+    };
+
+    struct Asset
+    {
+        str relativePath;
+        AssetKind kind;
+        str hash;
+        CookStatus status = CookStatus::Failed;
+        str error;
+    };
+
+    const str manifestFileName = "SoloCook.manifest";
+}
+
+// Runtime loaders only take cooked meshes whose layout matches the requested one, so the layout is configurable.
+// Attributes are given as "usage[:format]", e.g. "position normal:snorm10 texcoord:half"
+static bool parseAttribute(const str &arg, VertexBufferLayout &layout)
+{
+    static const umap<str, VertexAttributeUsage> usages = {
+        {"position", VertexAttributeUsage::Position},
+        {"normal", VertexAttributeUsage::Normal},
+        {"texcoord", VertexAttributeUsage::TexCoord},
+        {"tangent", VertexAttributeUsage::Tangent},
+        {"binormal", VertexAttributeUsage::Binormal},
+        {"color", VertexAttributeUsage::Color}
+    };
+    static const umap<str, VertexAttributeFormat> formats = {
+        {"float", VertexAttributeFormat::Float},
+        {"half", VertexAttributeFormat::Half},
+        {"snorm8", VertexAttributeFormat::SNorm8},
+        {"unorm8", VertexAttributeFormat::UNorm8},
+        {"snorm10", VertexAttributeFormat::SNorm10_10_10_2}
+    };
+
+    const auto separator = arg.find(':');
+    const auto usage = usages.find(arg.substr(0, separator));
+    const auto format = separator == str::npos ? formats.find("float") : formats.find(arg.substr(separator + 1));
+    if (usage == usages.end() || format == formats.end())
+        return false;
+
+    layout.addAttribute(usage->second, format->second);
+    return true;
+}
+
+// The layout most demos request
+static auto defaultMeshLayout() -> VertexBufferLayout
+{
+    VertexBufferLayout layout;
+    layout.addAttribute(VertexAttributeUsage::Position);
+    layout.addAttribute(VertexAttributeUsage::Normal);
+    layout.addAttribute(VertexAttributeUsage::TexCoord);
+    return layout;
+}
+
+static bool hasAnyExtension(const str &path, const vec<str> &extensions)
+{
+    auto lowerPath = path;
+    std::transform(lowerPath.begin(), lowerPath.end(), lowerPath.begin(), ::tolower);
+    return std::any_of(extensions.begin(), extensions.end(),
+        [&](const str &ext) { return lowerPath.size() > ext.size() && stringutils::endsWith(lowerPath, ext); });
+}
+
+static bool toAssetKind(const str &path, AssetKind &kind)
+{
+    static const vec<str> meshExtensions = {".obj", ".dae", ".fbx", ".3ds"};
+    static const vec<str> textureExtensions = {".bmp", ".jpg", ".jpeg", ".png"};
+
+    if (hasAnyExtension(path, meshExtensions))
+    {
+        kind = AssetKind::Mesh;
+        return true;
+    }
+
+    if (hasAnyExtension(path, textureExtensions))
+    {
+        kind = AssetKind::Texture;
+        return true;
+    }
+
+    return false;
+}
+
+static void listFiles(const str &rootDir, const str &relativeDir, vec<str> &result)
+{
+    const auto dir = relativeDir.empty() ? rootDir : rootDir + "/" + relativeDir;
+    const auto toRelative = [&](const str &name) { return relativeDir.empty() ? name : relativeDir + "/" + name; };
+
+#ifdef SL_WINDOWS
+    WIN32_FIND_DATAA entry;
+    const auto handle = FindFirstFileA((dir + "/*").c_str(), &entry);
+    if (handle == INVALID_HANDLE_VALUE)
+        return;
+
+    do
+    {
+        const str name = entry.cFileName;
+        if (name == "." || name == "..")
+            continue;
+        if (entry.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY)
+            listFiles(rootDir, toRelative(name), result);
+        else
+            result.push_back(toRelative(name));
+    } while (FindNextFileA(handle, &entry));
+
+    FindClose(handle);
+#else
+    const auto handle = opendir(dir.c_str());
+    if (!handle)
+        return;
+
+    while (const auto entry = readdir(handle))
+    {
+        const str name = entry->d_name;
+        if (name == "." || name == "..")
+            continue;
+
+        struct stat info;
+        if (stat((dir + "/" + name).c_str(), &info))
+            continue;
+        if (S_ISDIR(info.st_mode))
+            listFiles(rootDir, toRelative(name), result);
+        else if (S_ISREG(info.st_mode))
+            result.push_back(toRelative(name));
+    }
+
+    closedir(handle);
+#endif
+}
+
+static auto cookedPath(const str &path, AssetKind kind) -> str
+{
+    return path + (kind == AssetKind::Mesh ? CookedMesh::extension : CookedTexture::extension);
+}
+
+// Hashes the source content together with the cooked format version and mesh layout,
+// so changing either invalidates the manifest
+static auto contentHash(FileSystem *fs, const str &path, AssetKind kind, const VertexBufferLayout &meshLayout) -> str
+{
+    const auto version = kind == AssetKind::Mesh ? CookedMesh::version : CookedTexture::version;
+    auto seed = hashBytes(&version, sizeof(version));
+    if (kind == AssetKind::Mesh)
+    {
+        for (u32 i = 0; i < meshLayout.attributeCount(); i++)
+        {
+            const u32 attr[] = {
+                static_cast<u32>(meshLayout.attribute(i).usage),
+                static_cast<u32>(meshLayout.attribute(i).format)
+            };
+            seed = hashBytes(attr, sizeof(attr), seed);
+        }
+    }
+
+    const auto mapping = fs->map(path);
+    return stringutils::toHex(hashBytes(mapping->data(), mapping->size(), seed));
+}
+
+static auto readManifest(FileSystem *fs, const str &path) -> umap<str, str>
+{
+    umap<str, str> result;
+    if (!fs->exists(path))
+        return result;
+
+    // Each line is "<content hash> <relative path>"
+    fs->iterateLines(path, [&](const str &line)
+    {
+        const auto separator = line.find(' ');
+        if (separator != str::npos)
+            result[line.substr(separator + 1)] = line.substr(0, separator);
+        return true;
+    });
+
+    return result;
+}
+
+static void cookAsset(FileSystem *fs, const str &rootDir, const VertexBufferLayout &meshLayout,
+    const umap<str, str> &manifest, Asset &asset)
+{
+    const auto path = rootDir + "/" + asset.relativePath;
+    const auto outPath = cookedPath(path, asset.kind);
+
+    try
+    {
+        asset.hash = contentHash(fs, path, asset.kind, meshLayout);
+
+        // Loaders ignore cooked files older than their sources, so those are rewritten even if the content is the same
+        const auto entry = manifest.find(asset.relativePath);
+        if (entry != manifest.end() && entry->second == asset.hash && fs->exists(outPath) &&
+            fs->lastWriteTime(outPath) >= fs->lastWriteTime(path))
+        {
+            asset.status = CookStatus::UpToDate;
+            return;
+        }
+
+        // Loaders log the reason themselves
+        const auto cooked = asset.kind == AssetKind::Mesh
+            ? CookedMesh::cookFile(fs, path, outPath, meshLayout)
+            : CookedTexture::cookFile(fs, path, outPath);
+        if (!cooked)
+        {
+            asset.hash.clear();
+            asset.status = CookStatus::Failed;
+            asset.error = "unable to load the source";
+            return;
+        }
+
+        asset.status = CookStatus::Cooked;
+    }
+    catch (const std::exception &e)
+    {
+        asset.hash.clear();
+        asset.status = CookStatus::Failed;
+        asset.error = e.what();
+    }
+}
+
+int main(int argc, s8 *argv[])
+{
+    if (argc <= 1)
+    {
+        Logger::global().logInfo("Usage: SoloCook <asset directory> [mesh attribute[:format] ...]");
+        return 1;
+    }
+
+    auto meshLayout = argc > 2 ? VertexBufferLayout() : defaultMeshLayout();
+    for (auto i = 2; i < argc; i++)
+    {
+        if (!parseAttribute(argv[i], meshLayout))
+        {
+            Logger::global().logError(SL_FMT("Unknown mesh attribute ", argv[i]));
+            return 1;
+        }
+    }
+
+    try
+    {
+        const str rootDir = argv[1];
+        // The file system does not depend on the device, so the cooker can run without creating a window
+        const auto fs = FileSystem::fromDevice(nullptr);
+        const auto manifestPath = rootDir + "/" + manifestFileName;
+        const auto manifest = readManifest(fs.get(), manifestPath);
+
+        vec<str> files;
+        listFiles(rootDir, "", files);
+
+        vec<Asset> assets;
+        for (const auto &file: files)
+        {
+            Asset asset;
+            if (toAssetKind(file, asset.kind))
+            {
+                asset.relativePath = file;
+                assets.push_back(asset);
+            }
+        }
+
+        // Assets are independent, so workers just pull the next one until none are left
+        std::atomic<size_t> next{0};
+        const auto workerCount = (std::max)(1u, std::thread::hardware_concurrency());
+        vec<std::thread> workers;
+        for (u32 i = 0; i < workerCount; i++)
+        {
+            workers.emplace_back([&]()
+            {
+                for (auto index = next++; index < assets.size(); index = next++)
+                    cookAsset(fs.get(), rootDir, meshLayout, manifest, assets[index]);
+            });
+        }
+        for (auto &worker: workers)
+            worker.join();
+
+        vec<str> manifestLines;
+        u32 cookedCount = 0, failedCount = 0;
+        for (const auto &asset: assets)
+        {
+            switch (asset.status)
+            {
+                case CookStatus::Cooked:
+                    cookedCount++;
+                    Logger::global().logInfo(SL_FMT("Cooked ", asset.relativePath));
+                    break;
+                case CookStatus::Failed:
+                    failedCount++;
+                    Logger::global().logError(SL_FMT("Failed to cook ", asset.relativePath, ": ", asset.error));
+                    break;
+                default:
+                    break;
+            }
+
+            // Failed assets are left out so the next run retries them
+            if (!asset.hash.empty())
+                manifestLines.push_back(asset.hash + " " + asset.relativePath);
+        }
+
+        fs->writeLines(manifestPath, manifestLines);
+
+        Logger::global().logInfo(SL_FMT(
+            "Cooked ", cookedCount, ", up to date ", assets.size() - cookedCount - failedCount, ", failed ", failedCount));
+
+        return failedCount ? 2 : 0;
+    }
+    catch (const std::exception &e)
+    {
+        Logger::global().logCritical(e.what());
+        return 2;
+    }
+}
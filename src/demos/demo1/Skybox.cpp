@@ -15,6 +15,7 @@ auto createSkybox(Device *device, Scene *scene) -> MeshRenderer*
     const auto material = Material::fromEffect(device, effect);
     material->setDepthTest(true);
     material->setDepthWrite(false);
+    material->setRenderOrder(RenderOrder::Background);
     material->setFaceCull(FaceCull::None);
     material->bindParameter("matrices:proj", ParameterBinding::ProjectionMatrix);
     material->bindParameter("matrices:worldView", ParameterBinding::WorldViewMatrix);
@@ -22,6 +23,7 @@ auto createSkybox(Device *device, Scene *scene) -> MeshRenderer*
     const auto skyboxNode = scene->createNode();
     const auto renderer = skyboxNode->addComponent<MeshRenderer>();
     renderer->setMesh(mesh);
+    renderer->setFrustumCulling(false); // always covers the whole screen
     renderer->setMaterial(0, material);
 
     const auto texture = CubeTexture::fromFaceFiles(device,
@@ -32,11 +32,13 @@ function demo()
 
     ---
 
-    function createMesh(meshPath, material)
+    function createMesh(meshPath, material, occluder)
         local node = scene:createNode()
     
         local renderer = node:addComponent("MeshRenderer")
         renderer:setDefaultMaterial(material)
+        renderer:setOccluder(occluder or false)
+        renderer:setOccludee(not occluder)
     
         local transform = node:findComponent("Transform")
     
@@ -44,8 +46,13 @@ function demo()
         layout:addAttribute(sl.VertexAttributeUsage.Position)
         layout:addAttribute(sl.VertexAttributeUsage.Normal)
         layout:addAttribute(sl.VertexAttributeUsage.TexCoord)
-        sl.Mesh.fromFileAsync(sl.device, assetPath(meshPath), layout)
-            :done(function(mesh) renderer:setMesh(mesh) end)
+        if occluder then
+            -- Occluder geometry is simplified from the mesh data while loading
+            renderer:setMesh(sl.Mesh.fromFileWithOccluder(sl.device, assetPath(meshPath), layout, 0.25))
+        else
+            sl.Mesh.fromFileAsync(sl.device, assetPath(meshPath), layout)
+                :done(function(mesh) renderer:setMesh(mesh) end)
+        end
 
         return {
             node = node,
@@ -64,7 +71,7 @@ function demo()
     end
 
     function createBackdrop(material)
-        local backdrop = createMesh("meshes/backdrop.obj", material)
+        local backdrop = createMesh("meshes/backdrop.obj", material, true)
         
         local params = sl.RigidBodyParams()
         params.mass = 0
@@ -105,12 +112,24 @@ function demo()
         return mat
     end
 
-    function createSpectatorCamera(shadowedMat)
+    -- Takes world matrices per instance, so all spawned boxes are drawn in a single batch
+    function createShadowedInstancedMaterial(depthTex)
+        local eff = assetCache.getEffect("shadowed-instanced")
+        local mat = sl.Material.fromEffect(sl.device, eff)
+        mat:setFaceCull(sl.FaceCull.None)
+        mat:bindParameter("uniforms:vp", sl.ParameterBinding.ViewProjectionMatrix)
+        mat:setTextureParameter("mainTex", assetCache.textures.cobbleStone)
+        mat:setTextureParameter("shadowMap", depthTex)
+        return mat
+    end
+
+    function createSpectatorCamera(spawnedMat)
         local camera, node = createMainCamera(scene)
+        camera:setOcclusionCulling(true)
         node:findComponent("Transform"):setLocalPosition(vec3(10, 10, -5))
         node:findComponent("Transform"):lookAt(vec3(0, 2, 0), vec3(0, 1, 0))
         node:addScriptComponent(createTracer(sl.device, scene, physics, assetCache))
-        node:addScriptComponent(createSpawner(assetCache, shadowedMat))
+        node:addScriptComponent(createSpawner(assetCache, spawnedMat))
         node:addScriptComponent(createHighlighter(assetCache, physics))
 
         return {
@@ -134,7 +153,12 @@ function demo()
 
     local lightCam = createLightCamera(scene)
     local shadowedMat = createShadowedMaterial(lightCam.depthTex)
-    local mainCamera = createSpectatorCamera(shadowedMat)
+    local lightVpParam = shadowedMat:parameterHandle("uniforms:lightVp")
+    local lightPosParam = shadowedMat:parameterHandle("uniforms:lightPos")
+    local spawnedMat = createShadowedInstancedMaterial(lightCam.depthTex)
+    local spawnedLightVpParam = spawnedMat:parameterHandle("uniforms:lightVp")
+    local spawnedLightPosParam = spawnedMat:parameterHandle("uniforms:lightPos")
+    local mainCamera = createSpectatorCamera(spawnedMat)
 
     local postProcessor = createPostProcessor(assetCache, mainCamera.camera)
     local ppControlPanel = createPostProcessorControlPanel(assetCache, mainCamera.node, postProcessor)
@@ -185,10 +209,16 @@ function demo()
 
     function update()
         scene:visit(updateCmp)
-        shadowedMat:setMatrixParameter("uniforms:lightVp", lightCam.camera:viewProjectionMatrix())
-        shadowedMat:setVector3Parameter("uniforms:lightPos", lightCam.transform:worldPosition())
+        shadowedMat:setMatrix(lightVpParam, lightCam.camera:viewProjectionMatrix())
+        shadowedMat:setVector3(lightPosParam, lightCam.transform:worldPosition())
+        spawnedMat:setMatrix(spawnedLightVpParam, lightCam.camera:viewProjectionMatrix())
+        spawnedMat:setVector3(spawnedLightPosParam, lightCam.transform:worldPosition())
         lightCam.camera:renderFrame(renderLightCamFrame)
         mainCamera.camera:renderFrame(renderMainCamFrame)
+        if sl.device:isKeyPressed(sl.KeyCode.I, true) then
+            local stats = renderer:renderQueueStats()
+            print(string.format("Main camera: %d draws in %d batches", stats.drawCount, stats.batchCount))
+        end
         postProcessor:apply()
     end
 
@@ -13,6 +13,7 @@ local function createStep(camera, material, target, assetCache)
     local quadRenderer = node:addComponent("MeshRenderer")
     quadRenderer:setTag(tags.postProcessorStep)
     quadRenderer:setMesh(assetCache.meshes.getQuad())
+    quadRenderer:setFrustumCulling(false) -- drawn in screen space regardless of camera
     quadRenderer:setMaterial(0, material); -- TODO setting nil as material here causes VK renderer to crash
 
     return {
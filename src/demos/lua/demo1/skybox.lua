@@ -19,12 +19,14 @@ return function(scene, assetCache)
     local material = sl.Material.fromEffect(sl.device, effect)
     material:setDepthTest(true)
     material:setDepthWrite(false)
+    material:setRenderOrder(sl.RenderOrder.Background)
     material:setFaceCull(sl.FaceCull.None)
     material:bindParameter("matrices:proj", sl.ParameterBinding.ProjectionMatrix)
     material:bindParameter("matrices:worldView", sl.ParameterBinding.WorldViewMatrix)
     
     local renderer = node:addComponent("MeshRenderer")
     renderer:setMesh(mesh)
+    renderer:setFrustumCulling(false) -- always covers the whole screen
     renderer:setTag(tag)
     renderer:setMaterial(0, material)
 
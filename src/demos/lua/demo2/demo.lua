@@ -214,6 +214,7 @@ function demo()
     local deferQuadRenderer = deferQuadNode:addComponent("MeshRenderer")
     deferQuadRenderer:setTag(tags.postProcessorStep) -- TODO use other tag
     deferQuadRenderer:setMesh(assetCache.meshes.getQuad())
+    deferQuadRenderer:setFrustumCulling(false)
     deferQuadRenderer:setMaterial(0, deferMaterial);
 
     local mainCam, camNode = createMainCamera(scene)
@@ -6,11 +6,15 @@
 #pragma once
 
 #include "SoloAsyncHandle.h"
+#include "SoloBoundingBox.h"
 #include "SoloBoxCollider.h"
+#include "SoloBvh.h"
 #include "SoloCamera.h"
 #include "SoloCollider.h"
 #include "SoloCommon.h"
 #include "SoloComponent.h"
+#include "SoloCookedMesh.h"
+#include "SoloCookedTexture.h"
 #include "SoloDegrees.h"
 #include "SoloDevice.h"
 #include "SoloDeviceSetup.h"
@@ -20,14 +24,17 @@
 #include "SoloFontMesh.h"
 #include "SoloFormatter.h"
 #include "SoloFrameBuffer.h"
+#include "SoloFrustum.h"
 #include "SoloHash.h"
 #include "SoloJobPool.h"
+#include "SoloLodGroup.h"
 #include "SoloMaterial.h"
 #include "SoloMath.h"
 #include "SoloMatrix.h"
 #include "SoloMesh.h"
 #include "SoloMeshRenderer.h"
 #include "SoloNode.h"
+#include "SoloOcclusionBuffer.h"
 #include "SoloPhysics.h"
 #include "SoloQuaternion.h"
 #include "SoloRadians.h"
@@ -0,0 +1,77 @@
+/* 
+ * Copyright (c) Aleksey Fedotov 
+ * MIT license 
+ */
+
+#include "SoloBoundingBox.h"
+#include "SoloMatrix.h"
+#include <algorithm>
+#include <cmath>
+
+using namespace solo;
+
+auto BoundingBox::infinite() -> BoundingBox
+{
+    return {Vector3(std::numeric_limits<float>::lowest()), Vector3((std::numeric_limits<float>::max)())};
+}
+
+BoundingBox::BoundingBox(const Vector3 &min, const Vector3 &max):
+    min_(min),
+    max_(max)
+{
+}
+
+bool BoundingBox::isEmpty() const
+{
+    return min_.x() > max_.x() || min_.y() > max_.y() || min_.z() > max_.z();
+}
+
+bool BoundingBox::isInfinite() const
+{
+    return min_.x() == std::numeric_limits<float>::lowest() && max_.x() == (std::numeric_limits<float>::max)();
+}
+
+void BoundingBox::include(const Vector3 &point)
+{
+    min_ = Vector3((std::min)(min_.x(), point.x()), (std::min)(min_.y(), point.y()), (std::min)(min_.z(), point.z()));
+    max_ = Vector3((std::max)(max_.x(), point.x()), (std::max)(max_.y(), point.y()), (std::max)(max_.z(), point.z()));
+}
+
+void BoundingBox::include(const BoundingBox &box)
+{
+    if (box.isEmpty())
+        return;
+    include(box.min_);
+    include(box.max_);
+}
+
+auto BoundingBox::transformed(const Matrix &matrix) const -> BoundingBox
+{
+    if (isEmpty() || isInfinite())
+        return *this;
+
+    // Transforms the center and accumulates absolute matrix columns scaled by extents (Arvo's method),
+    // which is cheaper than transforming all eight corners
+    const auto m = matrix.columns();
+    const auto center = this->center();
+    const auto extents = this->extents();
+    const float c[] = {center.x(), center.y(), center.z()};
+    const float e[] = {extents.x(), extents.y(), extents.z()};
+
+    float newCenter[3];
+    float newExtents[3];
+    for (u32 row = 0; row < 3; row++)
+    {
+        newCenter[row] = m[12 + row];
+        newExtents[row] = 0;
+        for (u32 col = 0; col < 3; col++)
+        {
+            newCenter[row] += m[col * 4 + row] * c[col];
+            newExtents[row] += std::abs(m[col * 4 + row]) * e[col];
+        }
+    }
+
+    const Vector3 resultCenter(newCenter[0], newCenter[1], newCenter[2]);
+    const Vector3 resultExtents(newExtents[0], newExtents[1], newExtents[2]);
+    return {resultCenter - resultExtents, resultCenter + resultExtents};
+}
@@ -0,0 +1,44 @@
+/* 
+ * Copyright (c) Aleksey Fedotov 
+ * MIT license 
+ */
+
+#pragma once
+
+#include "SoloCommon.h"
+#include "SoloVector3.h"
+#include <limits>
+
+namespace solo
+{
+    class Matrix;
+
+    // Axis-aligned box. Default-constructed boxes are empty and grow as points are included
+    class BoundingBox final
+    {
+    public:
+        // Contains everything, for objects whose bounds are not known
+        static auto infinite() -> BoundingBox;
+
+        BoundingBox() = default;
+        BoundingBox(const Vector3 &min, const Vector3 &max);
+
+        auto min() const -> Vector3 { return min_; }
+        auto max() const -> Vector3 { return max_; }
+        auto center() const -> Vector3 { return (min_ + max_) * 0.5f; }
+        auto extents() const -> Vector3 { return (max_ - min_) * 0.5f; }
+
+        bool isEmpty() const;
+        bool isInfinite() const;
+
+        void include(const Vector3 &point);
+        void include(const BoundingBox &box);
+
+        // Bounds of this box after transformation, which are generally larger than the box itself
+        auto transformed(const Matrix &matrix) const -> BoundingBox;
+
+    private:
+        Vector3 min_{(std::numeric_limits<float>::max)()};
+        Vector3 max_{std::numeric_limits<float>::lowest()};
+    };
+}
@@ -0,0 +1,270 @@
+/* 
+ * Copyright (c) Aleksey Fedotov 
+ * MIT license 
+ */
+
+#include "SoloBvh.h"
+#include "SoloFrustum.h"
+#include "SoloRay.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+using namespace solo;
+
+const u32 Bvh::nullProxy;
+
+// Unbounded boxes (e.g. of dynamic meshes) would turn the cost into infinities, so they simply don't contribute
+static auto surfaceArea(const BoundingBox &box) -> float
+{
+    if (box.isEmpty() || box.isInfinite())
+        return 0;
+    const auto size = box.max() - box.min();
+    return 2 * (size.x() * size.y() + size.y() * size.z() + size.z() * size.x());
+}
+
+static auto unite(const BoundingBox &a, const BoundingBox &b) -> BoundingBox
+{
+    auto result = a;
+    result.include(b);
+    return result;
+}
+
+static bool overlap(const BoundingBox &a, const BoundingBox &b)
+{
+    if (a.isEmpty() || b.isEmpty())
+        return false;
+    const auto amin = a.min(), amax = a.max(), bmin = b.min(), bmax = b.max();
+    return amin.x() <= bmax.x() && amax.x() >= bmin.x() &&
+           amin.y() <= bmax.y() && amax.y() >= bmin.y() &&
+           amin.z() <= bmax.z() && amax.z() >= bmin.z();
+}
+
+static bool overlapSphere(const BoundingBox &box, const Vector3 &center, float radius)
+{
+    if (box.isEmpty())
+        return false;
+    const auto min = box.min(), max = box.max();
+    const auto dx = (std::max)((std::max)(min.x() - center.x(), 0.0f), center.x() - max.x());
+    const auto dy = (std::max)((std::max)(min.y() - center.y(), 0.0f), center.y() - max.y());
+    const auto dz = (std::max)((std::max)(min.z() - center.z(), 0.0f), center.z() - max.z());
+    return dx * dx + dy * dy + dz * dz <= radius * radius;
+}
+
+// Slab test. Returns the entry distance, or a negative value on miss
+static auto intersectRay(const BoundingBox &box, const Vector3 &origin, const Vector3 &invDir, float maxDistance) -> float
+{
+    if (box.isEmpty())
+        return -1;
+
+    const auto min = box.min(), max = box.max();
+    const float o[] = {origin.x(), origin.y(), origin.z()};
+    const float inv[] = {invDir.x(), invDir.y(), invDir.z()};
+    const float lo[] = {min.x(), min.y(), min.z()};
+    const float hi[] = {max.x(), max.y(), max.z()};
+
+    auto tmin = 0.0f;
+    auto tmax = maxDistance;
+    for (u32 i = 0; i < 3; i++)
+    {
+        auto t1 = (lo[i] - o[i]) * inv[i];
+        auto t2 = (hi[i] - o[i]) * inv[i];
+        if (t1 > t2)
+            std::swap(t1, t2);
+        // NaNs from zero direction components times infinite slabs are ignored by these comparisons
+        tmin = t1 > tmin ? t1 : tmin;
+        tmax = t2 < tmax ? t2 : tmax;
+        if (tmin > tmax)
+            return -1;
+    }
+
+    return tmin;
+}
+
+auto Bvh::add(const BoundingBox &bounds, void *userData) -> u32
+{
+    u32 proxy;
+    if (!freeProxies_.empty())
+    {
+        proxy = freeProxies_.back();
+        freeProxies_.pop_back();
+    }
+    else
+    {
+        proxy = static_cast<u32>(proxies_.size());
+        proxies_.emplace_back();
+    }
+
+    proxies_[proxy].bounds = bounds;
+    proxies_[proxy].userData = userData;
+    proxies_[proxy].used = true;
+    dirty_ = true;
+
+    return proxy;
+}
+
+void Bvh::remove(u32 proxy)
+{
+    proxies_[proxy] = Proxy();
+    freeProxies_.push_back(proxy);
+    dirty_ = true;
+}
+
+void Bvh::update(u32 proxy, const BoundingBox &bounds)
+{
+    auto &p = proxies_[proxy];
+    p.bounds = bounds;
+    if (!dirty_ && p.node != nullProxy)
+        refit(p.node);
+}
+
+void Bvh::refit(u32 node)
+{
+    nodes_[node].bounds = proxies_[nodes_[node].proxy].bounds;
+
+    for (auto n = nodes_[node].parent; n != nullProxy; n = nodes_[n].parent)
+    {
+        auto &parent = nodes_[n];
+        const auto oldArea = surfaceArea(parent.bounds);
+        parent.bounds = unite(nodes_[parent.left].bounds, nodes_[parent.right].bounds);
+        cost_ += surfaceArea(parent.bounds) - oldArea;
+    }
+}
+
+void Bvh::flush()
+{
+    // Refitting can at most double the cost before rebuilding pays off
+    if (!dirty_ && cost_ <= 2 * builtCost_)
+        return;
+
+    nodes_.clear();
+    buildProxies_.clear();
+    for (u32 i = 0; i < proxies_.size(); i++)
+    {
+        if (proxies_[i].used)
+            buildProxies_.push_back(i);
+        else
+            proxies_[i].node = nullProxy;
+    }
+
+    cost_ = 0;
+    root_ = buildProxies_.empty() ? nullProxy : build(0, static_cast<u32>(buildProxies_.size()), nullProxy);
+    builtCost_ = cost_;
+    dirty_ = false;
+}
+
+auto Bvh::build(u32 first, u32 last, u32 parent) -> u32
+{
+    const auto index = static_cast<u32>(nodes_.size());
+    nodes_.emplace_back();
+    nodes_[index].parent = parent;
+
+    if (last - first == 1)
+    {
+        const auto proxy = buildProxies_[first];
+        nodes_[index].proxy = proxy;
+        nodes_[index].bounds = proxies_[proxy].bounds;
+        proxies_[proxy].node = index;
+        return index;
+    }
+
+    // Median split along the longest axis of box centers
+    BoundingBox centers;
+    for (auto i = first; i < last; i++)
+    {
+        const auto &bounds = proxies_[buildProxies_[i]].bounds;
+        if (!bounds.isEmpty() && !bounds.isInfinite())
+            centers.include(bounds.center());
+    }
+
+    const auto extent = centers.isEmpty() ? Vector3(0) : centers.max() - centers.min();
+    const auto axis = extent.x() >= extent.y() && extent.x() >= extent.z() ? 0 : (extent.y() >= extent.z() ? 1 : 2);
+    const auto key = [this, axis](u32 proxy)
+    {
+        const auto &bounds = proxies_[proxy].bounds;
+        if (bounds.isEmpty() || bounds.isInfinite())
+            return 0.0f;
+        const auto center = bounds.center();
+        return axis == 0 ? center.x() : (axis == 1 ? center.y() : center.z());
+    };
+
+    const auto middle = first + (last - first) / 2;
+    std::nth_element(buildProxies_.begin() + first, buildProxies_.begin() + middle, buildProxies_.begin() + last,
+        [&key](u32 a, u32 b) { return key(a) < key(b); });
+
+    const auto left = build(first, middle, index);
+    const auto right = build(middle, last, index);
+
+    auto &node = nodes_[index];
+    node.left = left;
+    node.right = right;
+    node.bounds = unite(nodes_[left].bounds, nodes_[right].bounds);
+    cost_ += surfaceArea(node.bounds);
+
+    return index;
+}
+
+template <class Overlaps, class Accept>
+void Bvh::query(Overlaps overlaps, Accept accept) const
+{
+    SL_DEBUG_PANIC(dirty_, "BVH must be flushed before querying");
+
+    if (root_ == nullProxy)
+        return;
+
+    // Median splits keep the tree balanced and refitting never changes its shape,
+    // so the depth stays well below the stack size
+    u32 stack[64];
+    u32 size = 0;
+    stack[size++] = root_;
+
+    while (size)
+    {
+        const auto &node = nodes_[stack[--size]];
+        if (!overlaps(node.bounds))
+            continue;
+
+        if (node.proxy != nullProxy)
+            accept(node.proxy);
+        else
+        {
+            stack[size++] = node.right;
+            stack[size++] = node.left;
+        }
+    }
+}
+
+void Bvh::queryBox(const BoundingBox &box, const std::function<void(void*)> &accept) const
+{
+    query([&box](const BoundingBox &bounds) { return overlap(bounds, box); },
+        [this, &accept](u32 proxy) { accept(proxies_[proxy].userData); });
+}
+
+void Bvh::querySphere(const Vector3 &center, float radius, const std::function<void(void*)> &accept) const
+{
+    query([&center, radius](const BoundingBox &bounds) { return overlapSphere(bounds, center, radius); },
+        [this, &accept](u32 proxy) { accept(proxies_[proxy].userData); });
+}
+
+void Bvh::queryFrustum(const Frustum &frustum, const std::function<void(void*)> &accept) const
+{
+    query([&frustum](const BoundingBox &bounds) { return frustum.intersects(bounds); },
+        [this, &accept](u32 proxy) { accept(proxies_[proxy].userData); });
+}
+
+void Bvh::queryRay(const Ray &ray, float maxDistance, const std::function<void(void*, float)> &accept) const
+{
+    const auto origin = ray.origin();
+    const auto dir = ray.direction();
+    const auto inverse = [](float v) { return v != 0 ? 1 / v : std::numeric_limits<float>::infinity(); };
+    const Vector3 invDir(inverse(dir.x()), inverse(dir.y()), inverse(dir.z()));
+
+    // Leaf hit distances are computed twice, which is cheaper than threading them through the traversal
+    query(
+        [&](const BoundingBox &bounds) { return intersectRay(bounds, origin, invDir, maxDistance) >= 0; },
+        [&](u32 proxy)
+        {
+            const auto &p = proxies_[proxy];
+            accept(p.userData, intersectRay(p.bounds, origin, invDir, maxDistance));
+        });
+}
@@ -0,0 +1,75 @@
+/* 
+ * Copyright (c) Aleksey Fedotov 
+ * MIT license 
+ */
+
+#pragma once
+
+#include "SoloCommon.h"
+#include "SoloBoundingBox.h"
+#include <functional>
+
+namespace solo
+{
+    class Frustum;
+    class Ray;
+
+    // Dynamic bounding volume hierarchy over boxes tagged with user pointers. Moving a box refits its ancestors
+    // in place, which is cheap but makes the tree looser over time. Adding or removing boxes, or letting the tree
+    // get too loose, schedules a full rebuild on the next flush()
+    class Bvh final: public NoCopyAndMove
+    {
+    public:
+        static const u32 nullProxy = ~0u;
+
+        auto add(const BoundingBox &bounds, void *userData) -> u32;
+        void remove(u32 proxy);
+        void update(u32 proxy, const BoundingBox &bounds);
+
+        // Rebuilds the tree if needed. Must be called before querying after any changes
+        void flush();
+
+        auto size() const -> u32 { return static_cast<u32>(proxies_.size() - freeProxies_.size()); }
+
+        void queryBox(const BoundingBox &box, const std::function<void(void*)> &accept) const;
+        void querySphere(const Vector3 &center, float radius, const std::function<void(void*)> &accept) const;
+        void queryFrustum(const Frustum &frustum, const std::function<void(void*)> &accept) const;
+        // Reports the distance along the ray to where it enters the box
+        void queryRay(const Ray &ray, float maxDistance, const std::function<void(void*, float)> &accept) const;
+
+    private:
+        struct Proxy
+        {
+            BoundingBox bounds;
+            void *userData = nullptr;
+            u32 node = nullProxy;
+            bool used = false;
+        };
+
+        struct Node
+        {
+            BoundingBox bounds;
+            u32 parent = nullProxy;
+            u32 left = nullProxy;
+            u32 right = nullProxy;
+            u32 proxy = nullProxy; // leaves only
+        };
+
+        vec<Proxy> proxies_;
+        vec<u32> freeProxies_;
+        vec<Node> nodes_;
+        vec<u32> buildProxies_;
+        u32 root_ = nullProxy;
+        bool dirty_ = false;
+
+        // Total surface area of internal nodes, which grows as refitting loosens the tree
+        float cost_ = 0;
+        float builtCost_ = 0;
+
+        auto build(u32 first, u32 last, u32 parent) -> u32;
+        void refit(u32 node);
+
+        template <class Overlaps, class Accept>
+        void query(Overlaps overlaps, Accept accept) const;
+    };
+}
@@ -11,6 +11,9 @@
 #include "SoloScene.h"
 #include "SoloRay.h"
 #include "SoloRenderer.h"
+#include "SoloBoundingBox.h"
+#include "SoloMeshRenderer.h"
+#include "SoloMesh.h"
 
 using namespace solo;
 
@@ -19,7 +22,8 @@ static const u32 ProjectionDirtyBit = 1 << 1;
 static const u32 ViewProjectionDirtyBit = 1 << 2;
 static const u32 InvViewDirtyBit = 1 << 3;
 static const u32 InvViewProjectionDirtyBit = 1 << 4;
-static const u32 AllProjectionDirtyBits = ProjectionDirtyBit | ViewProjectionDirtyBit | InvViewProjectionDirtyBit;
+static const u32 FrustumDirtyBit = 1 << 5;
+static const u32 AllProjectionDirtyBits = ProjectionDirtyBit | ViewProjectionDirtyBit | InvViewProjectionDirtyBit | FrustumDirtyBit;
 
 auto Camera::create(const Node &node) -> sptr<Camera>
 {
@@ -49,7 +53,7 @@ void Camera::update()
     if (lastTransformVersion_ != transform_->version())
     {
         lastTransformVersion_ = transform_->version();
-        dirtyFlags_ |= ViewDirtyBit | ViewProjectionDirtyBit | InvViewDirtyBit | InvViewProjectionDirtyBit;
+        dirtyFlags_ |= ViewDirtyBit | ViewProjectionDirtyBit | InvViewDirtyBit | InvViewProjectionDirtyBit | FrustumDirtyBit;
     }
 }
 
@@ -139,8 +143,64 @@ auto Camera::invViewProjectionMatrix() const -> Matrix
     return invViewProjectionMatrix_;
 }
 
+auto Camera::frustum() const -> const Frustum&
+{
+    if (dirtyFlags_ & FrustumDirtyBit)
+    {
+        frustum_ = Frustum(viewProjectionMatrix());
+        dirtyFlags_ &= ~FrustumDirtyBit;
+    }
+    return frustum_;
+}
+
+bool Camera::isVisible(const BoundingBox &worldBounds, bool occludee) const
+{
+    if (!frustum().intersects(worldBounds))
+    {
+        culledCount_++;
+        return false;
+    }
+
+    if (occludee && occlusionBuffer_ && occlusionBuffer_->isOccluded(worldBounds))
+    {
+        occludedCount_++;
+        return false;
+    }
+
+    drawnCount_++;
+    return true;
+}
+
+void Camera::setOcclusionCulling(bool enabled)
+{
+    if (!enabled)
+        occlusionBuffer_ = nullptr;
+    else if (!occlusionBuffer_)
+        occlusionBuffer_ = std::make_unique<OcclusionBuffer>(256, 128, device_->renderWorkers());
+}
+
+void Camera::prepareOcclusionBuffer()
+{
+    occlusionBuffer_->begin(viewProjectionMatrix());
+
+    for (const auto renderer: node_.scene()->queryRenderersInFrustum(frustum()))
+    {
+        const auto mesh = renderer->mesh();
+        if (renderer->isOccluder() && renderer->transform() && mesh && mesh->hasOccluderGeometry())
+            occlusionBuffer_->addOccluder(renderer->transform()->worldMatrix(), mesh->occluderPositions(), mesh->occluderIndices());
+    }
+
+    occlusionBuffer_->finish();
+}
+
 void Camera::renderFrame(const std::function<void()> &render)
 {
+    drawnCount_ = 0;
+    culledCount_ = 0;
+    occludedCount_ = 0;
+    if (occlusionBuffer_)
+        prepareOcclusionBuffer();
+
     renderer_->beginCamera(this, renderTarget_.get());
     render();
     renderer_->endCamera(this, renderTarget_.get());
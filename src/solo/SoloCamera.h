@@ -11,6 +11,8 @@
 #include "SoloTransform.h"
 #include "SoloNode.h"
 #include "SoloRadians.h"
+#include "SoloFrustum.h"
+#include "SoloOcclusionBuffer.h"
 #include <functional>
 
 namespace solo
@@ -21,6 +23,7 @@ namespace solo
     class Renderer;
     class Device;
     class Ray;
+    class BoundingBox;
     struct Radians;
 
     class Camera: public ComponentBase<Camera>
@@ -71,6 +74,19 @@ namespace solo
         auto projectionMatrix() const -> Matrix;
         auto viewProjectionMatrix() const -> Matrix;
         auto invViewProjectionMatrix() const -> Matrix;
+        auto frustum() const -> const Frustum&;
+
+        // Tests world-space bounds against the frustum and, for occludees, against occluders.
+        // Results are counted until the next renderFrame
+        bool isVisible(const BoundingBox &worldBounds, bool occludee) const;
+        auto drawnCount() const -> u32 { return drawnCount_; }
+        auto culledCount() const -> u32 { return culledCount_; }
+        auto occludedCount() const -> u32 { return occludedCount_; }
+
+        // When enabled, occluder renderers in the frustum are rasterized into a software depth buffer
+        // at the beginning of each renderFrame
+        bool hasOcclusionCulling() const { return occlusionBuffer_ != nullptr; }
+        void setOcclusionCulling(bool enabled);
 
     protected:
         Device *device_ = nullptr;
@@ -97,6 +113,15 @@ namespace solo
         mutable Matrix viewProjectionMatrix_;
         mutable Matrix invViewMatrix_;
         mutable Matrix invViewProjectionMatrix_;
+        mutable Frustum frustum_;
+
+        mutable u32 drawnCount_ = 0;
+        mutable u32 culledCount_ = 0;
+        mutable u32 occludedCount_ = 0;
+
+        uptr<OcclusionBuffer> occlusionBuffer_;
+
+        void prepareOcclusionBuffer();
 
         explicit Camera(const Node &node);
     };
@@ -0,0 +1,314 @@
+/* 
+ * Copyright (c) Aleksey Fedotov 
+ * MIT license 
+ */
+
+#include "SoloCookedMesh.h"
+#include "SoloMeshData.h"
+#include "SoloDevice.h"
+#include "SoloFileSystem.h"
+#include <cstring>
+#include <algorithm>
+
+using namespace solo;
+
+const char *const CookedMesh::extension = ".slmesh";
+
+namespace
+{
+    // All records are little-endian and padded to multiples of 8 bytes
+    struct FileHeader
+    {
+        u32 magic;
+        u32 version;
+        u32 vertexCount;
+        u32 vertexSize;
+        u32 attributeCount;
+        u32 partCount;
+        u64 vertexDataOffset;
+        float boundsMin[3];
+        float boundsMax[3];
+    };
+
+    struct AttributeRecord
+    {
+        u32 usage;
+        u32 format;
+    };
+
+    struct PartRecord
+    {
+        u64 indexDataOffset;
+        u32 indexCount;
+        u32 indexElementSize;
+        float boundsMin[3];
+        float boundsMax[3];
+    };
+}
+
+static const u32 magic = 0x484d4c53; // "SLMH"
+static const size_t blobAlignment = 16;
+
+static auto align(size_t offset) -> size_t
+{
+    return (offset + blobAlignment - 1) & ~(blobAlignment - 1);
+}
+
+static void writeBounds(const BoundingBox &bounds, float *min, float *max)
+{
+    const auto boundsMin = bounds.min();
+    const auto boundsMax = bounds.max();
+    min[0] = boundsMin.x();
+    min[1] = boundsMin.y();
+    min[2] = boundsMin.z();
+    max[0] = boundsMax.x();
+    max[1] = boundsMax.y();
+    max[2] = boundsMax.z();
+}
+
+static auto readBounds(const float *min, const float *max) -> BoundingBox
+{
+    return BoundingBox(Vector3(min[0], min[1], min[2]), Vector3(max[0], max[1], max[2]));
+}
+
+// Offsets and counts come from the file, so they are checked in all builds and without overflowing
+static bool fitsIn(size_t size, u64 offset, u64 elementSize, u64 count)
+{
+    return offset <= size && (!elementSize || count <= (size - offset) / elementSize);
+}
+
+template <class T>
+static bool readRecord(const u8 *data, size_t size, u64 offset, T &record)
+{
+    if (!fitsIn(size, offset, sizeof(T), 1))
+        return false;
+    memcpy(&record, data + offset, sizeof(T));
+    return true;
+}
+
+template <class T>
+static bool indicesInRange(const T *indices, u32 count, u32 vertexCount)
+{
+    return std::all_of(indices, indices + count, [=](T index) { return index < vertexCount; });
+}
+
+static bool invalid(const str &reason)
+{
+    Logger::global().logError(SL_FMT("Invalid cooked mesh: ", reason));
+    return false;
+}
+
+bool CookedMesh::isCookedPath(const str &path)
+{
+    const auto extensionLength = strlen(extension);
+    return path.size() >= extensionLength && !path.compare(path.size() - extensionLength, extensionLength, extension);
+}
+
+auto CookedMesh::findCooked(FileSystem *fs, const str &path) -> str
+{
+    if (isCookedPath(path))
+        return path;
+
+    const auto siblingPath = path + extension;
+    if (!fs->exists(siblingPath))
+        return str();
+
+    if (fs->lastWriteTime(siblingPath) < fs->lastWriteTime(path))
+    {
+        SL_DEBUG_LOG("Ignoring ", siblingPath, " older than its source");
+        return str();
+    }
+
+    return siblingPath;
+}
+
+bool CookedMesh::hasLayout(const VertexBufferLayout &layout) const
+{
+    if (layout.attributeCount() != layout_.attributeCount())
+        return false;
+
+    for (u32 i = 0; i < layout.attributeCount(); i++)
+    {
+        const auto attr = layout.attribute(i);
+        const auto cookedAttr = layout_.attribute(i);
+        if (attr.usage != cookedAttr.usage || attr.format != cookedAttr.format)
+            return false;
+    }
+
+    return true;
+}
+
+bool CookedMesh::providesLayout(const VertexBufferLayout &layout) const
+{
+    for (u32 i = 0; i < layout.attributeCount(); i++)
+    {
+        const auto attr = layout.attribute(i);
+        auto found = false;
+        for (u32 j = 0; j < layout_.attributeCount() && !found; j++)
+            found = layout_.attribute(j).usage == attr.usage && layout_.attribute(j).format == attr.format;
+        if (!found)
+            return false;
+    }
+
+    return true;
+}
+
+auto CookedMesh::fromFile(Device *device, const str &path) -> sptr<CookedMesh>
+{
+    return fromMapping(device->fileSystem()->map(path));
+}
+
+auto CookedMesh::fromBytes(vec<u8> bytes) -> sptr<CookedMesh>
+{
+    auto result = sptr<CookedMesh>(new CookedMesh());
+    result->bytes_ = std::move(bytes);
+    result->data_ = result->bytes_.data();
+    result->size_ = result->bytes_.size();
+    return result->parse() ? result : nullptr;
+}
+
+auto CookedMesh::fromMapping(sptr<FileMapping> mapping) -> sptr<CookedMesh>
+{
+    auto result = sptr<CookedMesh>(new CookedMesh());
+    result->mapping_ = mapping;
+    result->data_ = mapping->data();
+    result->size_ = mapping->size();
+    return result->parse() ? result : nullptr;
+}
+
+bool CookedMesh::parse()
+{
+    FileHeader header;
+    if (!readRecord(data_, size_, 0, header) || header.magic != magic)
+        return invalid("not a cooked mesh");
+    if (header.version != version)
+        return invalid(SL_FMT("unsupported version ", header.version));
+
+    auto offset = static_cast<u64>(sizeof(FileHeader));
+    for (u32 i = 0; i < header.attributeCount; i++, offset += sizeof(AttributeRecord))
+    {
+        AttributeRecord attr;
+        if (!readRecord(data_, size_, offset, attr))
+            return invalid("truncated attributes");
+        if (attr.usage < static_cast<u32>(VertexAttributeUsage::Position) ||
+            attr.usage > static_cast<u32>(VertexAttributeUsage::Color) ||
+            attr.format > static_cast<u32>(VertexAttributeFormat::SNorm10_10_10_2))
+            return invalid("unknown vertex attribute");
+        layout_.addAttribute(static_cast<VertexAttributeUsage>(attr.usage), static_cast<VertexAttributeFormat>(attr.format));
+    }
+
+    if (layout_.size() != header.vertexSize)
+        return invalid("vertex layout mismatch");
+    if (!fitsIn(size_, header.vertexDataOffset, header.vertexSize, header.vertexCount))
+        return invalid("truncated vertex data");
+
+    for (u32 i = 0; i < header.partCount; i++, offset += sizeof(PartRecord))
+    {
+        PartRecord record;
+        if (!readRecord(data_, size_, offset, record))
+            return invalid("truncated parts");
+        if (record.indexElementSize != 2 && record.indexElementSize != 4)
+            return invalid("unsupported index size");
+        if (record.indexDataOffset % record.indexElementSize ||
+            !fitsIn(size_, record.indexDataOffset, record.indexElementSize, record.indexCount))
+            return invalid("truncated index data");
+
+        // Out of range indices would make the GPU read past the vertex buffer
+        const auto indices = data_ + record.indexDataOffset;
+        const auto outOfRange = record.indexElementSize == 2
+            ? !indicesInRange(reinterpret_cast<const u16*>(indices), record.indexCount, header.vertexCount)
+            : !indicesInRange(reinterpret_cast<const u32*>(indices), record.indexCount, header.vertexCount);
+        if (outOfRange)
+            return invalid("index out of range");
+
+        parts_.push_back(Part{
+            static_cast<size_t>(record.indexDataOffset),
+            record.indexCount,
+            record.indexElementSize == 2 ? IndexElementSize::Bits16 : IndexElementSize::Bits32,
+            readBounds(record.boundsMin, record.boundsMax)
+        });
+    }
+
+    vertexCount_ = header.vertexCount;
+    vertexDataOffset_ = static_cast<size_t>(header.vertexDataOffset);
+    bounds_ = readBounds(header.boundsMin, header.boundsMax);
+
+    return true;
+}
+
+bool CookedMesh::cookFile(FileSystem *fs, const str &sourcePath, const str &cookedPath, const VertexBufferLayout &bufferLayout)
+{
+    const auto data = MeshData::fromFile(fs, sourcePath, bufferLayout);
+    if (!data)
+        return false;
+
+    // Replaced atomically so an interrupted cook never leaves a partial file newer than its source
+    fs->replaceBytes(cookedPath, cook(*data));
+    return true;
+}
+
+auto CookedMesh::cook(const MeshData &data) -> vec<u8>
+{
+    const auto &layout = data.layout();
+    const auto &indexData = data.indexData();
+    const auto partCount = static_cast<u32>(indexData.size());
+
+    BoundingBox bounds;
+    for (const auto &partBounds: data.partBounds())
+        bounds.include(partBounds);
+
+    // Header and tables first, then the vertex blob followed by index blobs
+    FileHeader header{magic, version, data.vertexCount(), layout.size(), layout.attributeCount(), partCount, 0, {}, {}};
+    writeBounds(bounds, header.boundsMin, header.boundsMax);
+
+    auto offset = sizeof(FileHeader) + layout.attributeCount() * sizeof(AttributeRecord) + partCount * sizeof(PartRecord);
+    header.vertexDataOffset = align(offset);
+    offset = static_cast<size_t>(header.vertexDataOffset) + static_cast<size_t>(layout.size()) * data.vertexCount();
+
+    vec<PartRecord> parts;
+    for (u32 i = 0; i < partCount; i++)
+    {
+        const auto elementSize = data.partIndexElementSize(i);
+        PartRecord record{align(offset), static_cast<u32>(indexData[i].size()), Mesh::indexElementSizeInBytes(elementSize), {}, {}};
+        if (i < data.partBounds().size())
+            writeBounds(data.partBounds()[i], record.boundsMin, record.boundsMax);
+        offset = static_cast<size_t>(record.indexDataOffset) + record.indexElementSize * record.indexCount;
+        parts.push_back(record);
+    }
+
+    vec<u8> bytes(offset, 0);
+    memcpy(bytes.data(), &header, sizeof(header));
+
+    auto recordOffset = sizeof(FileHeader);
+    for (u32 i = 0; i < layout.attributeCount(); i++, recordOffset += sizeof(AttributeRecord))
+    {
+        const auto attr = layout.attribute(i);
+        const AttributeRecord record{static_cast<u32>(attr.usage), static_cast<u32>(attr.format)};
+        memcpy(bytes.data() + recordOffset, &record, sizeof(record));
+    }
+
+    for (const auto &record: parts)
+    {
+        memcpy(bytes.data() + recordOffset, &record, sizeof(record));
+        recordOffset += sizeof(record);
+    }
+
+    const auto vertexData = data.packedVertexData();
+    if (!vertexData.empty())
+        memcpy(bytes.data() + header.vertexDataOffset, vertexData.data(), vertexData.size());
+
+    for (u32 i = 0; i < partCount; i++)
+    {
+        const auto &part = indexData[i];
+        const auto dst = bytes.data() + parts[i].indexDataOffset;
+        if (data.partIndexElementSize(i) == IndexElementSize::Bits16)
+        {
+            const auto narrowed = Mesh::narrowIndices(part.data(), static_cast<u32>(part.size()));
+            memcpy(dst, narrowed.data(), narrowed.size() * sizeof(u16));
+        }
+        else if (!part.empty())
+            memcpy(dst, part.data(), part.size() * sizeof(u32));
+    }
+
+    return bytes;
+}
@@ -0,0 +1,87 @@
+/* 
+ * Copyright (c) Aleksey Fedotov 
+ * MIT license 
+ */
+
+#pragma once
+
+#include "SoloCommon.h"
+#include "SoloBoundingBox.h"
+#include "SoloVertexBufferLayout.h"
+#include "SoloMesh.h"
+
+namespace solo
+{
+    class Device;
+    class FileSystem;
+    class FileMapping;
+    class MeshData;
+
+    // Binary mesh container produced by cooking. Vertices and indices are stored in their GPU formats at aligned
+    // offsets after a small header, so loading validates the header and hands blobs to uploads without parsing.
+    // The vertex layout is fixed at cooking time
+    class CookedMesh final: public NoCopyAndMove
+    {
+    public:
+        static const u32 version = 1;
+        static const char *const extension; // ".slmesh"
+
+        static bool isCookedPath(const str &path);
+        // Returns the path itself when it is cooked, the cooked sibling ("<path>.slmesh") when one exists
+        // and is not older than the source, otherwise an empty string
+        static auto findCooked(FileSystem *fs, const str &path) -> str;
+
+        // Loading validates every offset, count and index against the data, also in release builds, and returns
+        // nullptr for data that isn't a valid cooked mesh of the current version, e.g. one left half-written
+        static auto fromFile(Device *device, const str &path) -> sptr<CookedMesh>;
+        // Takes ownership of the bytes
+        static auto fromBytes(vec<u8> bytes) -> sptr<CookedMesh>;
+        // Keeps the mapping alive and reads vertices and indices straight from it
+        static auto fromMapping(sptr<FileMapping> mapping) -> sptr<CookedMesh>;
+
+        static auto cook(const MeshData &data) -> vec<u8>;
+        // Imports a source file in the given layout and writes it cooked, returns false when the import fails.
+        // Needs no device so it can run in tools
+        static bool cookFile(FileSystem *fs, const str &sourcePath, const str &cookedPath, const VertexBufferLayout &bufferLayout);
+
+        auto layout() const -> const VertexBufferLayout& { return layout_; }
+        // Whether the vertices are stored exactly in the layout, so they can be uploaded as they are
+        bool hasLayout(const VertexBufferLayout &layout) const;
+        // Whether every attribute of the layout is stored in the same format, so it can be unpacked without loss
+        bool providesLayout(const VertexBufferLayout &layout) const;
+        auto bounds() const -> const BoundingBox& { return bounds_; }
+
+        auto vertexCount() const -> u32 { return vertexCount_; }
+        auto vertexData() const -> const void* { return data_ + vertexDataOffset_; }
+
+        auto partCount() const -> u32 { return static_cast<u32>(parts_.size()); }
+        auto partIndexData(u32 part) const -> const void* { return data_ + parts_.at(part).indexDataOffset; }
+        auto partIndexCount(u32 part) const -> u32 { return parts_.at(part).indexCount; }
+        auto partIndexElementSize(u32 part) const -> IndexElementSize { return parts_.at(part).indexElementSize; }
+        auto partBounds(u32 part) const -> const BoundingBox& { return parts_.at(part).bounds; }
+
+    private:
+        struct Part
+        {
+            size_t indexDataOffset;
+            u32 indexCount;
+            IndexElementSize indexElementSize;
+            BoundingBox bounds;
+        };
+
+        // Either owned bytes or a file mapping back the data
+        vec<u8> bytes_;
+        sptr<FileMapping> mapping_;
+        const u8 *data_ = nullptr;
+        size_t size_ = 0;
+        VertexBufferLayout layout_;
+        BoundingBox bounds_;
+        u32 vertexCount_ = 0;
+        size_t vertexDataOffset_ = 0;
+        vec<Part> parts_;
+
+        CookedMesh() = default;
+
+        bool parse();
+    };
+}
@@ -0,0 +1,148 @@
+/* 
+ * Copyright (c) Aleksey Fedotov 
+ * MIT license 
+ */
+
+#include "SoloCookedTexture.h"
+#include "SoloTextureData.h"
+#include "SoloDevice.h"
+#include "SoloFileSystem.h"
+#include "stb/SoloSTBTextureData.h"
+#include <cstring>
+
+using namespace solo;
+
+const char *const CookedTexture::extension = ".sltex";
+
+namespace
+{
+    struct FileHeader
+    {
+        u32 magic;
+        u32 version;
+        u32 width;
+        u32 height;
+        u32 format;
+        u32 padding;
+    };
+
+    const u32 magic = 0x58544c53; // "SLTX"
+}
+
+static auto channelCount(TextureDataFormat format) -> u32
+{
+    switch (format)
+    {
+        case TextureDataFormat::Red: return 1;
+        case TextureDataFormat::RGB: return 3;
+        case TextureDataFormat::RGBA: return 4;
+        default:
+            break;
+    }
+
+    SL_DEBUG_PANIC(true, "Unsupported texture data format");
+    return 4;
+}
+
+static auto invalid(const str &path, const str &reason) -> sptr<Texture2DData>
+{
+    Logger::global().logError(SL_FMT("Invalid cooked texture ", path, ": ", reason));
+    return nullptr;
+}
+
+bool CookedTexture::isCookedPath(const str &path)
+{
+    const auto extensionLength = strlen(extension);
+    return path.size() >= extensionLength && !path.compare(path.size() - extensionLength, extensionLength, extension);
+}
+
+auto CookedTexture::findCooked(FileSystem *fs, const str &path) -> str
+{
+    if (isCookedPath(path))
+        return path;
+
+    const auto siblingPath = path + extension;
+    if (!fs->exists(siblingPath))
+        return str();
+
+    if (fs->lastWriteTime(siblingPath) < fs->lastWriteTime(path))
+    {
+        SL_DEBUG_LOG("Ignoring ", siblingPath, " older than its source");
+        return str();
+    }
+
+    return siblingPath;
+}
+
+auto CookedTexture::fromFile(Device *device, const str &path) -> sptr<Texture2DData>
+{
+    const auto mapping = device->fileSystem()->map(path);
+
+    // The header comes from the file, so it is checked in all builds and without overflowing
+    FileHeader header;
+    if (mapping->size() < sizeof(FileHeader))
+        return invalid(path, "not a cooked texture");
+    memcpy(&header, mapping->data(), sizeof(FileHeader));
+    if (header.magic != magic)
+        return invalid(path, "not a cooked texture");
+    if (header.version != version)
+        return invalid(path, SL_FMT("unsupported version ", header.version));
+    if (header.format > static_cast<u32>(TextureDataFormat::RGBA))
+        return invalid(path, SL_FMT("unknown format ", header.format));
+    if (!header.width || !header.height)
+        return invalid(path, "empty image");
+
+    const auto format = static_cast<TextureDataFormat>(header.format);
+    const auto rowSize = static_cast<u64>(header.width) * channelCount(format);
+    const auto available = static_cast<u64>(mapping->size() - sizeof(FileHeader));
+    if (rowSize > available || header.height > available / rowSize)
+        return invalid(path, "truncated pixel data");
+    const auto size = static_cast<size_t>(rowSize * header.height);
+
+    const auto pixels = mapping->data() + sizeof(FileHeader);
+    if (device->mode() != DeviceMode::OpenGL)
+        return Texture2DData::fromMemory(header.width, header.height, format, vec<u8>(pixels, pixels + size));
+
+    // OpenGL expects the bottom row first
+    vec<u8> flipped(size);
+    for (u32 row = 0; row < header.height; row++)
+    {
+        memcpy(flipped.data() + static_cast<size_t>(rowSize) * row,
+            pixels + static_cast<size_t>(rowSize) * (header.height - row - 1), static_cast<size_t>(rowSize));
+    }
+
+    return Texture2DData::fromMemory(header.width, header.height, format, flipped);
+}
+
+auto CookedTexture::cook(const Texture2DData &data) -> vec<u8>
+{
+    const auto dimensions = data.dimensions();
+
+    FileHeader header{};
+    header.magic = magic;
+    header.version = version;
+    header.width = static_cast<u32>(dimensions.x());
+    header.height = static_cast<u32>(dimensions.y());
+    header.format = static_cast<u32>(data.format());
+
+    const auto size = static_cast<size_t>(header.width) * header.height * channelCount(data.format());
+    SL_DEBUG_PANIC(size != data.size(), "Texture data size does not match its dimensions");
+
+    vec<u8> result(sizeof(FileHeader) + size);
+    memcpy(result.data(), &header, sizeof(FileHeader));
+    memcpy(result.data() + sizeof(FileHeader), data.data(), size);
+
+    return result;
+}
+
+bool CookedTexture::cookFile(FileSystem *fs, const str &sourcePath, const str &cookedPath)
+{
+    const auto mapping = fs->map(sourcePath);
+    const auto data = STBTexture2DData::fromBytes(mapping->data(), mapping->size(), false);
+    if (!data)
+        return false;
+
+    // Replaced atomically so an interrupted cook never leaves a partial file newer than its source
+    fs->replaceBytes(cookedPath, cook(*data));
+    return true;
+}
@@ -0,0 +1,40 @@
+/* 
+ * Copyright (c) Aleksey Fedotov 
+ * MIT license 
+ */
+
+#pragma once
+
+#include "SoloCommon.h"
+
+namespace solo
+{
+    class Device;
+    class FileSystem;
+    class Texture2DData;
+
+    // Decoded 2D texture pixels behind a small header, so loading skips image decompression.
+    // Rows are stored top to bottom and flipped on load when the device needs it
+    class CookedTexture final
+    {
+    public:
+        static const u32 version = 1;
+        static const char *const extension; // ".sltex"
+
+        static bool isCookedPath(const str &path);
+        // Returns the path itself when it is cooked, the cooked sibling ("<path>.sltex") when one exists
+        // and is not older than the source, otherwise an empty string
+        static auto findCooked(FileSystem *fs, const str &path) -> str;
+
+        // Returns nullptr and logs the reason when the file is not a valid cooked texture
+        static auto fromFile(Device *device, const str &path) -> sptr<Texture2DData>;
+
+        static auto cook(const Texture2DData &data) -> vec<u8>;
+        // Decodes a source image and writes it cooked, returns false when the source can't be decoded.
+        // Needs no device so it can run in tools
+        static bool cookFile(FileSystem *fs, const str &sourcePath, const str &cookedPath);
+
+    private:
+        CookedTexture() = delete;
+    };
+}
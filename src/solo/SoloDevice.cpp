@@ -9,6 +9,7 @@
 #include "SoloPhysics.h"
 #include "SoloScriptRuntime.h"
 #include "SoloJobPool.h"
+#include "SoloWorkerPool.h"
 #include "gl/SoloOpenGLSDLDevice.h"
 #include "vk/SoloVulkanSDLDevice.h"
 
@@ -43,7 +44,9 @@ auto Device::create(const DeviceSetup &setup) -> uptr<Device>
 
 Device::Device(const DeviceSetup &setup):
     mode_(setup.mode),
-    vsync_(setup.vsync)
+    vsync_(setup.vsync),
+    renderThreadCount_(setup.renderThreadCount),
+    shaderCacheDirectory_(setup.shaderCacheDirectory)
 {
 }
 
@@ -52,6 +55,7 @@ void Device::initSubsystems(const DeviceSetup &setup)
     if (!setup.logFilePath.empty())
         Logger::global().setOutputFile(setup.logFilePath);
 
+    renderWorkers_ = std::make_shared<WorkerPool>(renderThreadCount_);
     renderer_ = Renderer::fromDevice(this);
     physics_ = Physics::fromDevice(this);
     fs_ = FileSystem::fromDevice(this);
@@ -66,6 +70,7 @@ void Device::cleanupSubsystems()
     scriptRuntime_.reset();
     fs_.reset();
     renderer_.reset();
+    renderWorkers_.reset();
 }
 
 bool Device::hasActiveBackgroundJobs() const
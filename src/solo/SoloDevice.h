@@ -18,6 +18,7 @@ namespace solo
     class Physics;
     class ScriptRuntime;
     class JobPool;
+    class WorkerPool;
 
     enum class KeyCode
     {
@@ -100,12 +101,16 @@ namespace solo
 
         auto mode() const -> DeviceMode { return mode_; }
         bool isVsync() const { return vsync_; }
+        auto renderThreadCount() const -> u32 { return renderThreadCount_; }
+        auto shaderCacheDirectory() const -> str { return shaderCacheDirectory_; }
 
         auto fileSystem() const -> FileSystem* { return fs_.get(); }
         auto renderer() const -> Renderer* { return renderer_.get(); }
         auto physics() const -> Physics* { return physics_.get(); }
         auto scriptRuntime() const -> ScriptRuntime* { return scriptRuntime_.get(); }
         auto jobPool() const -> JobPool* { return jobPool_.get(); }
+        // renderThreadCount workers for splitting frame work, e.g. recording draw calls
+        auto renderWorkers() const -> WorkerPool* { return renderWorkers_.get(); }
 
     protected:
         sptr<Renderer> renderer_;
@@ -113,9 +118,12 @@ namespace solo
         sptr<FileSystem> fs_;
         sptr<ScriptRuntime> scriptRuntime_;
         sptr<JobPool> jobPool_;
+        sptr<WorkerPool> renderWorkers_;
 
         DeviceMode mode_;
         bool vsync_;
+        u32 renderThreadCount_;
+        str shaderCacheDirectory_;
 
         // key code -> was pressed for the first time
         umap<KeyCode, bool> pressedKeys_;
@@ -22,6 +22,12 @@ namespace solo
         
         bool fullScreen = false;
         bool vsync = false;
+
+        // Vulkan only: number of threads recording draw commands, 1 means recording on the main thread
+        u32 renderThreadCount = 1;
+
+        // Compiled shaders (SPIR-V, GL program binaries) are cached in this existing directory, disabled when empty
+        str shaderCacheDirectory = "";
         
         str windowTitle;
         str logFilePath = "";
@@ -7,11 +7,42 @@
 #include "SoloDevice.h"
 #include "SoloFileSystem.h"
 #include "SoloScriptRuntime.h"
+#include "SoloJobPool.h"
 #include "gl/SoloOpenGLEffect.h"
 #include "vk/SoloVulkanEffect.h"
+#include <cstring>
 
 using namespace solo;
 
+constexpr const char *Effect::instanceWorldAttributeName;
+
+static auto splitSource(const str &source) -> std::pair<str, str>
+{
+    const auto vertTagStartIdx = source.find("// VERTEX");
+    SL_DEBUG_PANIC(vertTagStartIdx == std::string::npos, "Vertex shader not found in ", source);
+
+    const auto fragTagStartIdx = source.find("// FRAGMENT");
+    SL_DEBUG_PANIC(vertTagStartIdx == std::string::npos, "Fragment shader not found in ", source);
+
+    const auto vertShaderStartIdx = vertTagStartIdx + std::strlen("// VERTEX");
+    const auto vertShaderEndIdx = fragTagStartIdx > vertTagStartIdx ? fragTagStartIdx - 1 : source.size() - 1;
+
+    const auto fragShaderStartIdx = fragTagStartIdx + std::strlen("// FRAGMENT");
+    const auto fragShaderEndIdx = vertTagStartIdx > fragTagStartIdx ? vertTagStartIdx - 1 : source.size() - 1;
+
+    return {
+        source.substr(vertShaderStartIdx, vertShaderEndIdx - vertShaderStartIdx + 1),
+        source.substr(fragShaderStartIdx, fragShaderEndIdx - fragShaderStartIdx + 1)
+    };
+}
+
+static auto generateSource(Device *device, const str &description) -> str
+{
+    // This doesn't seem to restrict us to Lua scripting only. It seems quite possible to 
+    // provide the same script method in other possible scripting languages in the future.
+    return device->scriptRuntime()->eval("sl.generateEffectSource(" + description + ")");
+}
+
 auto Effect::fromSourceFile(Device *device, const str &path) -> sptr<Effect>
 {
     const auto source = device->fileSystem()->readText(path);
@@ -24,41 +55,82 @@ auto Effect::fromDescriptionFile(Device* device, const str& path) -> sptr<Effect
     return fromDescription(device, desc);
 }
 
-auto Effect::fromDescription(Device* device, const str& description) -> sptr<Effect>
+auto Effect::fromDescriptionFileAsync(Device *device, const str &path) -> sptr<AsyncHandle<Effect>>
 {
-    // This doesn't seem to restrict us to Lua scripting only. It seems quite possible to 
-    // provide the same script method in other possible scripting languages in the future.
-    const auto source = device->scriptRuntime()->eval("sl.generateEffectSource(" + description + ")");
-    return fromSource(device, source);
-}
+    auto handle = std::make_shared<AsyncHandle<Effect>>();
 
-auto Effect::fromSource(Device* device, const str& source) -> sptr<Effect>
-{
-    const auto vertTagStartIdx = source.find("// VERTEX");
-    SL_DEBUG_PANIC(vertTagStartIdx == std::string::npos, "Vertex shader not found in ", source);
+    // Script runtime is not thread-safe, so the source is generated right away
+    const auto source = generateSource(device, device->fileSystem()->readText(path));
 
-    const auto fragTagStartIdx = source.find("// FRAGMENT");
-    SL_DEBUG_PANIC(vertTagStartIdx == std::string::npos, "Fragment shader not found in ", source);
+    switch (device->mode())
+    {
+#ifdef SL_OPENGL_RENDERER
+        case DeviceMode::OpenGL:
+        {
+            // GL compiles and links only on the thread owning the context, so there's nothing to offload
+            auto producers = JobBase<str>::Producers{[=]() { return std::make_shared<str>(source); }};
+            auto consumer = [handle, device](const vec<sptr<str>> &results)
+            {
+                handle->resolve(fromSource(device, *results[0]));
+            };
+            device->jobPool()->addJob(std::make_shared<JobBase<str>>(producers, consumer));
+            break;
+        }
+#endif
+#ifdef SL_VULKAN_RENDERER
+        case DeviceMode::Vulkan:
+        {
+            // Compilation and reflection run on a worker, only shader modules are created on the main thread
+            const auto sources = splitSource(source);
+            using Compiled = VulkanEffect::CompiledSources;
+            auto producers = JobBase<Compiled>::Producers{[=]()
+            {
+                return VulkanEffect::compileSources(device,
+                    sources.first.c_str(), static_cast<u32>(sources.first.size()),
+                    sources.second.c_str(), static_cast<u32>(sources.second.size()));
+            }};
+            auto consumer = [handle, device](const vec<sptr<Compiled>> &results)
+            {
+                handle->resolve(VulkanEffect::fromCompiledSources(device, *results[0]));
+            };
+            device->jobPool()->addJob(std::make_shared<JobBase<Compiled>>(producers, consumer));
+            break;
+        }
+#endif
+        default:
+            SL_DEBUG_PANIC(true, "Unknown device mode");
+            break;
+    }
 
-    const auto vertShaderStartIdx = vertTagStartIdx + std::strlen("// VERTEX");
-    const auto vertShaderEndIdx = fragTagStartIdx > vertTagStartIdx ? fragTagStartIdx - 1 : source.size() - 1;
-    const auto vsBytes = source.c_str() + vertShaderStartIdx;
-    const auto vsSize = vertShaderEndIdx - vertShaderStartIdx + 1;
+    return handle;
+}
 
-    const auto fragShaderStartIdx = fragTagStartIdx + std::strlen("// FRAGMENT");
-    const auto fragShaderEndIdx = vertTagStartIdx > fragTagStartIdx ? vertTagStartIdx - 1 : source.size() - 1;
-    const auto fsBytes = source.c_str() + fragShaderStartIdx;
-    const auto fsSize = fragShaderEndIdx - fragShaderStartIdx + 1;
+auto Effect::fromDescription(Device* device, const str& description) -> sptr<Effect>
+{
+    return fromSource(device, generateSource(device, description));
+}
 
+auto Effect::fromSource(Device* device, const str& source) -> sptr<Effect>
+{
     switch (device->mode())
     {
 #ifdef SL_OPENGL_RENDERER
         case DeviceMode::OpenGL:
-            return std::make_shared<OpenGLEffect>(vsBytes, vsSize, fsBytes, fsSize);
+        {
+            const auto sources = splitSource(source);
+            return std::make_shared<OpenGLEffect>(device,
+                sources.first.c_str(), static_cast<u32>(sources.first.size()),
+                sources.second.c_str(), static_cast<u32>(sources.second.size()));
+        }
 #endif
 #ifdef SL_VULKAN_RENDERER
         case DeviceMode::Vulkan:
-            return VulkanEffect::fromSources(device, vsBytes, vsSize, fsBytes, fsSize);
+        {
+            const auto sources = splitSource(source);
+            return VulkanEffect::fromSources(device,
+                sources.first.c_str(), static_cast<u32>(sources.first.size()),
+                sources.second.c_str(), static_cast<u32>(sources.second.size()));
+        }
 #endif
         default:
             SL_DEBUG_PANIC(true, "Unknown device mode");
@@ -6,6 +6,7 @@
 #pragma once
 
 #include "SoloCommon.h"
+#include "SoloAsyncHandle.h"
 
 namespace solo
 {
@@ -16,12 +17,21 @@ namespace solo
     public:
         static auto fromSourceFile(Device *device, const str &path) -> sptr<Effect>;
         static auto fromDescriptionFile(Device *device, const str &path) -> sptr<Effect>;
+        static auto fromDescriptionFileAsync(Device *device, const str &path) -> sptr<AsyncHandle<Effect>>;
         static auto fromSource(Device *device, const str &source) -> sptr<Effect>;
         static auto fromDescription(Device *device, const str &description) -> sptr<Effect>;
 
+        // Name of the mat4 vertex input carrying per-instance world matrices. Effects declaring it
+        // are drawn instanced, with one world matrix per instance in a separate vertex buffer
+        static constexpr const char *instanceWorldAttributeName = "sl_InstanceWorld";
+
         virtual ~Effect() = default;
 
+        bool isInstanced() const { return instanced_; }
+
     protected:
+        bool instanced_ = false;
+
         Effect() = default;
     };
 }
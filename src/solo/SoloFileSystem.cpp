@@ -6,6 +6,82 @@
 #include "SoloFileSystem.h"
 #include "SoloDevice.h"
 #include <fstream>
+#include <atomic>
+#include <cstdio>
+
+#ifdef SL_WINDOWS
+#   include <windows.h>
+#else
+#   include <fcntl.h>
+#   include <sys/mman.h>
+#   include <sys/stat.h>
+#   include <unistd.h>
+#endif
+
+namespace solo
+{
+    class OSFileMapping final: public FileMapping
+    {
+    public:
+        // Empty files have nothing to map and give an empty view
+        explicit OSFileMapping(const str &path)
+        {
+#ifdef SL_WINDOWS
+            const auto file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+            SL_DEBUG_PANIC(file == INVALID_HANDLE_VALUE, "Unable to open file ", path);
+            if (file == INVALID_HANDLE_VALUE)
+                return;
+
+            LARGE_INTEGER size;
+            if (GetFileSizeEx(file, &size) && size.QuadPart > 0)
+            {
+                // The view keeps the mapping alive, so both handles can be closed right away
+                const auto mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+                if (mapping)
+                {
+                    data_ = static_cast<const u8*>(MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
+                    size_ = data_ ? static_cast<size_t>(size.QuadPart) : 0;
+                    CloseHandle(mapping);
+                }
+                SL_DEBUG_PANIC(!data_, "Unable to map file ", path);
+            }
+
+            CloseHandle(file);
+#else
+            const auto file = open(path.c_str(), O_RDONLY);
+            SL_DEBUG_PANIC(file < 0, "Unable to open file ", path);
+            if (file < 0)
+                return;
+
+            struct stat info;
+            if (!fstat(file, &info) && info.st_size > 0)
+            {
+                // The mapping outlives the descriptor
+                const auto mapped = mmap(nullptr, info.st_size, PROT_READ, MAP_PRIVATE, file, 0);
+                SL_DEBUG_PANIC(mapped == MAP_FAILED, "Unable to map file ", path);
+                if (mapped != MAP_FAILED)
+                {
+                    data_ = static_cast<const u8*>(mapped);
+                    size_ = static_cast<size_t>(info.st_size);
+                }
+            }
+
+            close(file);
+#endif
+        }
+
+        ~OSFileMapping()
+        {
+            if (!data_)
+                return;
+#ifdef SL_WINDOWS
+            UnmapViewOfFile(data_);
+#else
+            munmap(const_cast<u8*>(data_), size_);
+#endif
+        }
+    };
+}
 
 using namespace solo;
 
@@ -16,11 +92,36 @@ auto FileSystem::fromDevice(Device *device) -> sptr<FileSystem>
 
 auto FileSystem::stream(const str &path) -> sptr<std::istream>
 {
-    std::ifstream file{path};
+    std::ifstream file{path, std::ios::binary};
     SL_DEBUG_PANIC(!file.is_open(), "Unable to open read stream for file ", path);
     return std::make_shared<std::ifstream>(std::move(file));
 }
 
+auto FileSystem::map(const str &path) -> sptr<FileMapping>
+{
+    return std::make_shared<OSFileMapping>(path);
+}
+
+bool FileSystem::exists(const str &path)
+{
+    return std::ifstream{path}.good();
+}
+
+auto FileSystem::lastWriteTime(const str &path) -> u64
+{
+#ifdef SL_WINDOWS
+    WIN32_FILE_ATTRIBUTE_DATA info;
+    if (!GetFileAttributesExA(path.c_str(), GetFileExInfoStandard, &info))
+        return 0;
+    return (static_cast<u64>(info.ftLastWriteTime.dwHighDateTime) << 32) | info.ftLastWriteTime.dwLowDateTime;
+#else
+    struct stat info;
+    if (stat(path.c_str(), &info))
+        return 0;
+    return static_cast<u64>(info.st_mtime);
+#endif
+}
+
 auto FileSystem::readBytes(const str &path) -> vec<u8>
 {
     std::ifstream file(path, std::ios::binary | std::ios::ate);
@@ -43,6 +144,31 @@ void FileSystem::writeBytes(const str &path, const vec<u8> &data)
     file.close();
 }
 
+void FileSystem::replaceBytes(const str &path, const vec<u8> &data)
+{
+    static std::atomic<u32> tempCounter{0};
+#ifdef SL_WINDOWS
+    const auto processId = static_cast<u32>(GetCurrentProcessId());
+#else
+    const auto processId = static_cast<u32>(getpid());
+#endif
+    const str tempPath = SL_FMT(path, ".", processId, ".", tempCounter++, ".tmp");
+
+    std::ofstream file(tempPath, std::ios::binary | std::ios::trunc);
+    if (!file.is_open())
+        return;
+    file.write(reinterpret_cast<const s8*>(data.data()), data.size());
+    file.close();
+
+#ifdef SL_WINDOWS
+    const auto replaced = file.good() && MoveFileExA(tempPath.c_str(), path.c_str(), MOVEFILE_REPLACE_EXISTING);
+#else
+    const auto replaced = file.good() && !std::rename(tempPath.c_str(), path.c_str());
+#endif
+    if (!replaced)
+        std::remove(tempPath.c_str());
+}
+
 auto FileSystem::readText(const str &path) -> str
 {
     std::ifstream f(path);
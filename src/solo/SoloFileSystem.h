@@ -12,6 +12,22 @@ namespace solo
 {
     class Device;
 
+    // Read-only view of a whole file, unmapped on destruction
+    class FileMapping: public NoCopyAndMove
+    {
+    public:
+        virtual ~FileMapping() = default;
+
+        auto data() const -> const u8* { return data_; }
+        auto size() const -> size_t { return size_; }
+
+    protected:
+        const u8 *data_ = nullptr;
+        size_t size_ = 0;
+
+        FileMapping() = default;
+    };
+
     class FileSystem: public NoCopyAndMove
     {
     public:
@@ -20,9 +36,18 @@ namespace solo
         virtual ~FileSystem() = default;
 
         virtual auto stream(const str &path) -> sptr<std::istream>;
+        // Unlike readBytes doesn't copy the file, pages are loaded on access and shared with other processes
+        virtual auto map(const str &path) -> sptr<FileMapping>;
+
+        virtual bool exists(const str &path);
+        // Opaque timestamp for ordering writes, 0 for missing files
+        virtual auto lastWriteTime(const str &path) -> u64;
 
         virtual auto readBytes(const str &path) -> vec<u8>;
         virtual void writeBytes(const str &path, const vec<u8> &data);
+        // Writes a temporary file next to the target and renames it into place, so concurrent writers
+        // don't interleave and readers never see a partial file. Failures are ignored, for caches
+        virtual void replaceBytes(const str &path, const vec<u8> &data);
 
         virtual auto readText(const str &path) -> str;
         virtual auto readLines(const str &path) -> vec<str>;
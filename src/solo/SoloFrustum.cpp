@@ -0,0 +1,112 @@
+/* 
+ * Copyright (c) Aleksey Fedotov 
+ * MIT license 
+ */
+
+#include "SoloFrustum.h"
+#include "SoloBoundingBox.h"
+#include "SoloMatrix.h"
+#include <cmath>
+
+#if defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+#   define SL_FRUSTUM_SSE
+#   include <xmmintrin.h>
+#endif
+
+using namespace solo;
+
+Frustum::Frustum()
+{
+    for (u32 i = 0; i < 8; i++)
+    {
+        nx_[i] = ny_[i] = nz_[i] = 0;
+        absNx_[i] = absNy_[i] = absNz_[i] = 0;
+        d_[i] = 1;
+    }
+}
+
+Frustum::Frustum(const Matrix &viewProjection):
+    Frustum()
+{
+    // Planes are sums and differences of the last matrix row with the other rows (Gribb-Hartmann).
+    // Near plane is the OpenGL one, which also contains the Vulkan near plane
+    const auto m = viewProjection.columns();
+    const auto row = [m](u32 r, u32 c) { return m[c * 4 + r]; };
+
+    for (u32 i = 0; i < 6; i++)
+    {
+        const auto r = i / 2;
+        const auto sign = i % 2 ? -1.0f : 1.0f;
+        auto a = row(3, 0) + sign * row(r, 0);
+        auto b = row(3, 1) + sign * row(r, 1);
+        auto c = row(3, 2) + sign * row(r, 2);
+        auto d = row(3, 3) + sign * row(r, 3);
+
+        const auto length = std::sqrt(a * a + b * b + c * c);
+        if (length > 0)
+        {
+            a /= length;
+            b /= length;
+            c /= length;
+            d /= length;
+        }
+
+        nx_[i] = a;
+        ny_[i] = b;
+        nz_[i] = c;
+        d_[i] = d;
+        absNx_[i] = std::abs(a);
+        absNy_[i] = std::abs(b);
+        absNz_[i] = std::abs(c);
+    }
+}
+
+bool Frustum::intersects(const BoundingBox &box) const
+{
+    if (box.isEmpty())
+        return false;
+    if (box.isInfinite())
+        return true;
+
+    // A box is outside if it's fully behind any plane, i.e. its center is farther behind the plane
+    // than the box's projected radius on the plane normal
+    const auto center = box.center();
+    const auto extents = box.extents();
+
+#ifdef SL_FRUSTUM_SSE
+    const auto cx = _mm_set1_ps(center.x());
+    const auto cy = _mm_set1_ps(center.y());
+    const auto cz = _mm_set1_ps(center.z());
+    const auto ex = _mm_set1_ps(extents.x());
+    const auto ey = _mm_set1_ps(extents.y());
+    const auto ez = _mm_set1_ps(extents.z());
+    const auto zero = _mm_setzero_ps();
+
+    // Frustums live inside heap-allocated cameras, and C++14 allocation only guarantees 8-byte alignment
+    // on 32-bit targets, so planes are loaded unaligned
+    for (u32 i = 0; i < 8; i += 4)
+    {
+        auto distance = _mm_loadu_ps(d_ + i);
+        distance = _mm_add_ps(distance, _mm_mul_ps(_mm_loadu_ps(nx_ + i), cx));
+        distance = _mm_add_ps(distance, _mm_mul_ps(_mm_loadu_ps(ny_ + i), cy));
+        distance = _mm_add_ps(distance, _mm_mul_ps(_mm_loadu_ps(nz_ + i), cz));
+
+        auto radius = _mm_mul_ps(_mm_loadu_ps(absNx_ + i), ex);
+        radius = _mm_add_ps(radius, _mm_mul_ps(_mm_loadu_ps(absNy_ + i), ey));
+        radius = _mm_add_ps(radius, _mm_mul_ps(_mm_loadu_ps(absNz_ + i), ez));
+
+        if (_mm_movemask_ps(_mm_cmplt_ps(_mm_add_ps(distance, radius), zero)))
+            return false;
+    }
+#else
+    for (u32 i = 0; i < 6; i++)
+    {
+        const auto distance = nx_[i] * center.x() + ny_[i] * center.y() + nz_[i] * center.z() + d_[i];
+        const auto radius = absNx_[i] * extents.x() + absNy_[i] * extents.y() + absNz_[i] * extents.z();
+        if (distance + radius < 0)
+            return false;
+    }
+#endif
+
+    return true;
+}
@@ -0,0 +1,37 @@
+/* 
+ * Copyright (c) Aleksey Fedotov 
+ * MIT license 
+ */
+
+#pragma once
+
+#include "SoloCommon.h"
+
+namespace solo
+{
+    class Matrix;
+    class BoundingBox;
+
+    // View volume given by six planes extracted from a view-projection matrix
+    class Frustum final
+    {
+    public:
+        // Contains everything
+        Frustum();
+        explicit Frustum(const Matrix &viewProjection);
+
+        // Conservative - boxes near frustum corners may be reported as intersecting although they're outside
+        bool intersects(const BoundingBox &box) const;
+
+    private:
+        // Planes are kept in structure-of-arrays form and padded to eight so that four of them are tested at once.
+        // Padding planes contain everything
+        float nx_[8];
+        float ny_[8];
+        float nz_[8];
+        float d_[8];
+        float absNx_[8];
+        float absNy_[8];
+        float absNz_[8];
+    };
+}
@@ -5,6 +5,8 @@
 
 #pragma once
 
+#include "SoloCommon.h"
+
 namespace solo
 {
     inline void combineHash(size_t &seed, size_t hash)
@@ -12,4 +14,17 @@ namespace solo
         hash += 0x9e3779b9 + (seed << 6) + (seed >> 2);
         seed ^= hash;
     }
+
+    // FNV-1a, stable across runs and platforms unlike std::hash, so suitable for keys that get persisted
+    inline auto hashBytes(const void *data, size_t size, u64 seed = 14695981039346656037ull) -> u64
+    {
+        auto hash = seed;
+        const auto bytes = static_cast<const u8*>(data);
+        for (size_t i = 0; i < size; i++)
+        {
+            hash ^= bytes[i];
+            hash *= 1099511628211ull;
+        }
+        return hash;
+    }
 }
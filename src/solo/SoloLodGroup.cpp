@@ -0,0 +1,75 @@
+/* 
+ * Copyright (c) Aleksey Fedotov 
+ * MIT license 
+ */
+
+#include "SoloLodGroup.h"
+#include "SoloCamera.h"
+#include "SoloTransform.h"
+#include "SoloBoundingBox.h"
+#include "SoloMeshRenderer.h"
+#include <algorithm>
+#include <cmath>
+
+using namespace solo;
+
+LodGroup::LodGroup(const Node &node):
+    ComponentBase<LodGroup>(node)
+{
+}
+
+void LodGroup::init()
+{
+    // The renderer caches the group instead of looking it up on every draw
+    const auto renderer = node_.findComponent<MeshRenderer>();
+    if (renderer)
+        renderer->lodGroup_ = this;
+}
+
+void LodGroup::terminate()
+{
+    const auto renderer = node_.findComponent<MeshRenderer>();
+    if (renderer && renderer->lodGroup_ == this)
+        renderer->lodGroup_ = nullptr;
+}
+
+void LodGroup::addLevel(sptr<Mesh> mesh, float minScreenSize)
+{
+    const auto pos = std::find_if(levels_.begin(), levels_.end(),
+        [minScreenSize](const Level &level) { return level.minScreenSize < minScreenSize; });
+    levels_.insert(pos, Level{mesh, minScreenSize});
+}
+
+auto LodGroup::selectLevel(const Camera *camera, const BoundingBox &worldBounds) const -> s32
+{
+    if (levels_.empty())
+        return -1;
+
+    const auto size = screenSize(camera, worldBounds);
+    for (u32 i = 0; i < levels_.size(); i++)
+    {
+        if (size >= levels_[i].minScreenSize)
+            return static_cast<s32>(i);
+    }
+
+    return -1;
+}
+
+auto LodGroup::screenSize(const Camera *camera, const BoundingBox &worldBounds) -> float
+{
+    // Unknown bounds can't be measured, treat them as close up
+    if (worldBounds.isEmpty() || worldBounds.isInfinite())
+        return 1;
+
+    const auto radius = worldBounds.extents().length();
+
+    if (!camera->isPerspective())
+        return 2 * radius / camera->orthoSize().y();
+
+    const auto distance = worldBounds.center().distance(camera->transform()->worldPosition());
+    if (distance <= radius)
+        return 1;
+
+    const auto halfHeight = distance * std::tan(camera->fieldOfView().toRawRadians() / 2);
+    return radius / halfHeight;
+}
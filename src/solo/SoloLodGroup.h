@@ -0,0 +1,51 @@
+/* 
+ * Copyright (c) Aleksey Fedotov 
+ * MIT license 
+ */
+
+#pragma once
+
+#include "SoloCommon.h"
+#include "SoloComponent.h"
+
+namespace solo
+{
+    class Mesh;
+    class Camera;
+    class BoundingBox;
+
+    // Swaps the mesh drawn by the node's MeshRenderer depending on how large the node appears on screen.
+    // The renderer's own mesh still defines bounds for culling, so it should be the most detailed level
+    class LodGroup final: public ComponentBase<LodGroup>
+    {
+    public:
+        explicit LodGroup(const Node &node);
+
+        void init() override final;
+        void terminate() override final;
+
+        // A level is used while the screen size is at least minScreenSize; below the last level nothing is drawn.
+        // Levels are kept sorted from the most to the least detailed
+        void addLevel(sptr<Mesh> mesh, float minScreenSize);
+        void clearLevels() { levels_.clear(); }
+
+        auto levelCount() const -> u32 { return static_cast<u32>(levels_.size()); }
+        auto levelMesh(u32 level) const -> sptr<Mesh> { return levels_.at(level).mesh; }
+        auto levelMinScreenSize(u32 level) const -> float { return levels_.at(level).minScreenSize; }
+
+        // Returns -1 when the node is too small to be drawn
+        auto selectLevel(const Camera *camera, const BoundingBox &worldBounds) const -> s32;
+
+        // Fraction of the viewport height covered by the bounding sphere of the given bounds
+        static auto screenSize(const Camera *camera, const BoundingBox &worldBounds) -> float;
+
+    private:
+        struct Level
+        {
+            sptr<Mesh> mesh;
+            float minScreenSize;
+        };
+
+        vec<Level> levels_;
+    };
+}
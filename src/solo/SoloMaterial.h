@@ -64,6 +64,15 @@ namespace solo
         SrcAlphaSaturate
     };
 
+    // Draws are sorted by render order first. Blended materials left in the opaque order are drawn as transparent
+    enum class RenderOrder
+    {
+        Background = 0, // submission order
+        Opaque, // front to back, grouped by state
+        Transparent, // back to front
+        Overlay // submission order
+    };
+
     enum class ParameterBinding
     {
         WorldMatrix,
@@ -77,6 +86,11 @@ namespace solo
         CameraWorldPosition
     };
 
+    // Parameter name resolved once, for setting parameters frequently without parsing and looking up names
+    using ParamHandle = u32;
+
+    // Parameters are read when the renderer submits draws at the end of a camera, not when draws are queued.
+    // Changing a parameter between two draws of the same camera affects both, so use a material per variant
     class Material: public NoCopyAndMove
     {
     public:
@@ -93,6 +107,17 @@ namespace solo
 
         virtual void bindParameter(const str &name, ParameterBinding binding) = 0;
 
+        virtual auto parameterHandle(const str &name) -> ParamHandle = 0;
+
+        virtual void setFloatParameter(ParamHandle handle, float value) = 0;
+        virtual void setVector2Parameter(ParamHandle handle, const Vector2 &value) = 0;
+        virtual void setVector3Parameter(ParamHandle handle, const Vector3 &value) = 0;
+        virtual void setVector4Parameter(ParamHandle handle, const Vector4 &value) = 0;
+        virtual void setMatrixParameter(ParamHandle handle, const Matrix &value) = 0;
+        virtual void setTextureParameter(ParamHandle handle, sptr<Texture> value) = 0;
+
+        virtual void bindParameter(ParamHandle handle, ParameterBinding binding) = 0;
+
         virtual auto effect() const -> sptr<Effect> = 0;
 
         auto polygonMode() const -> PolygonMode { return polygonMode_; }
@@ -117,6 +142,9 @@ namespace solo
         auto depthFunction() const -> DepthFunction { return depthFunc_; }
         void setDepthFunction(DepthFunction func) { depthFunc_ = func; }
 
+        auto renderOrder() const -> RenderOrder { return renderOrder_; }
+        void setRenderOrder(RenderOrder order) { renderOrder_ = order; }
+
     protected:
         FaceCull faceCull_ = FaceCull::Back;
         PolygonMode polygonMode_ = PolygonMode::Fill;
@@ -126,6 +154,7 @@ namespace solo
         BlendFactor srcBlendFactor_ = BlendFactor::SrcAlpha;
         BlendFactor dstBlendFactor_ = BlendFactor::OneMinusSrcAlpha;
         DepthFunction depthFunc_ = DepthFunction::Less;
+        RenderOrder renderOrder_ = RenderOrder::Opaque;
 
         Material() = default;
     };
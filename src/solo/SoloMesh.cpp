@@ -8,6 +8,8 @@
 #include "SoloDevice.h"
 #include "SoloJobPool.h"
 #include "SoloMeshData.h"
+#include "SoloCookedMesh.h"
+#include <algorithm>
 #include "gl/SoloOpenGLMesh.h"
 #include "vk/SoloVulkanMesh.h"
 
@@ -31,23 +33,210 @@ auto Mesh::empty(Device *device) -> sptr<Mesh>
     }
 }
 
-static auto fromData(Device *device, sptr<MeshData> data, const VertexBufferLayout &bufferLayout) -> sptr<Mesh>
+auto Mesh::smallestIndexElementSize(const u32 *indices, u32 count) -> IndexElementSize
 {
-    auto mesh = Mesh::empty(device);
+    for (u32 i = 0; i < count; i++)
+    {
+        if (indices[i] >= 0xffff)
+            return IndexElementSize::Bits32;
+    }
+    return IndexElementSize::Bits16;
+}
 
-    mesh->addVertexBuffer(bufferLayout, data->vertexData().data(),
-        data->vertexData().size() / bufferLayout.elementCount());
+auto Mesh::narrowIndices(const u32 *indices, u32 count) -> vec<u16>
+{
+    return vec<u16>(indices, indices + count);
+}
 
-    for (auto &part : data->indexData())
-        mesh->addPart(part.data(), part.size());
+auto Mesh::addCompactPart(const vec<u32> &indices) -> u32
+{
+    const auto count = static_cast<u32>(indices.size());
+    if (smallestIndexElementSize(indices.data(), count) == IndexElementSize::Bits16)
+        return addPart(narrowIndices(indices.data(), count).data(), count, IndexElementSize::Bits16);
+    return addPart(indices.data(), count, IndexElementSize::Bits32);
+}
 
-    return mesh;
+void Mesh::setBounds(const BoundingBox &bounds)
+{
+    bounds_ = bounds;
+    boundsVersion_++;
+}
+
+auto Mesh::partBounds(u32 part) const -> const BoundingBox&
+{
+    return part < partBounds_.size() && !partBounds_[part].isEmpty() ? partBounds_[part] : bounds_;
+}
+
+void Mesh::setPartBounds(u32 part, const BoundingBox &bounds)
+{
+    if (part >= partBounds_.size())
+        partBounds_.resize(part + 1);
+    partBounds_[part] = bounds;
+    boundsVersion_++;
+}
+
+void Mesh::setOccluderGeometry(const vec<float> &positions, const vec<u32> &indices)
+{
+    occluderPositions_.clear();
+    occluderIndices_.clear();
+
+    const auto vertexCount = positions.size() / 3;
+    const auto valid = positions.size() % 3 == 0 && indices.size() % 3 == 0 &&
+        std::all_of(indices.begin(), indices.end(), [vertexCount](u32 index) { return index < vertexCount; });
+    if (!valid)
+    {
+        Logger::global().logError("Invalid occluder geometry, ignored");
+        SL_DEBUG_PANIC(true, "Invalid occluder geometry");
+        return;
+    }
+
+    occluderPositions_ = positions;
+    occluderIndices_ = indices;
+}
+
+void Mesh::setOccluderGeometry(const MeshData &data)
+{
+    vec<float> positions;
+    vec<u32> indices;
+    data.occluderGeometry(positions, indices);
+    setOccluderGeometry(positions, indices);
+}
+
+void Mesh::includeVertexBounds(const VertexBufferLayout &layout, const void *data, u32 vertexCount, bool dynamic)
+{
+    boundsVersion_++;
+
+    if (dynamic || !data)
+    {
+        bounds_ = BoundingBox::infinite();
+        return;
+    }
+
+    for (u32 i = 0; i < layout.attributeCount(); i++)
+    {
+        const auto attr = layout.attribute(i);
+        if (attr.usage != VertexAttributeUsage::Position || attr.elementCount < 3)
+            continue;
+
+        const auto bytes = static_cast<const u8*>(data);
+        float pos[4];
+        for (u32 v = 0; v < vertexCount; v++)
+        {
+            VertexBufferLayout::unpackAttribute(attr, bytes + v * layout.size() + attr.offset, pos);
+            bounds_.include(Vector3(pos[0], pos[1], pos[2]));
+        }
+        return;
+    }
+}
+
+void Mesh::removePartBounds(u32 part)
+{
+    if (part < partBounds_.size())
+        partBounds_.erase(partBounds_.begin() + part);
+    boundsVersion_++;
 }
 
 auto Mesh::fromFile(Device *device, const str &path, const VertexBufferLayout &bufferLayout) -> sptr<Mesh>
 {
+    const auto cookedPath = CookedMesh::findCooked(device->fileSystem(), path);
+    if (!cookedPath.empty())
+    {
+        const auto cooked = CookedMesh::fromFile(device, cookedPath);
+        if (cooked && (CookedMesh::isCookedPath(path) || cooked->hasLayout(bufferLayout)))
+            return fromCooked(device, cooked);
+    }
+
+    // Repacks a cooked sibling that has the requested attributes, otherwise imports the source
+    const auto data = MeshData::fromFile(device, path, bufferLayout);
+    if (!data)
+        return nullptr;
+    return fromData(device, data);
+}
+
+auto Mesh::fromCooked(Device *device, sptr<CookedMesh> cooked) -> sptr<Mesh>
+{
+    auto mesh = empty(device);
+
+    mesh->addVertexBuffer(cooked->layout(), cooked->vertexData(), cooked->vertexCount());
+
+    for (u32 i = 0; i < cooked->partCount(); i++)
+    {
+        mesh->addPart(cooked->partIndexData(i), cooked->partIndexCount(i), cooked->partIndexElementSize(i));
+        mesh->setPartBounds(i, cooked->partBounds(i));
+    }
+
+    return mesh;
+}
+
+auto Mesh::fromData(Device *device, sptr<MeshData> data) -> sptr<Mesh>
+{
+    auto mesh = empty(device);
+
+    const auto vertexData = data->packedVertexData();
+    mesh->addVertexBuffer(data->layout(), vertexData.data(), data->vertexCount());
+
+    for (u32 i = 0; i < data->indexData().size(); i++)
+    {
+        const auto &part = data->indexData()[i];
+        const auto count = static_cast<u32>(part.size());
+        if (data->partIndexElementSize(i) == IndexElementSize::Bits16)
+        {
+            const auto narrowed = narrowIndices(part.data(), count);
+            mesh->addPart(narrowed.data(), count, IndexElementSize::Bits16);
+        }
+        else
+            mesh->addPart(part.data(), count, IndexElementSize::Bits32);
+    }
+
+    // Precise per-part bounds are known from the source data
+    for (u32 i = 0; i < data->partBounds().size(); i++)
+        mesh->setPartBounds(i, data->partBounds()[i]);
+
+    return mesh;
+}
+
+auto Mesh::fromFileWithOccluder(Device *device, const str &path, const VertexBufferLayout &bufferLayout,
+    float occluderTriangleRatio) -> sptr<Mesh>
+{
+    // Occluders need the data on the CPU, so cooked files are unpacked too
     const auto data = MeshData::fromFile(device, path, bufferLayout);
-    return fromData(device, data, bufferLayout);
+    if (!data)
+        return nullptr;
+
+    auto mesh = fromData(device, data);
+    mesh->setOccluderGeometry(occluderTriangleRatio < 1 ? *data->simplified(occluderTriangleRatio) : *data);
+    return mesh;
+}
+
+auto Mesh::lodChainFromFile(Device *device, const str &path, const VertexBufferLayout &bufferLayout,
+    const vec<float> &triangleRatios) -> vec<sptr<Mesh>>
+{
+    const auto data = MeshData::fromFile(device, path, bufferLayout);
+    if (!data)
+        return {};
+
+    const auto indexCount = [](const MeshData &levelData)
+    {
+        size_t count = 0;
+        for (const auto &part: levelData.indexData())
+            count += part.size();
+        return count;
+    };
+
+    vec<sptr<Mesh>> result;
+    sptr<MeshData> coarsest;
+    for (const auto ratio: triangleRatios)
+    {
+        const auto levelData = ratio < 1 ? data->simplified(ratio) : data;
+        result.push_back(fromData(device, levelData));
+        if (!coarsest || indexCount(*levelData) < indexCount(*coarsest))
+            coarsest = levelData;
+    }
+
+    for (auto &mesh: result)
+        mesh->setOccluderGeometry(*coarsest);
+
+    return result;
 }
 
 auto Mesh::fromFileAsync(Device *device, const str &path, const VertexBufferLayout &bufferLayout)
@@ -55,11 +244,24 @@ auto Mesh::fromFileAsync(Device *device, const str &path, const VertexBufferLayo
 {
     auto handle = std::make_shared<AsyncHandle<Mesh>>();
 
-    MeshData::fromFileAsync(device, path, bufferLayout)->done(
-        [handle, device, bufferLayout](sptr<MeshData> data)
+    const auto resolveFromData = [handle, device](sptr<MeshData> data)
+    {
+        handle->resolve(fromData(device, data));
+    };
+
+    // Cooked meshes need no parsing beyond validation, and their upload has to happen on this thread anyway
+    const auto cookedPath = CookedMesh::findCooked(device->fileSystem(), path);
+    if (!cookedPath.empty())
+    {
+        const auto cooked = CookedMesh::fromFile(device, cookedPath);
+        if (cooked && (CookedMesh::isCookedPath(path) || cooked->hasLayout(bufferLayout)))
         {
-            handle->resolve(fromData(device, data, bufferLayout));
-        });
+            handle->resolve(fromCooked(device, cooked));
+            return handle;
+        }
+    }
+
+    MeshData::fromFileAsync(device, path, bufferLayout)->done(resolveFromData);
 
     return handle;
 }
@@ -8,6 +8,7 @@
 #include "SoloCommon.h"
 #include "SoloVertexBufferLayout.h"
 #include "SoloAsyncHandle.h"
+#include "SoloBoundingBox.h"
 
 namespace solo
 {
@@ -20,14 +21,37 @@ namespace solo
         Points
     };
 
+    enum class IndexElementSize
+    {
+        Bits16,
+        Bits32
+    };
+
     class Device;
+    class MeshData;
+    class CookedMesh;
 
     class Mesh: public NoCopyAndMove
     {
     public:
         static auto empty(Device *device) -> sptr<Mesh>;
+        // Cooked files (see CookedMesh) are uploaded as they are, ignoring the requested layout. For source files
+        // an up-to-date cooked sibling is used instead when it was cooked in exactly the requested layout,
+        // or repacked when it has all requested attributes in the requested formats
         static auto fromFile(Device *device, const str &path, const VertexBufferLayout &bufferLayout) -> sptr<Mesh>;
         static auto fromFileAsync(Device *device, const str &path, const VertexBufferLayout &bufferLayout) -> sptr<AsyncHandle<Mesh>>;
+        static auto fromData(Device *device, sptr<MeshData> data) -> sptr<Mesh>;
+        static auto fromCooked(Device *device, sptr<CookedMesh> cooked) -> sptr<Mesh>;
+
+        // Like fromFile, but also gives the mesh occluder geometry simplified to the given fraction of triangles
+        static auto fromFileWithOccluder(Device *device, const str &path, const VertexBufferLayout &bufferLayout,
+            float occluderTriangleRatio) -> sptr<Mesh>;
+
+        // Loads the file once and builds a mesh per triangle ratio, simplifying the source data
+        // for ratios below 1. Intended for filling LodGroup levels. All levels get the coarsest one
+        // as occluder geometry
+        static auto lodChainFromFile(Device *device, const str &path, const VertexBufferLayout &bufferLayout,
+            const vec<float> &triangleRatios) -> vec<sptr<Mesh>>;
 
         virtual ~Mesh() = default;
 
@@ -36,14 +60,55 @@ namespace solo
         virtual void updateDynamicVertexBuffer(u32 index, u32 vertexOffset, const void *data, u32 vertexCount) = 0;
         virtual void removeVertexBuffer(u32 index) = 0;
 
-        virtual auto addPart(const void *indexData, u32 indexElementCount) -> u32 = 0;
+        virtual auto addPart(const void *indexData, u32 indexElementCount, IndexElementSize elementSize) -> u32 = 0;
         virtual void removePart(u32 index) = 0;
         virtual auto partCount() const -> u32 = 0;
+        virtual auto partIndexElementSize(u32 part) const -> IndexElementSize = 0;
+
+        // 16-bit when all indices fit, which halves index memory and bandwidth. 0xffff is left out
+        // since it doubles as the primitive restart index
+        static auto smallestIndexElementSize(const u32 *indices, u32 count) -> IndexElementSize;
+        static auto narrowIndices(const u32 *indices, u32 count) -> vec<u16>;
+        static auto indexElementSizeInBytes(IndexElementSize size) -> u32 { return size == IndexElementSize::Bits16 ? 2 : 4; }
+
+        // Adds a part using the smallest index element size the indices fit into
+        auto addCompactPart(const vec<u32> &indices) -> u32;
 
         virtual auto primitiveType() const -> PrimitiveType = 0;
         virtual void setPrimitiveType(PrimitiveType type) = 0;
 
+        // Local-space bounds, computed from position attributes of static vertex buffers.
+        // Infinite when unknown, e.g. once a dynamic vertex buffer has been added
+        auto bounds() const -> const BoundingBox& { return bounds_; }
+        void setBounds(const BoundingBox &bounds);
+
+        // Whole mesh bounds unless set explicitly
+        auto partBounds(u32 part) const -> const BoundingBox&;
+        void setPartBounds(u32 part, const BoundingBox &bounds);
+
+        // Changes whenever any of the bounds change
+        auto boundsVersion() const -> u32 { return boundsVersion_; }
+
+        // Simplified local-space triangles rasterized by software occlusion culling when the mesh is drawn
+        // by an occluder renderer. Positions are xyz triplets, indices form a triangle list.
+        // Geometry with indices out of range of the positions is rejected and leaves the mesh without occluder
+        void setOccluderGeometry(const vec<float> &positions, const vec<u32> &indices);
+        void setOccluderGeometry(const MeshData &data);
+        bool hasOccluderGeometry() const { return !occluderIndices_.empty(); }
+        auto occluderPositions() const -> const vec<float>& { return occluderPositions_; }
+        auto occluderIndices() const -> const vec<u32>& { return occluderIndices_; }
+
     protected:
         Mesh() = default;
+
+        void includeVertexBounds(const VertexBufferLayout &layout, const void *data, u32 vertexCount, bool dynamic);
+        void removePartBounds(u32 part);
+
+    private:
+        BoundingBox bounds_;
+        vec<BoundingBox> partBounds_;
+        u32 boundsVersion_ = 0;
+        vec<float> occluderPositions_;
+        vec<u32> occluderIndices_;
     };
 }
@@ -11,89 +11,356 @@
 #include <assimp/scene.h>
 #include <assimp/postprocess.h>
 #include "SoloVertexBufferLayout.h"
+#include "SoloMeshOptimizer.h"
+#include "SoloCookedMesh.h"
+#include "assimp/SoloAssimpIOSystem.h"
+#include <algorithm>
+#include <numeric>
+#include <queue>
+#include <atomic>
+#include <future>
+#include <thread>
+#include <limits>
 
 using namespace solo;
 
+namespace
+{
+    // Symmetric 4x4 matrix accumulating squared distances to a set of planes
+    struct Quadric
+    {
+        double m[10] = {};
+
+        void addPlane(double a, double b, double c, double d, double weight)
+        {
+            m[0] += weight * a * a; m[1] += weight * a * b; m[2] += weight * a * c; m[3] += weight * a * d;
+            m[4] += weight * b * b; m[5] += weight * b * c; m[6] += weight * b * d;
+            m[7] += weight * c * c; m[8] += weight * c * d;
+            m[9] += weight * d * d;
+        }
+
+        void add(const Quadric &other)
+        {
+            for (u32 i = 0; i < 10; i++)
+                m[i] += other.m[i];
+        }
+
+        auto error(const Vector3 &p) const -> double
+        {
+            const double x = p.x(), y = p.y(), z = p.z();
+            return m[0] * x * x + 2 * m[1] * x * y + 2 * m[2] * x * z + 2 * m[3] * x +
+                m[4] * y * y + 2 * m[5] * y * z + 2 * m[6] * y +
+                m[7] * z * z + 2 * m[8] * z +
+                m[9];
+        }
+    };
+
+    struct Triangle
+    {
+        u32 vertices[3]; // original vertex indices
+        u32 welded[3]; // current welded vertices they are collapsed into
+        u32 part;
+        bool removed;
+    };
+
+    struct Collapse
+    {
+        double cost;
+        u32 from;
+        u32 to;
+        u32 fromVersion;
+        u32 toVersion;
+
+        bool operator>(const Collapse &other) const { return cost > other.cost; }
+    };
+}
+
+// Keeps edges along open borders from sliding sideways
+static const double borderWeight = 1000;
+
+static auto edgeKey(u32 a, u32 b) -> u64
+{
+    return (static_cast<u64>((std::min)(a, b)) << 32) | (std::max)(a, b);
+}
+
+// Offset in floats of unpacked vertex data, which is independent from the formats
+static auto positionOffset(const VertexBufferLayout &layout) -> s32
+{
+    u32 offset = 0;
+    for (u32 i = 0; i < layout.attributeCount(); i++)
+    {
+        const auto attr = layout.attribute(i);
+        if (attr.usage == VertexAttributeUsage::Position)
+            return static_cast<s32>(offset);
+        offset += attr.elementCount;
+    }
+    return -1;
+}
+
+static auto partsAcmr(const vec<vec<u32>> &parts, u32 vertexCount) -> float
+{
+    auto misses = 0.0f;
+    size_t triangleCount = 0;
+    for (const auto &part: parts)
+    {
+        misses += MeshOptimizer::acmr(part, vertexCount) * (part.size() / 3);
+        triangleCount += part.size() / 3;
+    }
+    return triangleCount ? misses / triangleCount : 0;
+}
+
+// Assimp work is skipped for attributes the layout doesn't ask for
+static auto importFlags(const VertexBufferLayout &layout) -> u32
+{
+    u32 flags = aiProcess_Triangulate;
+    for (u32 i = 0; i < layout.attributeCount(); i++)
+    {
+        switch (layout.attribute(i).usage)
+        {
+            case VertexAttributeUsage::Normal:
+                flags |= aiProcess_GenSmoothNormals;
+                break;
+            case VertexAttributeUsage::Tangent:
+            case VertexAttributeUsage::Binormal:
+                flags |= aiProcess_GenSmoothNormals | aiProcess_CalcTangentSpace;
+                break;
+            default:
+                break;
+        }
+    }
+    return flags;
+}
+
+template <u32 Count>
+static void writeVectors(const aiVector3D *src, u32 vertexCount, float *dst, u32 stride)
+{
+    for (u32 i = 0; i < vertexCount; i++, dst += stride)
+    {
+        dst[0] = src[i].x;
+        dst[1] = src[i].y;
+        if (Count > 2)
+            dst[2] = src[i].z;
+    }
+}
+
+static void writeColors(const aiColor4D *src, u32 vertexCount, float *dst, u32 stride)
+{
+    for (u32 i = 0; i < vertexCount; i++, dst += stride)
+    {
+        dst[0] = src ? src[i].r : 1;
+        dst[1] = src ? src[i].g : 1;
+        dst[2] = src ? src[i].b : 1;
+        dst[3] = src ? src[i].a : 1;
+    }
+}
+
+// Writes one attribute of all mesh vertices into interleaved floats. The source is chosen once per attribute
+// rather than per vertex. Attributes the mesh lacks keep the zeros the output is initialized with, except
+// colors that default to white
+static void writeAttribute(const aiMesh *mesh, const VertexAttribute &attr, float *dst, u32 stride)
+{
+    const auto count = mesh->mNumVertices;
+    switch (attr.usage)
+    {
+        case VertexAttributeUsage::Position:
+            writeVectors<3>(mesh->mVertices, count, dst, stride);
+            break;
+        case VertexAttributeUsage::Normal:
+            if (mesh->HasNormals())
+                writeVectors<3>(mesh->mNormals, count, dst, stride);
+            break;
+        case VertexAttributeUsage::TexCoord:
+            if (mesh->HasTextureCoords(0))
+                writeVectors<2>(mesh->mTextureCoords[0], count, dst, stride);
+            break;
+        case VertexAttributeUsage::Tangent:
+            if (mesh->HasTangentsAndBitangents())
+                writeVectors<3>(mesh->mTangents, count, dst, stride);
+            break;
+        case VertexAttributeUsage::Binormal:
+            if (mesh->HasTangentsAndBitangents())
+                writeVectors<3>(mesh->mBitangents, count, dst, stride);
+            break;
+        case VertexAttributeUsage::Color:
+            writeColors(mesh->HasVertexColors(0) ? mesh->mColors[0] : nullptr, count, dst, stride);
+            break;
+        default:
+            break;
+    }
+}
+
+// Below this many vertices starting threads costs more than the conversion itself
+static const u32 parallelImportMinVertices = 1 << 16;
+
+// Meshes write to disjoint slices, so they are converted on several threads, each pulling the next mesh.
+// The calling thread takes part too
+static void forEachMesh(u32 meshCount, u32 vertexCount, const std::function<void(u32)> &convert)
+{
+    const auto threadCount = vertexCount < parallelImportMinVertices
+        ? 1u
+        : (std::min)(meshCount, (std::max)(1u, std::thread::hardware_concurrency()));
+
+    std::atomic<u32> next{0};
+    const auto work = [&]()
+    {
+        for (auto i = next++; i < meshCount; i = next++)
+            convert(i);
+    };
+
+    vec<std::future<void>> helpers;
+    for (u32 i = 1; i < threadCount; i++)
+        helpers.push_back(std::async(std::launch::async, work));
+    work();
+    for (auto &helper: helpers)
+        helper.get();
+}
+
 auto MeshData::fromFile(Device *device, const str &path, const VertexBufferLayout &bufferLayout) -> sptr<MeshData>
 {
-    // TODO Implement proper io system for assimp to avoid loading file into memory
-    const auto bytes = device->fileSystem()->readBytes(path);
-    
+    const auto cookedPath = CookedMesh::findCooked(device->fileSystem(), path);
+    if (!cookedPath.empty())
+    {
+        // Cooked files requested explicitly are unpacked whatever they contain
+        const auto cooked = CookedMesh::fromFile(device, cookedPath);
+        if (cooked && (CookedMesh::isCookedPath(path) || cooked->providesLayout(bufferLayout)))
+            return fromCooked(*cooked, bufferLayout);
+        SL_DEBUG_LOG("Ignoring ", cookedPath, " that is invalid or lacks some of the requested attributes");
+    }
+
+    return fromFile(device->fileSystem(), path, bufferLayout);
+}
+
+auto MeshData::fromFile(FileSystem *fs, const str &path, const VertexBufferLayout &bufferLayout) -> sptr<MeshData>
+{
+    if (CookedMesh::isCookedPath(path))
+    {
+        // Invalid files are logged by the parser
+        const auto cooked = CookedMesh::fromMapping(fs->map(path));
+        return cooked ? fromCooked(*cooked, bufferLayout) : nullptr;
+    }
+
+    // Reading mapped files through the engine file system avoids holding a copy of the file next to assimp's,
+    // and lets importers find sibling files such as OBJ materials
     Assimp::Importer importer;
-    const auto flags = aiProcess_Triangulate | aiProcess_CalcTangentSpace | aiProcess_GenSmoothNormals;
-	const auto scene = importer.ReadFileFromMemory(bytes.data(), bytes.size(), flags);
-    SL_DEBUG_PANIC(!scene, "Unable to parse file ", path);
+    importer.SetIOHandler(new AssimpIOSystem(fs));
+    const auto scene = importer.ReadFile(path, importFlags(bufferLayout));
+    if (!scene)
+    {
+        Logger::global().logError(SL_FMT("Unable to parse file ", path, ": ", importer.GetErrorString()));
+        return nullptr;
+    }
 
     auto data = std::make_shared<MeshData>();
-    u32 indexBase = 0;
+    data->layout_ = bufferLayout;
+
+    // Output sizes are known up front, so each mesh is converted straight into its own slice
+    const auto meshCount = scene->mNumMeshes;
+    vec<u32> vertexBases(meshCount);
+    for (u32 i = 0; i < meshCount; i++)
+    {
+        vertexBases[i] = data->vertexCount_;
+        data->vertexCount_ += scene->mMeshes[i]->mNumVertices;
+    }
+
+    const auto stride = bufferLayout.elementCount();
+    vec<u32> attributeOffsets(bufferLayout.attributeCount());
+    for (u32 i = 1; i < bufferLayout.attributeCount(); i++)
+        attributeOffsets[i] = attributeOffsets[i - 1] + bufferLayout.attribute(i - 1).elementCount;
 
-    // TODO resize vertices beforehand
-    for (u32 i = 0; i < scene->mNumMeshes; i++)
-	{
-		const aiMesh* mesh = scene->mMeshes[i];
-		const aiVector3D zeroVec(0.0f, 0.0f, 0.0f);
+    data->vertexData_.resize(static_cast<size_t>(stride) * data->vertexCount_);
+    data->indexData_.resize(meshCount);
+    data->partBounds_.resize(meshCount);
 
-		for (u32 j = 0; j < mesh->mNumVertices; j++)
-		{
-			const auto pos = &mesh->mVertices[j];
-			const auto normal = &mesh->mNormals[j];
-			const auto texCoord = mesh->HasTextureCoords(0) ? &mesh->mTextureCoords[0][j] : &zeroVec;
-			const auto tangent = mesh->HasTangentsAndBitangents() ? &mesh->mTangents[j] : &zeroVec;
-			const auto biTangent = mesh->HasTangentsAndBitangents() ? &mesh->mBitangents[j] : &zeroVec;
+    forEachMesh(meshCount, data->vertexCount_, [&](u32 i)
+    {
+        const auto mesh = scene->mMeshes[i];
+        const auto vertexBase = vertexBases[i];
+        const auto vertices = data->vertexData_.data() + static_cast<size_t>(vertexBase) * stride;
 
-            data->vertexCount_++;
+        for (u32 j = 0; j < bufferLayout.attributeCount(); j++)
+            writeAttribute(mesh, bufferLayout.attribute(j), vertices + attributeOffsets[j], stride);
 
-            for (u32 k = 0; k < bufferLayout.attributeCount(); k++)
+        auto &bounds = data->partBounds_[i];
+        for (u32 j = 0; j < mesh->mNumVertices; j++)
+        {
+            const auto &pos = mesh->mVertices[j];
+            bounds.include(Vector3(pos.x, pos.y, pos.z));
+        }
+
+        auto &part = data->indexData_[i];
+        part.resize(mesh->mNumFaces * 3);
+        for (u32 j = 0; j < mesh->mNumFaces; j++)
+        {
+            const auto &face = mesh->mFaces[j];
+            if (face.mNumIndices == 3)
             {
-                const auto attr = bufferLayout.attribute(k);
-                switch (attr.usage)
-                {
-                    case VertexAttributeUsage::Position:
-                        data->vertexData_.push_back(pos->x);
-			            data->vertexData_.push_back(pos->y);
-			            data->vertexData_.push_back(pos->z);
-                        break;
-                    case VertexAttributeUsage::Normal:
-                        data->vertexData_.push_back(normal->x);
-			            data->vertexData_.push_back(normal->y);
-			            data->vertexData_.push_back(normal->z);
-                        break;
-                    case VertexAttributeUsage::TexCoord:
-                        data->vertexData_.push_back(texCoord->x);
-                        data->vertexData_.push_back(texCoord->y);
-                        break;
-                    case VertexAttributeUsage::Tangent:
-                        data->vertexData_.push_back(tangent->x);
-			            data->vertexData_.push_back(tangent->y);
-			            data->vertexData_.push_back(tangent->z);
-                        break;
-                    case VertexAttributeUsage::Binormal:
-                        data->vertexData_.push_back(biTangent->x);
-			            data->vertexData_.push_back(biTangent->y);
-			            data->vertexData_.push_back(biTangent->z);
-                        break;
-                    default: break;
-                }
+                part[j * 3] = vertexBase + face.mIndices[0];
+                part[j * 3 + 1] = vertexBase + face.mIndices[1];
+                part[j * 3 + 2] = vertexBase + face.mIndices[2];
             }
-		}
+        }
+    });
 
-        vec<u32> part;
-        part.resize(mesh->mNumFaces * 3);
-		for (u32 j = 0; j < mesh->mNumFaces; j++)
-		{
-			const auto &face = mesh->mFaces[j];
-			if (face.mNumIndices == 3)
+    data->optimize();
+    SL_DEBUG_LOG("Optimized ", path, ", ACMR ", data->sourceAcmr_, " -> ", data->acmr_);
+
+    return data;
+}
+
+auto MeshData::fromCooked(const CookedMesh &cooked, const VertexBufferLayout &bufferLayout) -> sptr<MeshData>
+{
+    auto data = std::make_shared<MeshData>();
+    data->layout_ = bufferLayout;
+    data->vertexCount_ = cooked.vertexCount();
+    data->vertexData_.resize(static_cast<size_t>(bufferLayout.elementCount()) * cooked.vertexCount(), 0);
+
+    // Requested attributes are matched by usage, the ones missing from the cooked layout stay zero
+    const auto &cookedLayout = cooked.layout();
+    const auto vertices = static_cast<const u8*>(cooked.vertexData());
+    u32 dstOffset = 0;
+    for (u32 i = 0; i < bufferLayout.attributeCount(); i++)
+    {
+        const auto attr = bufferLayout.attribute(i);
+        for (u32 j = 0; j < cookedLayout.attributeCount(); j++)
+        {
+            const auto src = cookedLayout.attribute(j);
+            if (src.usage != attr.usage)
+                continue;
+
+            const auto count = (std::min)(attr.elementCount, src.elementCount);
+            float unpacked[4];
+            for (u32 v = 0; v < data->vertexCount_; v++)
             {
-                const auto startIdx = j * 3;
-                part[startIdx] = indexBase + face.mIndices[0];
-                part[startIdx + 1] = indexBase + face.mIndices[1];
-                part[startIdx + 2] = indexBase + face.mIndices[2];
+                VertexBufferLayout::unpackAttribute(src, vertices + v * cookedLayout.size() + src.offset, unpacked);
+                std::copy(unpacked, unpacked + count, data->vertexData_.begin() + v * bufferLayout.elementCount() + dstOffset);
             }
-		}
+            break;
+        }
+        dstOffset += attr.elementCount;
+    }
+
+    for (u32 i = 0; i < cooked.partCount(); i++)
+    {
+        const auto count = cooked.partIndexCount(i);
+        vec<u32> part(count);
+        if (cooked.partIndexElementSize(i) == IndexElementSize::Bits16)
+        {
+            const auto src = static_cast<const u16*>(cooked.partIndexData(i));
+            std::copy(src, src + count, part.begin());
+        }
+        else
+        {
+            const auto src = static_cast<const u32*>(cooked.partIndexData(i));
+            std::copy(src, src + count, part.begin());
+        }
 
-        indexBase += mesh->mNumFaces * 3;
         data->indexData_.emplace_back(std::move(part));
-	}
+        data->partBounds_.push_back(cooked.partBounds(i));
+        data->partIndexElementSizes_.push_back(cooked.partIndexElementSize(i));
+    }
+
+    // Already optimized when cooked
+    data->sourceAcmr_ = data->acmr_ = partsAcmr(data->indexData_, data->vertexCount_);
 
     return data;
 }
@@ -107,4 +374,342 @@ auto MeshData::fromFileAsync(Device *device, const str &path, const VertexBuffer
     device->jobPool()->addJob(std::make_shared<JobBase<MeshData>>(producers, consumer));
 
     return handle;
-}
+}
+
+auto MeshData::simplified(float triangleRatio) const -> sptr<MeshData>
+{
+    auto result = std::make_shared<MeshData>(*this);
+
+    const auto positions = positionOffset(layout_);
+    if (positions < 0 || triangleRatio >= 1 || !vertexCount_)
+        return result;
+
+    const auto stride = layout_.elementCount();
+    const auto position = [&](u32 vertex)
+    {
+        const auto p = vertexData_.data() + vertex * stride + positions;
+        return Vector3(p[0], p[1], p[2]);
+    };
+
+    // Weld vertices with equal positions, each group being represented by its first vertex
+    vec<u32> order(vertexCount_);
+    std::iota(order.begin(), order.end(), 0);
+    std::sort(order.begin(), order.end(), [&](u32 a, u32 b)
+    {
+        const auto pa = position(a), pb = position(b);
+        if (pa.x() != pb.x()) return pa.x() < pb.x();
+        if (pa.y() != pb.y()) return pa.y() < pb.y();
+        return pa.z() < pb.z();
+    });
+
+    vec<u32> weld(vertexCount_);
+    for (u32 i = 0; i < vertexCount_; i++)
+    {
+        const auto same = i > 0 &&
+            std::equal(vertexData_.begin() + order[i] * stride + positions,
+                vertexData_.begin() + order[i] * stride + positions + 3,
+                vertexData_.begin() + order[i - 1] * stride + positions);
+        weld[order[i]] = same ? weld[order[i - 1]] : order[i];
+    }
+
+    vec<Triangle> triangles;
+    vec<vec<u32>> vertexTriangles(vertexCount_);
+    vec<Quadric> quadrics(vertexCount_);
+    umap<u64, u32> edgeUseCounts;
+    u32 liveTriangleCount = 0;
+
+    for (u32 part = 0; part < indexData_.size(); part++)
+    {
+        const auto &indices = indexData_[part];
+        for (u32 i = 0; i + 2 < indices.size(); i += 3)
+        {
+            if (indices[i] >= vertexCount_ || indices[i + 1] >= vertexCount_ || indices[i + 2] >= vertexCount_)
+                continue;
+
+            Triangle triangle{{indices[i], indices[i + 1], indices[i + 2]}, {}, part, false};
+            for (u32 k = 0; k < 3; k++)
+                triangle.welded[k] = weld[triangle.vertices[k]];
+
+            const auto &w = triangle.welded;
+            triangle.removed = w[0] == w[1] || w[1] == w[2] || w[0] == w[2];
+            if (!triangle.removed)
+            {
+                const auto p0 = position(w[0]);
+                const auto normal = (position(w[1]) - p0).cross(position(w[2]) - p0);
+                const auto doubleArea = normal.length();
+                if (doubleArea > 0)
+                {
+                    const auto n = normal / doubleArea;
+                    for (u32 k = 0; k < 3; k++)
+                        quadrics[w[k]].addPlane(n.x(), n.y(), n.z(), -n.dot(p0), doubleArea * 0.5);
+                }
+
+                for (u32 k = 0; k < 3; k++)
+                {
+                    vertexTriangles[w[k]].push_back(static_cast<u32>(triangles.size()));
+                    edgeUseCounts[edgeKey(w[k], w[(k + 1) % 3])]++;
+                }
+
+                liveTriangleCount++;
+            }
+
+            triangles.push_back(triangle);
+        }
+    }
+
+    // Constrain border edges by planes perpendicular to their triangles
+    for (const auto &triangle: triangles)
+    {
+        if (triangle.removed)
+            continue;
+
+        const auto &w = triangle.welded;
+        const auto p0 = position(w[0]);
+        const auto normal = (position(w[1]) - p0).cross(position(w[2]) - p0).normalized();
+        for (u32 k = 0; k < 3; k++)
+        {
+            const auto a = w[k], b = w[(k + 1) % 3];
+            if (edgeUseCounts[edgeKey(a, b)] != 1)
+                continue;
+
+            const auto edge = position(b) - position(a);
+            const auto edgeLength = edge.length();
+            if (edgeLength <= 0)
+                continue;
+
+            const auto n = edge.cross(normal).normalized();
+            const auto weight = borderWeight * edgeLength * edgeLength;
+            quadrics[a].addPlane(n.x(), n.y(), n.z(), -n.dot(position(a)), weight);
+            quadrics[b].addPlane(n.x(), n.y(), n.z(), -n.dot(position(a)), weight);
+        }
+    }
+
+    vec<u32> versions(vertexCount_, 0);
+    vec<bool> collapsed(vertexCount_, false);
+    std::priority_queue<Collapse, vec<Collapse>, std::greater<Collapse>> collapses;
+
+    const auto pushCollapse = [&](u32 a, u32 b)
+    {
+        auto q = quadrics[a];
+        q.add(quadrics[b]);
+        const auto costToB = q.error(position(b));
+        const auto costToA = q.error(position(a));
+        if (costToB <= costToA)
+            collapses.push(Collapse{costToB, a, b, versions[a], versions[b]});
+        else
+            collapses.push(Collapse{costToA, b, a, versions[b], versions[a]});
+    };
+
+    for (const auto &edge: edgeUseCounts)
+        pushCollapse(static_cast<u32>(edge.first >> 32), static_cast<u32>(edge.first & 0xffffffff));
+
+    // Moving a vertex must not turn any of its remaining triangles over
+    const auto flipsTriangles = [&](u32 from, u32 to)
+    {
+        const auto target = position(to);
+        for (const auto t: vertexTriangles[from])
+        {
+            const auto &triangle = triangles[t];
+            const auto &w = triangle.welded;
+            if (triangle.removed || w[0] == to || w[1] == to || w[2] == to)
+                continue;
+
+            Vector3 before[3], after[3];
+            for (u32 k = 0; k < 3; k++)
+            {
+                before[k] = position(w[k]);
+                after[k] = w[k] == from ? target : before[k];
+            }
+
+            const auto normalBefore = (before[1] - before[0]).cross(before[2] - before[0]);
+            const auto normalAfter = (after[1] - after[0]).cross(after[2] - after[0]);
+            if (normalBefore.dot(normalAfter) <= 0)
+                return true;
+        }
+        return false;
+    };
+
+    const auto targetTriangleCount = static_cast<u32>((std::max)(1.0f, liveTriangleCount * (std::max)(triangleRatio, 0.0f)));
+
+    while (liveTriangleCount > targetTriangleCount && !collapses.empty())
+    {
+        const auto collapse = collapses.top();
+        collapses.pop();
+
+        const auto from = collapse.from, to = collapse.to;
+        if (collapsed[from] || collapsed[to] ||
+            versions[from] != collapse.fromVersion || versions[to] != collapse.toVersion)
+            continue;
+
+        if (flipsTriangles(from, to))
+            continue;
+
+        for (const auto t: vertexTriangles[from])
+        {
+            auto &triangle = triangles[t];
+            if (triangle.removed)
+                continue;
+
+            auto &w = triangle.welded;
+            if (w[0] == to || w[1] == to || w[2] == to)
+            {
+                triangle.removed = true;
+                liveTriangleCount--;
+                continue;
+            }
+
+            for (u32 k = 0; k < 3; k++)
+            {
+                if (w[k] == from)
+                    w[k] = to;
+            }
+            vertexTriangles[to].push_back(t);
+        }
+
+        vertexTriangles[from].clear();
+        quadrics[to].add(quadrics[from]);
+        collapsed[from] = true;
+        versions[to]++;
+
+        // Edges of the merged vertex have changed their costs
+        vec<u32> neighbours;
+        auto &toTriangles = vertexTriangles[to];
+        toTriangles.erase(std::remove_if(toTriangles.begin(), toTriangles.end(),
+            [&](u32 t) { return triangles[t].removed; }), toTriangles.end());
+        for (const auto t: toTriangles)
+        {
+            for (const auto v: triangles[t].welded)
+            {
+                if (v != to)
+                    neighbours.push_back(v);
+            }
+        }
+        std::sort(neighbours.begin(), neighbours.end());
+        neighbours.erase(std::unique(neighbours.begin(), neighbours.end()), neighbours.end());
+        for (const auto n: neighbours)
+            pushCollapse(to, n);
+    }
+
+    // Vertices that kept their welded position keep their own attributes, the rest borrow
+    // those of the vertex they were collapsed into
+    vec<vec<u32>> indices(indexData_.size());
+    for (const auto &triangle: triangles)
+    {
+        if (triangle.removed)
+            continue;
+        for (u32 k = 0; k < 3; k++)
+        {
+            const auto v = triangle.vertices[k];
+            indices[triangle.part].push_back(weld[v] == triangle.welded[k] ? v : triangle.welded[k]);
+        }
+    }
+
+    // Drop vertices no longer referenced
+    const auto unused = ~0u;
+    vec<u32> remap(vertexCount_, unused);
+    result->vertexData_.clear();
+    result->vertexCount_ = 0;
+    result->partBounds_.clear();
+
+    for (auto &part: indices)
+    {
+        BoundingBox bounds;
+        for (auto &index: part)
+        {
+            if (remap[index] == unused)
+            {
+                remap[index] = result->vertexCount_++;
+                const auto src = vertexData_.begin() + index * stride;
+                result->vertexData_.insert(result->vertexData_.end(), src, src + stride);
+            }
+            bounds.include(position(index));
+            index = remap[index];
+        }
+        result->partBounds_.push_back(bounds);
+    }
+
+    result->indexData_ = std::move(indices);
+    result->optimize();
+
+    return result;
+}
+
+void MeshData::occluderGeometry(vec<float> &positions, vec<u32> &indices) const
+{
+    positions.clear();
+    indices.clear();
+
+    const auto offset = positionOffset(layout_);
+    if (offset < 0)
+        return;
+
+    const auto stride = layout_.elementCount();
+    vec<u32> remap(vertexCount_, (std::numeric_limits<u32>::max)());
+    for (const auto &part: indexData_)
+    {
+        for (size_t i = 0; i + 2 < part.size(); i += 3)
+        {
+            for (u32 j = 0; j < 3; j++)
+            {
+                const auto vertex = part[i + j];
+                if (remap[vertex] == (std::numeric_limits<u32>::max)())
+                {
+                    remap[vertex] = static_cast<u32>(positions.size() / 3);
+                    const auto p = vertexData_.data() + vertex * stride + offset;
+                    positions.insert(positions.end(), p, p + 3);
+                }
+                indices.push_back(remap[vertex]);
+            }
+        }
+    }
+}
+
+auto MeshData::packedVertexData() const -> vec<u8>
+{
+    const auto stride = layout_.elementCount();
+    vec<u8> result(static_cast<size_t>(layout_.size()) * vertexCount_);
+
+    for (u32 v = 0; v < vertexCount_; v++)
+    {
+        auto src = vertexData_.data() + v * stride;
+        const auto dst = result.data() + v * layout_.size();
+        for (u32 i = 0; i < layout_.attributeCount(); i++)
+        {
+            const auto attr = layout_.attribute(i);
+            VertexBufferLayout::packAttribute(attr, src, dst + attr.offset);
+            src += attr.elementCount;
+        }
+    }
+
+    return result;
+}
+
+void MeshData::optimize()
+{
+    const auto stride = layout_.elementCount();
+    sourceAcmr_ = acmr_ = partsAcmr(indexData_, vertexCount_);
+    if (stride && vertexCount_)
+        reorder(stride);
+
+    // Decided last, since welding and fetch reordering pull indices down
+    partIndexElementSizes_.clear();
+    for (const auto &part: indexData_)
+        partIndexElementSizes_.push_back(Mesh::smallestIndexElementSize(part.data(), static_cast<u32>(part.size())));
+}
+
+void MeshData::reorder(u32 stride)
+{
+    // Attributes the layout doesn't ask for are already dropped, so welding catches more than assimp's own joining
+    vertexCount_ = MeshOptimizer::weldVertices(vertexData_, stride, indexData_);
+
+    const auto positions = positionOffset(layout_);
+    for (auto &part: indexData_)
+    {
+        MeshOptimizer::optimizeVertexCache(part, vertexCount_);
+        if (positions >= 0)
+            MeshOptimizer::optimizeOverdraw(part, vertexData_, stride, positions);
+    }
+
+    vertexCount_ = MeshOptimizer::optimizeVertexFetch(vertexData_, stride, indexData_);
+    acmr_ = partsAcmr(indexData_, vertexCount_);
+}
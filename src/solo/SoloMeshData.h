@@ -7,25 +7,62 @@
 
 #include "SoloCommon.h"
 #include "SoloAsyncHandle.h"
+#include "SoloBoundingBox.h"
+#include "SoloVertexBufferLayout.h"
+#include "SoloMesh.h"
 
 namespace solo
 {
     class Device;
-    class VertexBufferLayout;
+    class FileSystem;
+    class CookedMesh;
 
     class MeshData
     {
     public:
+        // Prefers an up-to-date cooked sibling of the file that has all requested attributes in the requested formats
         static auto fromFile(Device *device, const str &path, const VertexBufferLayout &bufferLayout) -> sptr<MeshData>;
+        // Loads exactly the given file, for tools running without a device. Returns nullptr when the file can't be parsed
+        static auto fromFile(FileSystem *fs, const str &path, const VertexBufferLayout &bufferLayout) -> sptr<MeshData>;
         static auto fromFileAsync(Device *device, const str &path, const VertexBufferLayout &bufferLayout) -> sptr<AsyncHandle<MeshData>>;
+        // Unpacks the attributes of the requested layout, so cooked meshes can feed colliders and simplification too
+        static auto fromCooked(const CookedMesh &cooked, const VertexBufferLayout &bufferLayout) -> sptr<MeshData>;
 
-        auto vertexData() const -> const vec<float>& { return vertexData_; }
+        auto layout() const -> const VertexBufferLayout& { return layout_; }
+        // Unpacked, one float per component of each layout attribute regardless of its format
+        auto vertexData() const -> const vec<float>& { return vertexData_; }
+        // Vertices in the layout's formats, ready for uploading
+        auto packedVertexData() const -> vec<u8>;
         auto vertexCount() const -> u32 { return vertexCount_; }
         auto indexData() const -> const vec<vec<u32>>& { return indexData_; }
+        auto partBounds() const -> const vec<BoundingBox>& { return partBounds_; }
+        // Chosen on import, 16-bit for parts whose indices all fit
+        auto partIndexElementSize(u32 part) const -> IndexElementSize { return partIndexElementSizes_.at(part); }
+
+        // Average cache miss ratio of the parts as imported and after optimizing them
+        auto sourceAcmr() const -> float { return sourceAcmr_; }
+        auto acmr() const -> float { return acmr_; }
+
+        // Returns a copy reduced to roughly the given fraction of triangles by collapsing edges in order of
+        // their quadric error. Vertices are only ever merged into existing ones, so attributes other than
+        // positions need no interpolation. Positions are welded across parts and attribute seams, so those
+        // don't crack apart, and open borders are kept in place
+        auto simplified(float triangleRatio) const -> sptr<MeshData>;
+
+        // Positions of all parts as one triangle list for Mesh::setOccluderGeometry, leaving out unused vertices
+        void occluderGeometry(vec<float> &positions, vec<u32> &indices) const;
 
     private:
+        VertexBufferLayout layout_;
         vec<float> vertexData_;
         u32 vertexCount_ = 0;
         vec<vec<u32>> indexData_;
+        vec<BoundingBox> partBounds_;
+        vec<IndexElementSize> partIndexElementSizes_;
+        float sourceAcmr_ = 0;
+        float acmr_ = 0;
+
+        void optimize();
+        void reorder(u32 stride);
     };
 }
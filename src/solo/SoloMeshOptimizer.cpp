@@ -0,0 +1,331 @@
+/* 
+ * Copyright (c) Aleksey Fedotov 
+ * MIT license 
+ */
+
+#include "SoloMeshOptimizer.h"
+#include "SoloHash.h"
+#include "SoloVector3.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+using namespace solo;
+
+// Size of the LRU cache modelled by the scoring, larger than real FIFO caches as recommended by Forsyth
+static const u32 scoringCacheSize = 32;
+static const u32 unusedVertex = ~0u;
+
+static auto vertexScore(s32 cachePosition, u32 remainingTriangles) -> float
+{
+    if (!remainingTriangles)
+        return -1;
+
+    auto score = 0.0f;
+    if (cachePosition >= 0)
+    {
+        // Vertices of the last triangle get a fixed score so that it isn't immediately reused
+        if (cachePosition < 3)
+            score = 0.75f;
+        else
+            score = std::pow(1.0f - (cachePosition - 3) / static_cast<float>(scoringCacheSize - 3), 1.5f);
+    }
+
+    // Vertices with few triangles left are worth finishing off
+    return score + 2.0f / std::sqrt(static_cast<float>(remainingTriangles));
+}
+
+auto MeshOptimizer::acmr(const vec<u32> &indices, u32 vertexCount, u32 cacheSize) -> float
+{
+    const auto triangleCount = indices.size() / 3;
+    if (!triangleCount)
+        return 0;
+
+    // A vertex is cached while fewer than cacheSize misses happened since it was last transformed
+    vec<u32> timestamps(vertexCount, 0);
+    auto time = cacheSize + 1;
+    u32 misses = 0;
+    for (const auto index: indices)
+    {
+        if (index < vertexCount && time - timestamps[index] > cacheSize)
+        {
+            timestamps[index] = time++;
+            misses++;
+        }
+    }
+
+    return static_cast<float>(misses) / triangleCount;
+}
+
+auto MeshOptimizer::weldVertices(vec<float> &vertexData, u32 stride, vec<vec<u32>> &parts) -> u32
+{
+    const auto vertexCount = static_cast<u32>(vertexData.size() / stride);
+    const auto vertexSize = stride * sizeof(float);
+
+    umap<u64, vec<u32>> buckets;
+    vec<u32> remap(vertexCount);
+    vec<float> welded;
+    welded.reserve(vertexData.size());
+    u32 weldedCount = 0;
+
+    for (u32 v = 0; v < vertexCount; v++)
+    {
+        const auto src = vertexData.data() + v * stride;
+        auto &bucket = buckets[hashBytes(src, vertexSize)];
+        const auto match = std::find_if(bucket.begin(), bucket.end(),
+            [&](u32 w) { return !std::memcmp(welded.data() + w * stride, src, vertexSize); });
+
+        if (match != bucket.end())
+            remap[v] = *match;
+        else
+        {
+            welded.insert(welded.end(), src, src + stride);
+            bucket.push_back(weldedCount);
+            remap[v] = weldedCount++;
+        }
+    }
+
+    for (auto &part: parts)
+    {
+        for (auto &index: part)
+            index = remap[index];
+    }
+
+    vertexData = std::move(welded);
+    return weldedCount;
+}
+
+void MeshOptimizer::optimizeVertexCache(vec<u32> &indices, u32 vertexCount)
+{
+    const auto triangleCount = static_cast<u32>(indices.size() / 3);
+    if (triangleCount < 2)
+        return;
+
+    // Not yet emitted triangles of each vertex, packed into one array
+    vec<u32> remaining(vertexCount, 0);
+    for (u32 i = 0; i < triangleCount * 3; i++)
+        remaining[indices[i]]++;
+
+    vec<u32> offsets(vertexCount + 1, 0);
+    for (u32 v = 0; v < vertexCount; v++)
+        offsets[v + 1] = offsets[v] + remaining[v];
+
+    vec<u32> adjacency(triangleCount * 3);
+    vec<u32> fill(offsets.begin(), offsets.end() - 1);
+    for (u32 t = 0; t < triangleCount; t++)
+    {
+        for (u32 k = 0; k < 3; k++)
+            adjacency[fill[indices[t * 3 + k]]++] = t;
+    }
+
+    vec<s32> cachePositions(vertexCount, -1);
+    vec<float> vertexScores(vertexCount);
+    for (u32 v = 0; v < vertexCount; v++)
+        vertexScores[v] = vertexScore(-1, remaining[v]);
+
+    const auto triangleScore = [&](u32 t)
+    {
+        return vertexScores[indices[t * 3]] + vertexScores[indices[t * 3 + 1]] + vertexScores[indices[t * 3 + 2]];
+    };
+
+    vec<float> triangleScores(triangleCount);
+    s32 best = 0;
+    for (u32 t = 0; t < triangleCount; t++)
+    {
+        triangleScores[t] = triangleScore(t);
+        if (triangleScores[t] > triangleScores[best])
+            best = t;
+    }
+
+    vec<bool> emitted(triangleCount, false);
+    vec<u32> cache, newCache;
+    cache.reserve(scoringCacheSize + 3);
+    newCache.reserve(scoringCacheSize + 3);
+    vec<u32> result;
+    result.reserve(triangleCount * 3);
+    u32 nextUnemitted = 0;
+
+    for (u32 n = 0; n < triangleCount; n++)
+    {
+        if (best < 0)
+        {
+            // Nothing adjacent to the cache is left, so any triangle is as good as another
+            while (emitted[nextUnemitted])
+                nextUnemitted++;
+            best = nextUnemitted;
+        }
+
+        const auto triangle = indices.data() + best * 3;
+        emitted[best] = true;
+        newCache.clear();
+
+        for (u32 k = 0; k < 3; k++)
+        {
+            const auto v = triangle[k];
+            result.push_back(v);
+            newCache.push_back(v);
+
+            const auto begin = adjacency.begin() + offsets[v];
+            const auto end = begin + remaining[v];
+            std::iter_swap(std::find(begin, end, static_cast<u32>(best)), end - 1);
+            remaining[v]--;
+        }
+
+        for (const auto v: cache)
+        {
+            if (v != triangle[0] && v != triangle[1] && v != triangle[2])
+                newCache.push_back(v);
+        }
+
+        for (u32 i = 0; i < newCache.size(); i++)
+        {
+            const auto v = newCache[i];
+            cachePositions[v] = i < scoringCacheSize ? static_cast<s32>(i) : -1;
+            vertexScores[v] = vertexScore(cachePositions[v], remaining[v]);
+        }
+
+        if (newCache.size() > scoringCacheSize)
+            newCache.resize(scoringCacheSize);
+        std::swap(cache, newCache);
+
+        // Only triangles touching the cache changed their scores
+        best = -1;
+        auto bestScore = -1.0f;
+        for (const auto v: cache)
+        {
+            for (u32 i = 0; i < remaining[v]; i++)
+            {
+                const auto t = adjacency[offsets[v] + i];
+                triangleScores[t] = triangleScore(t);
+                if (triangleScores[t] > bestScore)
+                {
+                    bestScore = triangleScores[t];
+                    best = t;
+                }
+            }
+        }
+    }
+
+    indices = std::move(result);
+}
+
+void MeshOptimizer::optimizeOverdraw(vec<u32> &indices, const vec<float> &vertexData, u32 stride, u32 positionOffset,
+    u32 cacheSize)
+{
+    const auto triangleCount = static_cast<u32>(indices.size() / 3);
+    const auto vertexCount = static_cast<u32>(vertexData.size() / stride);
+    if (triangleCount < 2)
+        return;
+
+    const auto position = [&](u32 vertex)
+    {
+        const auto p = vertexData.data() + vertex * stride + positionOffset;
+        return Vector3(p[0], p[1], p[2]);
+    };
+
+    // A cluster starts with each triangle whose vertices all miss the cache
+    vec<u32> clusterStarts;
+    vec<u32> timestamps(vertexCount, 0);
+    auto time = cacheSize + 1;
+    for (u32 t = 0; t < triangleCount; t++)
+    {
+        u32 misses = 0;
+        for (u32 k = 0; k < 3; k++)
+        {
+            const auto v = indices[t * 3 + k];
+            if (time - timestamps[v] > cacheSize)
+            {
+                timestamps[v] = time++;
+                misses++;
+            }
+        }
+
+        if (t == 0 || misses == 3)
+            clusterStarts.push_back(t);
+    }
+
+    if (clusterStarts.size() < 2)
+        return;
+    clusterStarts.push_back(triangleCount);
+
+    const auto clusterCount = static_cast<u32>(clusterStarts.size() - 1);
+    vec<Vector3> clusterCentroids(clusterCount, Vector3(0));
+    vec<Vector3> clusterNormals(clusterCount, Vector3(0));
+    auto meshCentroid = Vector3(0);
+    auto meshArea = 0.0f;
+
+    for (u32 c = 0; c < clusterCount; c++)
+    {
+        auto clusterArea = 0.0f;
+        for (auto t = clusterStarts[c]; t < clusterStarts[c + 1]; t++)
+        {
+            const auto p0 = position(indices[t * 3]);
+            const auto p1 = position(indices[t * 3 + 1]);
+            const auto p2 = position(indices[t * 3 + 2]);
+            const auto normal = (p1 - p0).cross(p2 - p0);
+            const auto area = normal.length();
+            const auto centroid = (p0 + p1 + p2) / 3;
+
+            clusterNormals[c] += normal;
+            clusterCentroids[c] += centroid * area;
+            clusterArea += area;
+        }
+
+        meshCentroid += clusterCentroids[c];
+        meshArea += clusterArea;
+        if (clusterArea > 0)
+            clusterCentroids[c] /= clusterArea;
+    }
+
+    if (meshArea > 0)
+        meshCentroid /= meshArea;
+
+    // Clusters facing away from the center are likely to occlude the ones facing towards it
+    vec<float> sortKeys(clusterCount);
+    for (u32 c = 0; c < clusterCount; c++)
+    {
+        const auto normalLength = clusterNormals[c].length();
+        sortKeys[c] = normalLength > 0
+            ? (clusterCentroids[c] - meshCentroid).dot(clusterNormals[c] / normalLength)
+            : 0;
+    }
+
+    vec<u32> order(clusterCount);
+    for (u32 c = 0; c < clusterCount; c++)
+        order[c] = c;
+    std::stable_sort(order.begin(), order.end(), [&](u32 a, u32 b) { return sortKeys[a] > sortKeys[b]; });
+
+    vec<u32> result;
+    result.reserve(indices.size());
+    for (const auto c: order)
+        result.insert(result.end(), indices.begin() + clusterStarts[c] * 3, indices.begin() + clusterStarts[c + 1] * 3);
+
+    indices = std::move(result);
+}
+
+auto MeshOptimizer::optimizeVertexFetch(vec<float> &vertexData, u32 stride, vec<vec<u32>> &parts) -> u32
+{
+    const auto vertexCount = static_cast<u32>(vertexData.size() / stride);
+
+    vec<u32> remap(vertexCount, unusedVertex);
+    vec<float> reordered;
+    reordered.reserve(vertexData.size());
+    u32 reorderedCount = 0;
+
+    for (auto &part: parts)
+    {
+        for (auto &index: part)
+        {
+            if (remap[index] == unusedVertex)
+            {
+                const auto src = vertexData.begin() + index * stride;
+                reordered.insert(reordered.end(), src, src + stride);
+                remap[index] = reorderedCount++;
+            }
+            index = remap[index];
+        }
+    }
+
+    vertexData = std::move(reordered);
+    return reorderedCount;
+}
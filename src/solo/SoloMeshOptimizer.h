@@ -0,0 +1,36 @@
+/* 
+ * Copyright (c) Aleksey Fedotov 
+ * MIT license 
+ */
+
+#pragma once
+
+#include "SoloCommon.h"
+
+namespace solo
+{
+    // Index and vertex reordering for triangle lists. Vertices are tightly packed floats, stride elements each
+    class MeshOptimizer final
+    {
+    public:
+        static const u32 defaultCacheSize = 16;
+
+        // Average count of vertices transformed per triangle with a FIFO post-transform cache of the given size.
+        // 0.5 is the ideal for regular grids, 3 means no reuse at all
+        static auto acmr(const vec<u32> &indices, u32 vertexCount, u32 cacheSize = defaultCacheSize) -> float;
+
+        // Merges vertices with bitwise identical data, remapping part indices. Returns the new vertex count
+        static auto weldVertices(vec<float> &vertexData, u32 stride, vec<vec<u32>> &parts) -> u32;
+
+        // Reorders triangles for post-transform cache reuse (Forsyth's linear-speed algorithm)
+        static void optimizeVertexCache(vec<u32> &indices, u32 vertexCount);
+
+        // Splits cache-optimized triangles into clusters where the cache starts cold anyway and sorts them
+        // so that outward-facing clusters draw first, which keeps the cache order within clusters intact
+        static void optimizeOverdraw(vec<u32> &indices, const vec<float> &vertexData, u32 stride, u32 positionOffset,
+            u32 cacheSize = defaultCacheSize);
+
+        // Reorders vertices in the order of first use, dropping unreferenced ones. Returns the new vertex count
+        static auto optimizeVertexFetch(vec<float> &vertexData, u32 stride, vec<vec<u32>> &parts) -> u32;
+    };
+}
@@ -8,6 +8,9 @@
 #include "SoloMaterial.h"
 #include "SoloTransform.h"
 #include "SoloDevice.h"
+#include "SoloRenderer.h"
+#include "SoloCamera.h"
+#include "SoloLodGroup.h"
 
 using namespace solo;
 
@@ -16,6 +19,7 @@ MeshRenderer::MeshRenderer(const Node &node):
     renderer_(node.scene()->device()->renderer())
 {
     transform_ = node.findComponent<Transform>();
+    lodGroup_ = node.findComponent<LodGroup>();
 }
 
 auto MeshRenderer::material(u32 index) const -> sptr<Material>
@@ -29,24 +33,75 @@ void MeshRenderer::render()
     if (!mesh_)
         return;
 
-    const auto partCount = mesh_->partCount();
+    auto mesh = mesh_.get();
+    const auto camera = renderer_->currentCamera();
+    if (camera && lodGroup_ && lodGroup_->levelCount())
+    {
+        const auto level = lodGroup_->selectLevel(camera, worldBounds());
+        if (level < 0)
+            return;
+        mesh = lodGroup_->levelMesh(level).get();
+    }
+
+    // Culling uses the bounds of the renderer's own mesh, which enclose its simplified levels
+    const auto partCount = mesh->partCount();
     if (partCount == 0)
     {
         const auto mat = material(0);
-        if (mat)
-            renderer_->drawMesh(mesh_.get(), transform_, mat.get());
+        if (mat && !isCulled(worldBounds()))
+            renderer_->drawMesh(mesh, transform_, mat.get());
     }
     else
     {
         for (u32 part = 0; part < partCount; ++part)
         {
             const auto mat = material(part);
-            if (mat)
-                renderer_->drawMeshPart(mesh_.get(), part, transform_, mat.get());
+            if (mat && !isCulled(worldPartBounds(part)))
+                renderer_->drawMeshPart(mesh, part, transform_, mat.get());
         }
     }
 }
 
+auto MeshRenderer::worldBounds() const -> const BoundingBox&
+{
+    updateWorldBounds();
+    return worldBounds_;
+}
+
+auto MeshRenderer::worldPartBounds(u32 part) const -> const BoundingBox&
+{
+    updateWorldBounds();
+    return part < worldPartBounds_.size() ? worldPartBounds_[part] : worldBounds_;
+}
+
+void MeshRenderer::updateWorldBounds() const
+{
+    if (!mesh_ || !transform_)
+        return;
+
+    const auto mesh = mesh_.get();
+    if (boundsMesh_ == mesh && boundsMeshVersion_ == mesh->boundsVersion() && boundsTransformVersion_ == transform_->version())
+        return;
+
+    const auto worldMatrix = transform_->worldMatrix();
+    worldBounds_ = mesh->bounds().transformed(worldMatrix);
+    worldPartBounds_.resize(mesh->partCount());
+    for (u32 part = 0; part < mesh->partCount(); part++)
+        worldPartBounds_[part] = mesh->partBounds(part).transformed(worldMatrix);
+
+    boundsMesh_ = mesh;
+    boundsMeshVersion_ = mesh->boundsVersion();
+    boundsTransformVersion_ = transform_->version();
+    worldBoundsVersion_++;
+}
+
+bool MeshRenderer::isCulled(const BoundingBox &worldBounds) const
+{
+    // Empty bounds mean the mesh had no position data to compute them from
+    const auto camera = renderer_->currentCamera();
+    return frustumCulling_ && camera && !worldBounds.isEmpty() && !camera->isVisible(worldBounds, occludee_);
+}
+
 void MeshRenderer::setMaterial(u32 index, sptr<Material> material)
 {
     if (index >= materials_.size())
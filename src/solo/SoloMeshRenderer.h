@@ -8,6 +8,7 @@
 #include "SoloCommon.h"
 #include "SoloComponent.h"
 #include "SoloNode.h"
+#include "SoloBoundingBox.h"
 
 namespace solo
 {
@@ -15,6 +16,7 @@ namespace solo
     class Mesh;
     class Transform;
     class Renderer;
+    class LodGroup;
 
     class MeshRenderer final: public ComponentBase<MeshRenderer>
     {
@@ -31,12 +33,49 @@ namespace solo
         void setMaterial(u32 index, sptr<Material> material);
         void setDefaultMaterial(sptr<Material> material);
 
+        // Disable for meshes whose effects don't place them by the node transform, e.g. screen-space quads
+        bool hasFrustumCulling() const { return frustumCulling_; }
+        void setFrustumCulling(bool enabled) { frustumCulling_ = enabled; }
+
+        // Occluders hide other renderers from cameras with occlusion culling, using the mesh occluder geometry
+        bool isOccluder() const { return occluder_; }
+        void setOccluder(bool occluder) { occluder_ = occluder; }
+
+        // Occludees are skipped by cameras with occlusion culling when hidden behind occluders
+        bool isOccludee() const { return occludee_; }
+        void setOccludee(bool occludee) { occludee_ = occludee; }
+
+        auto transform() const -> Transform* { return transform_; }
+
+        // World-space bounds of the whole mesh, kept up to date with the transform
+        auto worldBounds() const -> const BoundingBox&;
+        auto worldPartBounds(u32 part) const -> const BoundingBox&;
+        // Changes whenever world bounds get recomputed
+        auto worldBoundsVersion() const -> u32 { return worldBoundsVersion_; }
+
     private:
+        // Keeps lodGroup_ in sync as the group is added to or removed from the node
+        friend class LodGroup;
+
         sptr<Mesh> mesh_;
         Transform *transform_ = nullptr;
+        LodGroup *lodGroup_ = nullptr;
         Renderer *renderer_ = nullptr;
         sptr<Material> defaultMaterial_ = nullptr;
         vec<sptr<Material>> materials_;
         u32 materialCount_ = 0;
+        bool frustumCulling_ = true;
+        bool occluder_ = false;
+        bool occludee_ = false;
+
+        mutable BoundingBox worldBounds_;
+        mutable vec<BoundingBox> worldPartBounds_;
+        mutable const Mesh *boundsMesh_ = nullptr;
+        mutable u32 boundsMeshVersion_ = ~0;
+        mutable u32 boundsTransformVersion_ = ~0;
+        mutable u32 worldBoundsVersion_ = 0;
+
+        void updateWorldBounds() const;
+        bool isCulled(const BoundingBox &worldBounds) const;
     };
 }
\ No newline at end of file
@@ -0,0 +1,283 @@
+/* 
+ * Copyright (c) Aleksey Fedotov 
+ * MIT license 
+ */
+
+#include "SoloOcclusionBuffer.h"
+#include "SoloBoundingBox.h"
+#include "SoloWorkerPool.h"
+#include <algorithm>
+#include <cmath>
+
+#if defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+#   define SL_OCCLUSION_SSE
+#   include <xmmintrin.h>
+#endif
+
+using namespace solo;
+
+// Vertices closer to the camera plane than this are not rasterized
+static const float minClipW = 1e-4f;
+
+// Splitting the screen into bands isn't worth it for a handful of triangles
+static const u32 minTrianglesPerThread = 64;
+
+OcclusionBuffer::OcclusionBuffer(u32 width, u32 height, WorkerPool *workers):
+    // Rows are rasterized four pixels at a time
+    width_((std::max(width, 4u) + 3) & ~3u),
+    height_(std::max(height, 1u)),
+    workers_(workers)
+{
+    auto levelWidth = width_;
+    auto levelHeight = height_;
+    while (true)
+    {
+        levels_.push_back({levelWidth, levelHeight, vec<float>(levelWidth * levelHeight)});
+        if (levelWidth == 1 && levelHeight == 1)
+            break;
+        levelWidth = (levelWidth + 1) / 2;
+        levelHeight = (levelHeight + 1) / 2;
+    }
+}
+
+void OcclusionBuffer::begin(const Matrix &viewProjection)
+{
+    viewProjection_ = viewProjection;
+    triangles_.clear();
+    ready_ = false;
+}
+
+void OcclusionBuffer::addOccluder(const Matrix &world, const vec<float> &positions, const vec<u32> &indices)
+{
+    const auto mvp = viewProjection_ * world;
+    const auto m = mvp.columns();
+
+    // Screen-space x, y, depth and whether the vertex is in front of the camera
+    const auto vertexCount = static_cast<u32>(positions.size() / 3);
+    projected_.resize(vertexCount * 4);
+    for (u32 i = 0; i < vertexCount; i++)
+    {
+        const auto px = positions[i * 3], py = positions[i * 3 + 1], pz = positions[i * 3 + 2];
+        const auto x = m[0] * px + m[4] * py + m[8] * pz + m[12];
+        const auto y = m[1] * px + m[5] * py + m[9] * pz + m[13];
+        const auto z = m[2] * px + m[6] * py + m[10] * pz + m[14];
+        const auto w = m[3] * px + m[7] * py + m[11] * pz + m[15];
+        const auto valid = w > minClipW;
+        const auto invW = valid ? 1 / w : 0;
+
+        auto dst = projected_.data() + i * 4;
+        dst[0] = (x * invW * 0.5f + 0.5f) * width_;
+        dst[1] = (y * invW * 0.5f + 0.5f) * height_;
+        dst[2] = z * invW;
+        dst[3] = valid ? 1.0f : 0.0f;
+    }
+
+    for (size_t i = 0; i + 2 < indices.size(); i += 3)
+    {
+        if (indices[i] >= vertexCount || indices[i + 1] >= vertexCount || indices[i + 2] >= vertexCount)
+            continue;
+
+        const float *v[] = {
+            projected_.data() + indices[i] * 4,
+            projected_.data() + indices[i + 1] * 4,
+            projected_.data() + indices[i + 2] * 4
+        };
+
+        // Triangles crossing the camera plane would need clipping. Dropping them only makes culling less effective
+        if (!v[0][3] || !v[1][3] || !v[2][3])
+            continue;
+
+        Triangle triangle;
+        for (u32 j = 0; j < 3; j++)
+        {
+            triangle.x[j] = v[j][0];
+            triangle.y[j] = v[j][1];
+            triangle.z[j] = v[j][2];
+        }
+        triangles_.push_back(triangle);
+    }
+}
+
+void OcclusionBuffer::finish()
+{
+    auto &depth = levels_[0].depth;
+    std::fill(depth.begin(), depth.end(), (std::numeric_limits<float>::max)());
+
+    const auto triangleCount = static_cast<u32>(triangles_.size());
+    const auto threadCount = workers_ ? workers_->threadCount() : 1;
+    const auto bandCount = std::max(1u, std::min({threadCount, height_, triangleCount / minTrianglesPerThread}));
+    const auto rowsPerBand = (height_ + bandCount - 1) / bandCount;
+
+    // Bands don't share any pixels, so they're rasterized without synchronization.
+    // Few triangles mean a single band, which stays on the calling thread without waking any worker
+    const auto rasterizeBand = [this, rowsPerBand](u32 band)
+    {
+        const auto firstRow = std::min(band * rowsPerBand, height_);
+        rasterize(firstRow, std::min(firstRow + rowsPerBand, height_));
+    };
+    if (bandCount > 1)
+        workers_->run(bandCount, rasterizeBand);
+    else
+        rasterizeBand(0);
+
+    buildPyramid();
+    ready_ = true;
+}
+
+void OcclusionBuffer::rasterize(u32 firstRow, u32 lastRow)
+{
+    auto depth = levels_[0].depth.data();
+
+    for (const auto &t: triangles_)
+    {
+        const auto minX = std::max(0.0f, std::floor(std::min({t.x[0], t.x[1], t.x[2]})));
+        const auto maxX = std::min(width_ - 1.0f, std::ceil(std::max({t.x[0], t.x[1], t.x[2]})));
+        const auto minY = std::max(static_cast<float>(firstRow), std::floor(std::min({t.y[0], t.y[1], t.y[2]})));
+        const auto maxY = std::min(lastRow - 1.0f, std::ceil(std::max({t.y[0], t.y[1], t.y[2]})));
+        if (minX > maxX || minY > maxY)
+            continue;
+
+        const auto area = (t.x[1] - t.x[0]) * (t.y[2] - t.y[0]) - (t.x[2] - t.x[0]) * (t.y[1] - t.y[0]);
+        if (std::abs(area) < 1e-6f)
+            continue;
+
+        // Edge functions are oriented so that the inside is positive regardless of winding
+        const auto sign = area > 0 ? 1.0f : -1.0f;
+        float a[3], b[3], c[3];
+        for (u32 i = 0; i < 3; i++)
+        {
+            const auto j = (i + 1) % 3;
+            a[i] = (t.y[i] - t.y[j]) * sign;
+            b[i] = (t.x[j] - t.x[i]) * sign;
+            c[i] = (t.x[i] * t.y[j] - t.x[j] * t.y[i]) * sign;
+        }
+
+        // Depth is linear in screen space
+        const auto dzdx = ((t.z[1] - t.z[0]) * (t.y[2] - t.y[0]) - (t.z[2] - t.z[0]) * (t.y[1] - t.y[0])) / area;
+        const auto dzdy = ((t.z[2] - t.z[0]) * (t.x[1] - t.x[0]) - (t.z[1] - t.z[0]) * (t.x[2] - t.x[0])) / area;
+        const auto dz = t.z[0] - dzdx * t.x[0] - dzdy * t.y[0];
+
+        // Rows start at a multiple of four so that groups of pixels never cross the end of the row
+        const auto startX = static_cast<u32>(minX) & ~3u;
+        const auto endX = static_cast<u32>(maxX);
+
+        for (auto y = static_cast<u32>(minY); y <= static_cast<u32>(maxY); y++)
+        {
+            const auto py = y + 0.5f;
+            const auto row = depth + y * width_;
+
+#ifdef SL_OCCLUSION_SSE
+            const auto e0Row = _mm_set1_ps(b[0] * py + c[0]);
+            const auto e1Row = _mm_set1_ps(b[1] * py + c[1]);
+            const auto e2Row = _mm_set1_ps(b[2] * py + c[2]);
+            const auto zRow = _mm_set1_ps(dzdy * py + dz);
+            const auto a0 = _mm_set1_ps(a[0]), a1 = _mm_set1_ps(a[1]), a2 = _mm_set1_ps(a[2]);
+            const auto zdx = _mm_set1_ps(dzdx);
+            const auto zero = _mm_setzero_ps();
+
+            for (auto x = startX; x <= endX; x += 4)
+            {
+                const auto px = _mm_add_ps(_mm_set1_ps(static_cast<float>(x)), _mm_set_ps(3.5f, 2.5f, 1.5f, 0.5f));
+                const auto e0 = _mm_add_ps(_mm_mul_ps(a0, px), e0Row);
+                const auto e1 = _mm_add_ps(_mm_mul_ps(a1, px), e1Row);
+                const auto e2 = _mm_add_ps(_mm_mul_ps(a2, px), e2Row);
+                const auto inside = _mm_and_ps(_mm_cmpge_ps(e0, zero), _mm_and_ps(_mm_cmpge_ps(e1, zero), _mm_cmpge_ps(e2, zero)));
+                if (!_mm_movemask_ps(inside))
+                    continue;
+
+                const auto z = _mm_add_ps(_mm_mul_ps(zdx, px), zRow);
+                const auto stored = _mm_loadu_ps(row + x);
+                const auto nearest = _mm_min_ps(stored, z);
+                _mm_storeu_ps(row + x, _mm_or_ps(_mm_and_ps(inside, nearest), _mm_andnot_ps(inside, stored)));
+            }
+#else
+            for (auto x = startX; x <= endX; x++)
+            {
+                const auto px = x + 0.5f;
+                if (a[0] * px + b[0] * py + c[0] < 0 || a[1] * px + b[1] * py + c[1] < 0 || a[2] * px + b[2] * py + c[2] < 0)
+                    continue;
+                row[x] = std::min(row[x], dzdx * px + dzdy * py + dz);
+            }
+#endif
+        }
+    }
+}
+
+void OcclusionBuffer::buildPyramid()
+{
+    for (u32 i = 1; i < levels_.size(); i++)
+    {
+        const auto &src = levels_[i - 1];
+        auto &dst = levels_[i];
+        for (u32 y = 0; y < dst.height; y++)
+        {
+            const auto y0 = y * 2;
+            const auto y1 = std::min(y0 + 1, src.height - 1);
+            for (u32 x = 0; x < dst.width; x++)
+            {
+                const auto x0 = x * 2;
+                const auto x1 = std::min(x0 + 1, src.width - 1);
+                dst.depth[y * dst.width + x] = std::max(
+                    std::max(src.depth[y0 * src.width + x0], src.depth[y0 * src.width + x1]),
+                    std::max(src.depth[y1 * src.width + x0], src.depth[y1 * src.width + x1]));
+            }
+        }
+    }
+}
+
+bool OcclusionBuffer::isOccluded(const BoundingBox &worldBounds) const
+{
+    if (!ready_ || worldBounds.isEmpty() || worldBounds.isInfinite())
+        return false;
+
+    const auto m = viewProjection_.columns();
+    const auto min = worldBounds.min(), max = worldBounds.max();
+
+    auto minX = (std::numeric_limits<float>::max)(), minY = minX, minZ = minX;
+    auto maxX = std::numeric_limits<float>::lowest(), maxY = maxX;
+    for (u32 i = 0; i < 8; i++)
+    {
+        const auto px = i & 1 ? max.x() : min.x();
+        const auto py = i & 2 ? max.y() : min.y();
+        const auto pz = i & 4 ? max.z() : min.z();
+        const auto w = m[3] * px + m[7] * py + m[11] * pz + m[15];
+
+        // Boxes reaching behind the camera are never reported as occluded
+        if (w <= minClipW)
+            return false;
+
+        const auto x = ((m[0] * px + m[4] * py + m[8] * pz + m[12]) / w * 0.5f + 0.5f) * width_;
+        const auto y = ((m[1] * px + m[5] * py + m[9] * pz + m[13]) / w * 0.5f + 0.5f) * height_;
+        const auto z = (m[2] * px + m[6] * py + m[10] * pz + m[14]) / w;
+        minX = std::min(minX, x);
+        maxX = std::max(maxX, x);
+        minY = std::min(minY, y);
+        maxY = std::max(maxY, y);
+        minZ = std::min(minZ, z);
+    }
+
+    const auto x0 = static_cast<s32>(std::max(0.0f, std::floor(minX)));
+    const auto x1 = static_cast<s32>(std::min(width_ - 1.0f, std::floor(maxX)));
+    const auto y0 = static_cast<s32>(std::max(0.0f, std::floor(minY)));
+    const auto y1 = static_cast<s32>(std::min(height_ - 1.0f, std::floor(maxY)));
+    if (x0 > x1 || y0 > y1)
+        return false;
+
+    // The level where the box covers about two texels in each direction, so only a few of them are read
+    const auto size = static_cast<u32>(std::max(x1 - x0, y1 - y0) + 1);
+    u32 level = 0;
+    while ((size >> level) > 2 && level + 1 < levels_.size())
+        level++;
+
+    const auto &l = levels_[level];
+    for (auto y = static_cast<u32>(y0) >> level; y <= static_cast<u32>(y1) >> level; y++)
+    {
+        for (auto x = static_cast<u32>(x0) >> level; x <= static_cast<u32>(x1) >> level; x++)
+        {
+            if (l.depth[y * l.width + x] >= minZ)
+                return false;
+        }
+    }
+
+    return true;
+}
@@ -0,0 +1,61 @@
+/* 
+ * Copyright (c) Aleksey Fedotov 
+ * MIT license 
+ */
+
+#pragma once
+
+#include "SoloCommon.h"
+#include "SoloMatrix.h"
+
+namespace solo
+{
+    class BoundingBox;
+    class WorkerPool;
+
+    // Low-resolution software depth buffer for occlusion culling. Occluder triangles are rasterized on the CPU,
+    // in horizontal bands spread over the given workers, and reduced into a pyramid of farthest depths (Hi-Z).
+    // Boxes are then reported as occluded when they're behind everything in the pyramid texels they cover
+    class OcclusionBuffer final: public NoCopyAndMove
+    {
+    public:
+        // Without workers everything is rasterized on the calling thread
+        OcclusionBuffer(u32 width, u32 height, WorkerPool *workers);
+
+        void begin(const Matrix &viewProjection);
+        // Positions are xyz triplets in the space transformed by world, indices form a triangle list.
+        // Triangles referencing missing vertices are skipped
+        void addOccluder(const Matrix &world, const vec<float> &positions, const vec<u32> &indices);
+        void finish();
+
+        bool isOccluded(const BoundingBox &worldBounds) const;
+
+    private:
+        struct Triangle
+        {
+            float x[3];
+            float y[3];
+            float z[3];
+        };
+
+        // Each texel keeps the farthest depth of the 2x2 texels below it
+        struct Level
+        {
+            u32 width;
+            u32 height;
+            vec<float> depth;
+        };
+
+        u32 width_;
+        u32 height_;
+        WorkerPool *workers_;
+        Matrix viewProjection_;
+        vec<float> projected_;
+        vec<Triangle> triangles_;
+        vec<Level> levels_; // level 0 is the depth buffer itself
+        bool ready_ = false;
+
+        void rasterize(u32 firstRow, u32 lastRow);
+        void buildPyramid();
+    };
+}
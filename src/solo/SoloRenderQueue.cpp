@@ -0,0 +1,179 @@
+/* 
+ * Copyright (c) Aleksey Fedotov 
+ * MIT license 
+ */
+
+#include "SoloRenderQueue.h"
+#include "SoloCamera.h"
+#include "SoloTransform.h"
+#include "SoloMaterial.h"
+#include "SoloEffect.h"
+#include <algorithm>
+
+using namespace solo;
+
+// Folds a pointer into a small id. Collisions only make sorting less effective, never incorrect
+static auto foldPointer(const void *ptr, u32 bits) -> u64
+{
+    auto x = static_cast<u64>(reinterpret_cast<uintptr_t>(ptr));
+    x ^= x >> 33;
+    x *= 0xff51afd7ed558ccdull;
+    x ^= x >> 33;
+    return x & ((1ull << bits) - 1);
+}
+
+static auto quantizeDepth(const Camera *camera, const Transform *transform, u32 bits) -> u64
+{
+    const auto max = (1ull << bits) - 1;
+    if (!camera || !transform)
+        return 0;
+    const auto distance = transform->worldPosition().distance(camera->transform()->worldPosition());
+    const auto normalized = (std::min)((std::max)(distance / camera->zFar(), 0.0f), 1.0f);
+    return static_cast<u64>(normalized * max);
+}
+
+static auto effectiveOrder(const Material *material) -> RenderOrder
+{
+    const auto order = material->renderOrder();
+    return order == RenderOrder::Opaque && material->hasBlend() ? RenderOrder::Transparent : order;
+}
+
+void RenderQueue::begin(const Camera *camera)
+{
+    camera_ = camera;
+    packets_.clear();
+    explicitInstances_.clear();
+    batches_.clear();
+    instanceTransforms_.clear();
+    sequence_ = 0;
+}
+
+void RenderQueue::add(Mesh *mesh, s32 part, Transform *transform, Material *material)
+{
+    addPacket(mesh, part, transform, material, 0, 0);
+}
+
+void RenderQueue::addInstanced(Mesh *mesh, s32 part, Material *material, const vec<Transform*> &transforms)
+{
+    if (transforms.empty())
+        return;
+    const auto firstInstance = static_cast<u32>(explicitInstances_.size());
+    explicitInstances_.insert(explicitInstances_.end(), transforms.begin(), transforms.end());
+    addPacket(mesh, part, transforms.front(), material, firstInstance, static_cast<u32>(transforms.size()));
+}
+
+void RenderQueue::addPacket(Mesh *mesh, s32 part, Transform *transform, Material *material, u32 firstInstance, u32 instanceCount)
+{
+    const auto order = effectiveOrder(material);
+    const auto effect = material->effect().get();
+
+    // Bit layout below the top 2 bits of render order depends on the order itself
+    u64 key = static_cast<u64>(order) << 62;
+    switch (order)
+    {
+        case RenderOrder::Opaque:
+            key |= foldPointer(effect, 14) << 48;
+            key |= foldPointer(material, 14) << 34;
+            key |= foldPointer(mesh, 12) << 22;
+            key |= static_cast<u64>(part & 3) << 20;
+            key |= quantizeDepth(camera_, transform, 20);
+            break;
+        case RenderOrder::Transparent:
+            key |= (((1ull << 24) - 1) - quantizeDepth(camera_, transform, 24)) << 38;
+            key |= foldPointer(effect, 12) << 26;
+            key |= foldPointer(material, 12) << 14;
+            key |= foldPointer(mesh, 14);
+            break;
+        default:
+            // Background and overlay draws keep the submission order
+            key |= static_cast<u64>(sequence_) << 30;
+            break;
+    }
+
+    packets_.push_back({key, mesh, transform, material, part, firstInstance, instanceCount});
+    sequence_++;
+}
+
+void RenderQueue::sort()
+{
+    stats_.drawCount += static_cast<u32>(packets_.size());
+    stats_.submittedStateChanges += countStateChanges();
+
+    // LSD radix sort, one byte per pass. It's stable, so draws with equal keys keep the submission order.
+    // Passes over bytes that are the same in all keys are skipped, which are most of them in small queues
+    const auto count = packets_.size();
+    sortBuffer_.resize(count);
+    for (u32 shift = 0; shift < 64; shift += 8)
+    {
+        size_t offsets[256] = {};
+        for (const auto &packet: packets_)
+            offsets[(packet.key >> shift) & 0xff]++;
+        if (std::find(std::begin(offsets), std::end(offsets), count) != std::end(offsets))
+            continue;
+
+        size_t total = 0;
+        for (auto &offset: offsets)
+        {
+            const auto size = offset;
+            offset = total;
+            total += size;
+        }
+
+        for (const auto &packet: packets_)
+            sortBuffer_[offsets[(packet.key >> shift) & 0xff]++] = packet;
+        std::swap(packets_, sortBuffer_);
+    }
+
+    stats_.sortedStateChanges += countStateChanges();
+
+    buildBatches();
+    stats_.batchCount += static_cast<u32>(batches_.size());
+}
+
+void RenderQueue::buildBatches()
+{
+    for (const auto &packet: packets_)
+    {
+        const auto explicitInstances = explicitInstances_.data() + packet.firstInstance;
+
+        if (!packet.material->effect()->isInstanced())
+        {
+            // The effect can't take per-instance transforms, so explicitly instanced draws are split
+            if (!packet.instanceCount)
+                batches_.push_back({packet.mesh, packet.transform, packet.material, packet.part, 0, 0});
+            for (u32 i = 0; i < packet.instanceCount; i++)
+                batches_.push_back({packet.mesh, explicitInstances[i], packet.material, packet.part, 0, 0});
+            continue;
+        }
+
+        const auto merge = !batches_.empty() &&
+            batches_.back().instanceCount &&
+            batches_.back().mesh == packet.mesh &&
+            batches_.back().material == packet.material &&
+            batches_.back().part == packet.part;
+        if (!merge)
+        {
+            const auto firstInstance = static_cast<u32>(instanceTransforms_.size());
+            batches_.push_back({packet.mesh, packet.transform, packet.material, packet.part, firstInstance, 0});
+        }
+
+        if (packet.instanceCount)
+            instanceTransforms_.insert(instanceTransforms_.end(), explicitInstances, explicitInstances + packet.instanceCount);
+        else
+            instanceTransforms_.push_back(packet.transform);
+        batches_.back().instanceCount += (std::max)(packet.instanceCount, 1u);
+    }
+}
+
+auto RenderQueue::countStateChanges() const -> u32
+{
+    u32 changes = 0;
+    for (size_t i = 1; i < packets_.size(); i++)
+    {
+        const auto &prev = packets_[i - 1];
+        const auto &cur = packets_[i];
+        if (prev.material != cur.material || prev.mesh != cur.mesh)
+            changes++;
+    }
+    return changes;
+}
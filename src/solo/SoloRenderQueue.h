@@ -0,0 +1,79 @@
+/* 
+ * Copyright (c) Aleksey Fedotov 
+ * MIT license 
+ */
+
+#pragma once
+
+#include "SoloCommon.h"
+
+namespace solo
+{
+    class Camera;
+    class Mesh;
+    class Transform;
+    class Material;
+
+    // Draws of a single camera, sorted by 64-bit keys before being handed to the backend. Keys group draws by
+    // material render order, then (for opaque draws) by effect, material and mesh to minimize rebinding
+    // and front-to-back, or (for transparent draws) back-to-front.
+    // Consecutive draws of the same mesh part with the same instanced material are then merged into instanced batches.
+    class RenderQueue final
+    {
+    public:
+        struct Packet
+        {
+            u64 key;
+            Mesh *mesh;
+            Transform *transform;
+            Material *material;
+            s32 part; // whole mesh if negative
+            u32 firstInstance; // into explicit instances, for packets added via addInstanced
+            u32 instanceCount;
+        };
+
+        struct Batch
+        {
+            Mesh *mesh;
+            Transform *transform; // first instance for instanced batches
+            Material *material;
+            s32 part;
+            u32 firstInstance; // into instanceTransforms()
+            u32 instanceCount; // not instanced if zero
+        };
+
+        // Material or mesh changes between consecutive draws, before and after sorting
+        struct Stats
+        {
+            u32 drawCount = 0;
+            u32 batchCount = 0;
+            u32 submittedStateChanges = 0;
+            u32 sortedStateChanges = 0;
+        };
+
+        void begin(const Camera *camera);
+        void add(Mesh *mesh, s32 part, Transform *transform, Material *material);
+        void addInstanced(Mesh *mesh, s32 part, Material *material, const vec<Transform*> &transforms);
+        void sort();
+
+        auto batches() const -> const vec<Batch>& { return batches_; }
+        auto instanceTransforms() const -> const vec<Transform*>& { return instanceTransforms_; }
+
+        auto stats() const -> const Stats& { return stats_; }
+        void resetStats() { stats_ = Stats(); }
+
+    private:
+        const Camera *camera_ = nullptr;
+        vec<Packet> packets_;
+        vec<Packet> sortBuffer_;
+        vec<Transform*> explicitInstances_;
+        vec<Batch> batches_;
+        vec<Transform*> instanceTransforms_;
+        u32 sequence_ = 0;
+        Stats stats_;
+
+        void addPacket(Mesh *mesh, s32 part, Transform *transform, Material *material, u32 firstInstance, u32 instanceCount);
+        void buildBatches();
+        auto countStateChanges() const -> u32;
+    };
+}
@@ -28,8 +28,52 @@ auto Renderer::fromDevice(Device *device) -> sptr<Renderer>
     }
 }
 
+void Renderer::beginCamera(Camera *camera, FrameBuffer *renderTarget)
+{
+    renderQueue_.begin(camera);
+    currentCamera_ = camera;
+    onBeginCamera(camera, renderTarget);
+}
+
+void Renderer::endCamera(Camera *camera, FrameBuffer *renderTarget)
+{
+    renderQueue_.sort();
+    const auto &instanceTransforms = renderQueue_.instanceTransforms();
+    for (const auto &batch: renderQueue_.batches())
+    {
+        if (batch.instanceCount)
+        {
+            onDrawMeshInstanced(batch.mesh, batch.part, batch.material,
+                instanceTransforms.data() + batch.firstInstance, batch.instanceCount);
+        }
+        else if (batch.part >= 0)
+            onDrawMeshPart(batch.mesh, static_cast<u32>(batch.part), batch.transform, batch.material);
+        else
+            onDrawMesh(batch.mesh, batch.transform, batch.material);
+    }
+
+    onEndCamera(camera, renderTarget);
+    currentCamera_ = nullptr;
+}
+
+void Renderer::drawMesh(Mesh *mesh, Transform *transform, Material *material)
+{
+    renderQueue_.add(mesh, -1, transform, material);
+}
+
+void Renderer::drawMeshPart(Mesh *mesh, u32 part, Transform *transform, Material *material)
+{
+    renderQueue_.add(mesh, static_cast<s32>(part), transform, material);
+}
+
+void Renderer::drawMeshInstanced(Mesh *mesh, s32 part, Material *material, const vec<Transform*> &transforms)
+{
+    renderQueue_.addInstanced(mesh, part, material, transforms);
+}
+
 void Renderer::renderFrame(std::function<void()> render)
 {
+    renderQueue_.resetStats();
     beginFrame();
     render();
     endFrame();
@@ -6,6 +6,7 @@
 #pragma once
 
 #include "SoloCommon.h"
+#include "SoloRenderQueue.h"
 #include <functional>
 
 namespace solo
@@ -24,20 +25,41 @@ namespace solo
 
         virtual ~Renderer() = default;
 
-        virtual void beginCamera(Camera *camera, FrameBuffer *renderTarget) = 0;
-        virtual void endCamera(Camera *camera, FrameBuffer *renderTarget) = 0;
-        virtual void drawMesh(Mesh *mesh, Transform *transform, Material *material) = 0;
-        virtual void drawMeshPart(Mesh *mesh, u32 part, Transform *transform, Material *material) = 0;
+        // Draws are queued and only submitted to the backend, sorted, when the camera ends. Materials are
+        // referenced rather than copied, so every draw of a camera uses the parameter values its material
+        // has at endCamera. Draws needing different values must use different materials
+        void beginCamera(Camera *camera, FrameBuffer *renderTarget);
+        void endCamera(Camera *camera, FrameBuffer *renderTarget);
+        void drawMesh(Mesh *mesh, Transform *transform, Material *material);
+        void drawMeshPart(Mesh *mesh, u32 part, Transform *transform, Material *material);
+        // Draws the whole mesh if part is negative. Falls back to separate draws if the material effect is not instanced
+        void drawMeshInstanced(Mesh *mesh, s32 part, Material *material, const vec<Transform*> &transforms);
 
         virtual auto name() const -> const char* = 0;
         virtual auto gpuName() const -> const char* = 0;
 
+        // Between beginCamera and endCamera, null otherwise
+        auto currentCamera() const -> Camera* { return currentCamera_; }
+
         void renderFrame(std::function<void()> render);
 
+        // Accumulated over all cameras of the current frame
+        auto renderQueueStats() const -> const RenderQueue::Stats& { return renderQueue_.stats(); }
+
     protected:
         Renderer() = default;
 
         virtual void beginFrame() = 0;
         virtual void endFrame() = 0;
+
+        virtual void onBeginCamera(Camera *camera, FrameBuffer *renderTarget) = 0;
+        virtual void onEndCamera(Camera *camera, FrameBuffer *renderTarget) = 0;
+        virtual void onDrawMesh(Mesh *mesh, Transform *transform, Material *material) = 0;
+        virtual void onDrawMeshPart(Mesh *mesh, u32 part, Transform *transform, Material *material) = 0;
+        virtual void onDrawMeshInstanced(Mesh *mesh, s32 part, Material *material, Transform *const *transforms, u32 count) = 0;
+
+    private:
+        RenderQueue renderQueue_;
+        Camera *currentCamera_ = nullptr;
     };
 }
\ No newline at end of file
@@ -9,6 +9,8 @@
 #include "SoloNode.h"
 #include "SoloDevice.h"
 #include "SoloCamera.h"
+#include "SoloMeshRenderer.h"
+#include <algorithm>
 
 using namespace solo;
 
@@ -77,6 +79,13 @@ void Scene::addComponent(u32 nodeId, sptr<Component> cmp)
 
     if (cmp->typeId() == Camera::getId())
         cameras_.push_back(static_cast<Camera*>(cmp.get()));
+
+    if (cmp->typeId() == MeshRenderer::getId())
+    {
+        const auto renderer = static_cast<MeshRenderer*>(cmp.get());
+        const auto proxy = rendererIndex_.add(renderer->worldBounds(), renderer);
+        indexedRenderers_[renderer] = {proxy, renderer->worldBoundsVersion()};
+    }
 }
 
 void Scene::removeComponent(u32 nodeId, u32 typeId)
@@ -91,7 +100,7 @@ void Scene::removeComponent(u32 nodeId, u32 typeId)
     if (cmpIt == nodeComponents.end() || cmpIt->second.deleted)
         return;
 
-    auto cmp = cmpIt->second;
+    auto &cmp = cmpIt->second;
     cmp.deleted = true;
     cmp.component->terminate();
 
@@ -99,6 +108,17 @@ void Scene::removeComponent(u32 nodeId, u32 typeId)
 
     if (cmp.component->typeId() == Camera::getId())
         cameras_.erase(std::remove(cameras_.begin(), cameras_.end(), cmp.component.get()));
+
+    if (cmp.component->typeId() == MeshRenderer::getId())
+    {
+        const auto renderer = static_cast<MeshRenderer*>(cmp.component.get());
+        const auto indexed = indexedRenderers_.find(renderer);
+        if (indexed != indexedRenderers_.end())
+        {
+            rendererIndex_.remove(indexed->second.proxy);
+            indexedRenderers_.erase(indexed);
+        }
+    }
 }
 
 void Scene::visit(const std::function<void(Component*)> &accept)
@@ -120,6 +140,63 @@ void Scene::visitByTags(u32 tagMask, const std::function<void(Component*)> &acce
     cleanupDeleted();
 }
 
+void Scene::syncRendererIndex()
+{
+    // World bounds are recomputed only for renderers whose transform or mesh changed
+    for (auto &p: indexedRenderers_)
+    {
+        const auto &bounds = p.first->worldBounds();
+        const auto version = p.first->worldBoundsVersion();
+        if (version != p.second.boundsVersion)
+        {
+            rendererIndex_.update(p.second.proxy, bounds);
+            p.second.boundsVersion = version;
+        }
+    }
+
+    rendererIndex_.flush();
+}
+
+auto Scene::queryRenderersInBox(const BoundingBox &box) -> vec<MeshRenderer*>
+{
+    syncRendererIndex();
+    vec<MeshRenderer*> result;
+    rendererIndex_.queryBox(box, [&result](void *r) { result.push_back(static_cast<MeshRenderer*>(r)); });
+    return result;
+}
+
+auto Scene::queryRenderersInSphere(const Vector3 &center, float radius) -> vec<MeshRenderer*>
+{
+    syncRendererIndex();
+    vec<MeshRenderer*> result;
+    rendererIndex_.querySphere(center, radius, [&result](void *r) { result.push_back(static_cast<MeshRenderer*>(r)); });
+    return result;
+}
+
+auto Scene::queryRenderersInFrustum(const Frustum &frustum) -> vec<MeshRenderer*>
+{
+    syncRendererIndex();
+    vec<MeshRenderer*> result;
+    rendererIndex_.queryFrustum(frustum, [&result](void *r) { result.push_back(static_cast<MeshRenderer*>(r)); });
+    return result;
+}
+
+auto Scene::queryRenderersByRay(const Ray &ray, float maxDistance) -> vec<MeshRenderer*>
+{
+    syncRendererIndex();
+
+    vec<std::pair<float, MeshRenderer*>> hits;
+    rendererIndex_.queryRay(ray, maxDistance,
+        [&hits](void *r, float distance) { hits.emplace_back(distance, static_cast<MeshRenderer*>(r)); });
+    std::sort(hits.begin(), hits.end(),
+        [](const std::pair<float, MeshRenderer*> &a, const std::pair<float, MeshRenderer*> &b) { return a.first < b.first; });
+
+    vec<MeshRenderer*> result;
+    for (const auto &hit: hits)
+        result.push_back(hit.second);
+    return result;
+}
+
 auto Scene::findComponent(u32 nodeId, u32 typeId) const -> Component*
 {
     const auto node = nodes_.find(nodeId);
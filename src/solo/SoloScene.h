@@ -6,6 +6,7 @@
 #pragma once
 
 #include "SoloCommon.h"
+#include "SoloBvh.h"
 #include <functional>
 
 namespace solo
@@ -14,6 +15,9 @@ namespace solo
     class Component;
     class Node;
     class Camera;
+    class MeshRenderer;
+    class Frustum;
+    class Ray;
 
     class Scene final: public NoCopyAndMove
     {
@@ -35,6 +39,14 @@ namespace solo
         void visit(const std::function<void(Component*)> &accept);
         void visitByTags(u32 tagMask, const std::function<void(Component*)> &accept);
 
+        // Spatial queries over world bounds of mesh renderers. Renderers moved since the previous query
+        // are picked up automatically
+        auto queryRenderersInBox(const BoundingBox &box) -> vec<MeshRenderer*>;
+        auto queryRenderersInSphere(const Vector3 &center, float radius) -> vec<MeshRenderer*>;
+        auto queryRenderersInFrustum(const Frustum &frustum) -> vec<MeshRenderer*>;
+        // Sorted by distance to where the ray enters renderer bounds
+        auto queryRenderersByRay(const Ray &ray, float maxDistance) -> vec<MeshRenderer*>;
+
     private:
         using NodeComponents = umap<u32, sptr<Component>>;
         using NodesWithComponents = umap<u32, NodeComponents>;
@@ -51,8 +63,18 @@ namespace solo
         umap<u32, uset<u32>> deletedComponents_;
         vec<Camera*> cameras_;
 
+        struct IndexedRenderer
+        {
+            u32 proxy;
+            u32 boundsVersion;
+        };
+
+        umap<MeshRenderer*, IndexedRenderer> indexedRenderers_;
+        Bvh rendererIndex_;
+
         explicit Scene(Device *device);
 
         void cleanupDeleted();
+        void syncRendererIndex();
     };
 }
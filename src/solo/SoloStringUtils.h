@@ -15,5 +15,14 @@ namespace solo
         {
             return std::equal(ending.rbegin(), ending.rend(), s.rbegin());
         }
+
+        inline auto toHex(u64 value) -> str
+        {
+            static const s8 *digits = "0123456789abcdef";
+            str result(16, '0');
+            for (s32 i = 15; i >= 0; i--, value >>= 4)
+                result[i] = digits[value & 0xf];
+            return result;
+        }
     }
 }
\ No newline at end of file
@@ -4,6 +4,8 @@
  */
 
 #include "SoloTextureData.h"
+#include "SoloDevice.h"
+#include "SoloCookedTexture.h"
 #include "stb/SoloSTBTextureData.h"
 
 namespace solo
@@ -47,6 +49,15 @@ static auto toTextureFormat(TextureDataFormat format) -> TextureFormat
 
 auto Texture2DData::fromFile(Device *device, const str &path) -> sptr<Texture2DData>
 {
+    const auto cookedPath = CookedTexture::findCooked(device->fileSystem(), path);
+    if (!cookedPath.empty())
+    {
+        const auto cooked = CookedTexture::fromFile(device, cookedPath);
+        if (cooked || CookedTexture::isCookedPath(path))
+            return cooked;
+        SL_DEBUG_LOG("Ignoring invalid ", cookedPath);
+    }
+
     SL_DEBUG_PANIC(!STBTexture2DData::canLoadFromFile(path), "Unsupported cube texture file ", path);
     return STBTexture2DData::fromFile(device, path);
 }
@@ -4,38 +4,151 @@
  */
 
 #include "SoloVertexBufferLayout.h"
+#include <glm/gtc/packing.hpp>
+#include <cstring>
 
 using namespace solo;
 
-void VertexBufferLayout::addAttribute(u32 elementCount, const str &name, VertexAttributeUsage usage)
+static auto attributeSize(u32 elementCount, VertexAttributeFormat format) -> u32
 {
-    const auto size = static_cast<u32>(sizeof(float) * elementCount);
+    switch (format)
+    {
+        case VertexAttributeFormat::Float:
+            return static_cast<u32>(sizeof(float) * elementCount);
+        case VertexAttributeFormat::Half:
+            return (2 * elementCount + 3) & ~3u;
+        case VertexAttributeFormat::SNorm8:
+        case VertexAttributeFormat::UNorm8:
+            return (elementCount + 3) & ~3u;
+        case VertexAttributeFormat::SNorm10_10_10_2:
+            SL_DEBUG_PANIC(elementCount > 4, "Too many components for a packed 10-10-10-2 attribute");
+            return 4;
+    }
+
+    SL_DEBUG_PANIC(true, "Unsupported vertex attribute format");
+    return 0;
+}
+
+void VertexBufferLayout::addAttribute(u32 elementCount, const str &name, VertexAttributeUsage usage, VertexAttributeFormat format)
+{
+    const auto size = attributeSize(elementCount, format);
     const auto offset = attrs_.empty() ? 0 : attrs_.crbegin()->offset + attrs_.crbegin()->size;
-    attrs_.push_back(VertexAttribute{name, elementCount, size, 0, offset, usage});
+    attrs_.push_back(VertexAttribute{name, elementCount, size, 0, offset, usage, format});
     this->elementCount_ += elementCount;
     this->size_ += size;
 }
 
 void VertexBufferLayout::addAttribute(VertexAttributeUsage usage)
+{
+    addAttribute(usage, VertexAttributeFormat::Float);
+}
+
+void VertexBufferLayout::addAttribute(VertexAttributeUsage usage, VertexAttributeFormat format)
 {
     switch (usage)
     {
         case VertexAttributeUsage::Position:
-            addAttribute(3, "sl_Position", VertexAttributeUsage::Position);
+            addAttribute(3, "sl_Position", VertexAttributeUsage::Position, format);
             break;
         case VertexAttributeUsage::Normal:
-            addAttribute(3, "sl_Normal", VertexAttributeUsage::Normal);
+            addAttribute(3, "sl_Normal", VertexAttributeUsage::Normal, format);
             break;
         case VertexAttributeUsage::TexCoord:
-            addAttribute(2, "sl_TexCoord", VertexAttributeUsage::TexCoord);
+            addAttribute(2, "sl_TexCoord", VertexAttributeUsage::TexCoord, format);
             break;
         case VertexAttributeUsage::Tangent:
-            addAttribute(3, "sl_Tangent", VertexAttributeUsage::Tangent);
+            addAttribute(3, "sl_Tangent", VertexAttributeUsage::Tangent, format);
             break;
         case VertexAttributeUsage::Binormal:
-            addAttribute(3, "sl_Binormal", VertexAttributeUsage::Binormal);
+            addAttribute(3, "sl_Binormal", VertexAttributeUsage::Binormal, format);
+            break;
+        case VertexAttributeUsage::Color:
+            addAttribute(4, "sl_Color", VertexAttributeUsage::Color, format);
             break;
         default:
             SL_DEBUG_PANIC(true, "Unsupported vertex attribute usage");
     }
 }
+
+void VertexBufferLayout::packAttribute(const VertexAttribute &attr, const float *src, void *dst)
+{
+    switch (attr.format)
+    {
+        case VertexAttributeFormat::Float:
+            memcpy(dst, src, attr.size);
+            break;
+        case VertexAttributeFormat::Half:
+        {
+            const auto halves = static_cast<u16*>(dst);
+            memset(dst, 0, attr.size);
+            for (u32 i = 0; i < attr.elementCount; i++)
+                halves[i] = glm::packHalf1x16(src[i]);
+            break;
+        }
+        case VertexAttributeFormat::SNorm8:
+        {
+            const auto bytes = static_cast<u8*>(dst);
+            memset(dst, 0, attr.size);
+            for (u32 i = 0; i < attr.elementCount; i++)
+                bytes[i] = glm::packSnorm1x8(src[i]);
+            break;
+        }
+        case VertexAttributeFormat::UNorm8:
+        {
+            const auto bytes = static_cast<u8*>(dst);
+            memset(dst, 0, attr.size);
+            for (u32 i = 0; i < attr.elementCount; i++)
+                bytes[i] = glm::packUnorm1x8(src[i]);
+            break;
+        }
+        case VertexAttributeFormat::SNorm10_10_10_2:
+        {
+            glm::vec4 v(0);
+            for (u32 i = 0; i < attr.elementCount; i++)
+                v[i] = src[i];
+            const auto packed = glm::packSnorm3x10_1x2(v);
+            memcpy(dst, &packed, sizeof(packed));
+            break;
+        }
+    }
+}
+
+void VertexBufferLayout::unpackAttribute(const VertexAttribute &attr, const void *src, float *dst)
+{
+    switch (attr.format)
+    {
+        case VertexAttributeFormat::Float:
+            memcpy(dst, src, attr.elementCount * sizeof(float));
+            break;
+        case VertexAttributeFormat::Half:
+        {
+            const auto halves = static_cast<const u16*>(src);
+            for (u32 i = 0; i < attr.elementCount; i++)
+                dst[i] = glm::unpackHalf1x16(halves[i]);
+            break;
+        }
+        case VertexAttributeFormat::SNorm8:
+        {
+            const auto bytes = static_cast<const u8*>(src);
+            for (u32 i = 0; i < attr.elementCount; i++)
+                dst[i] = glm::unpackSnorm1x8(bytes[i]);
+            break;
+        }
+        case VertexAttributeFormat::UNorm8:
+        {
+            const auto bytes = static_cast<const u8*>(src);
+            for (u32 i = 0; i < attr.elementCount; i++)
+                dst[i] = glm::unpackUnorm1x8(bytes[i]);
+            break;
+        }
+        case VertexAttributeFormat::SNorm10_10_10_2:
+        {
+            u32 packed;
+            memcpy(&packed, src, sizeof(packed));
+            const auto v = glm::unpackSnorm3x10_1x2(packed);
+            for (u32 i = 0; i < attr.elementCount; i++)
+                dst[i] = v[i];
+            break;
+        }
+    }
+}
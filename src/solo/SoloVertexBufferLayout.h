@@ -16,7 +16,19 @@ namespace solo
         Normal,
         TexCoord,
         Tangent,
-        Binormal
+        Binormal,
+        Color
+    };
+
+    // Storage of attribute components. Shaders always see floats, normalized formats map to [-1, 1] or [0, 1].
+    // Attributes are padded to 4 bytes, so three-component Half and 8-bit attributes take as much as four
+    enum class VertexAttributeFormat
+    {
+        Float,
+        Half,
+        SNorm8,
+        UNorm8,
+        SNorm10_10_10_2 // up to three 10-bit components and a 2-bit one in 32 bits, e.g. for normals and tangents
     };
 
     class VertexAttribute final
@@ -28,12 +40,14 @@ namespace solo
         u32 location;
         u32 offset;
         VertexAttributeUsage usage;
+        VertexAttributeFormat format;
     };
 
     class VertexBufferLayout final
     {
     public:
         void addAttribute(VertexAttributeUsage usage);
+        void addAttribute(VertexAttributeUsage usage, VertexAttributeFormat format);
 
         auto attributeCount() const -> u32 { return static_cast<u32>(attrs_.size()); }
         auto attribute(u32 index) const -> VertexAttribute { return attrs_.at(index); }
@@ -41,11 +55,15 @@ namespace solo
         auto size() const -> u32 { return size_; }
         auto elementCount() const -> u32 { return elementCount_; }
 
+        // Convert elementCount float components from and to the attribute's format
+        static void packAttribute(const VertexAttribute &attr, const float *src, void *dst);
+        static void unpackAttribute(const VertexAttribute &attr, const void *src, float *dst);
+
     private:
         vec<VertexAttribute> attrs_;
         u32 size_ = 0; // in bytes
-        u32 elementCount_ = 0; // number of floats
+        u32 elementCount_ = 0; // number of components, i.e. floats when unpacked
 
-        void addAttribute(u32 elementCount, const str &name, VertexAttributeUsage usage);
+        void addAttribute(u32 elementCount, const str &name, VertexAttributeUsage usage, VertexAttributeFormat format);
     };
 }
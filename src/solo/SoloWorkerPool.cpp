@@ -0,0 +1,80 @@
+/* 
+ * Copyright (c) Aleksey Fedotov 
+ * MIT license 
+ */
+
+#include "SoloWorkerPool.h"
+#include <algorithm>
+
+using namespace solo;
+
+WorkerPool::WorkerPool(u32 threadCount)
+{
+    for (u32 worker = 1; worker < threadCount; worker++)
+        threads_.emplace_back([this, worker] { loop(worker); });
+}
+
+WorkerPool::~WorkerPool()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopping_ = true;
+    }
+    wakeUp_.notify_all();
+
+    for (auto &thread: threads_)
+        thread.join();
+}
+
+void WorkerPool::run(u32 workerCount, const std::function<void(u32)> &func)
+{
+    SL_DEBUG_PANIC(workerCount > threadCount(), "Worker count ", workerCount, " exceeds thread count ", threadCount());
+    workerCount = (std::min)(workerCount, threadCount());
+
+    if (workerCount <= 1)
+    {
+        func(0);
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        func_ = &func;
+        workerCount_ = workerCount;
+        pendingCount_ = workerCount - 1;
+        generation_++;
+    }
+    wakeUp_.notify_all();
+
+    func(0);
+
+    std::unique_lock<std::mutex> lock(mutex_);
+    finished_.wait(lock, [this] { return !pendingCount_; });
+    func_ = nullptr;
+}
+
+void WorkerPool::loop(u32 worker)
+{
+    u32 seenGeneration = 0;
+
+    while (true)
+    {
+        const std::function<void(u32)> *func = nullptr;
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            wakeUp_.wait(lock, [&] { return stopping_ || generation_ != seenGeneration; });
+            if (stopping_)
+                return;
+            seenGeneration = generation_;
+            if (worker >= workerCount_)
+                continue;
+            func = func_;
+        }
+
+        (*func)(worker);
+
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (!--pendingCount_)
+            finished_.notify_one();
+    }
+}
@@ -0,0 +1,44 @@
+/* 
+ * Copyright (c) Aleksey Fedotov 
+ * MIT license 
+ */
+
+#pragma once
+
+#include "SoloCommon.h"
+#include <functional>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+
+namespace solo
+{
+    // Threads kept alive for fork-join work done every frame, where starting threads each time
+    // would cost more than the work itself. Unlike JobPool, callers block until their work is done
+    class WorkerPool final: public NoCopyAndMove
+    {
+    public:
+        // The calling thread counts as a worker, so threadCount - 1 threads are started
+        explicit WorkerPool(u32 threadCount);
+        ~WorkerPool();
+
+        auto threadCount() const -> u32 { return static_cast<u32>(threads_.size()) + 1; }
+
+        // Calls func(worker) for each worker below workerCount and waits for all of them. Worker 0 is the calling thread
+        // and every other index always runs on the same thread, so per-worker resources need no locking
+        void run(u32 workerCount, const std::function<void(u32)> &func);
+
+    private:
+        vec<std::thread> threads_;
+        std::mutex mutex_;
+        std::condition_variable wakeUp_;
+        std::condition_variable finished_;
+        const std::function<void(u32)> *func_ = nullptr;
+        u32 workerCount_ = 0;
+        u32 pendingCount_ = 0;
+        u32 generation_ = 0;
+        bool stopping_ = false;
+
+        void loop(u32 worker);
+    };
+}
@@ -0,0 +1,75 @@
+/* 
+ * Copyright (c) Aleksey Fedotov 
+ * MIT license 
+ */
+
+#include "SoloAssimpIOSystem.h"
+#include "SoloFileSystem.h"
+#include <algorithm>
+#include <cstring>
+
+using namespace solo;
+
+AssimpIOStream::AssimpIOStream(sptr<FileMapping> mapping):
+    mapping_(mapping)
+{
+}
+
+auto AssimpIOStream::Read(void *buffer, size_t size, size_t count) -> size_t
+{
+    if (!size)
+        return 0;
+
+    // Only whole elements are read, like fread
+    const auto readCount = (std::min)(count, (mapping_->size() - position_) / size);
+    if (!readCount)
+        return 0;
+
+    memcpy(buffer, mapping_->data() + position_, readCount * size);
+    position_ += readCount * size;
+    return readCount;
+}
+
+auto AssimpIOStream::Seek(size_t offset, aiOrigin origin) -> aiReturn
+{
+    size_t base = 0;
+    if (origin == aiOrigin_CUR)
+        base = position_;
+    else if (origin == aiOrigin_END)
+        base = mapping_->size();
+
+    if (base + offset > mapping_->size())
+        return aiReturn_FAILURE;
+
+    position_ = base + offset;
+    return aiReturn_SUCCESS;
+}
+
+auto AssimpIOStream::FileSize() const -> size_t
+{
+    return mapping_->size();
+}
+
+AssimpIOSystem::AssimpIOSystem(FileSystem *fs):
+    fs_(fs)
+{
+}
+
+bool AssimpIOSystem::Exists(const char *path) const
+{
+    return fs_->exists(path);
+}
+
+auto AssimpIOSystem::Open(const char *path, const char *mode) -> Assimp::IOStream*
+{
+    // Importers probe for optional files by opening them, so a missing one is not an error
+    if (strchr(mode, 'w') || strchr(mode, 'a') || !fs_->exists(path))
+        return nullptr;
+
+    return new AssimpIOStream(fs_->map(path));
+}
+
+void AssimpIOSystem::Close(Assimp::IOStream *stream)
+{
+    delete stream;
+}
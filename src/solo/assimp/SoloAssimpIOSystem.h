@@ -0,0 +1,50 @@
+/* 
+ * Copyright (c) Aleksey Fedotov 
+ * MIT license 
+ */
+
+#pragma once
+
+#include "SoloCommon.h"
+#include <assimp/IOSystem.hpp>
+#include <assimp/IOStream.hpp>
+
+namespace solo
+{
+    class FileSystem;
+    class FileMapping;
+
+    // Read-only stream over a mapped file, so assimp reads the file pages directly instead of a loaded copy
+    class AssimpIOStream final: public Assimp::IOStream
+    {
+    public:
+        explicit AssimpIOStream(sptr<FileMapping> mapping);
+
+        auto Read(void *buffer, size_t size, size_t count) -> size_t override final;
+        auto Write(const void*, size_t, size_t) -> size_t override final { return 0; }
+        auto Seek(size_t offset, aiOrigin origin) -> aiReturn override final;
+        auto Tell() const -> size_t override final { return position_; }
+        auto FileSize() const -> size_t override final;
+        void Flush() override final {}
+
+    private:
+        sptr<FileMapping> mapping_;
+        size_t position_ = 0;
+    };
+
+    // Routes assimp file access through the engine file system. Importers resolve sibling files
+    // (materials, external buffers) against the directory of the imported file
+    class AssimpIOSystem final: public Assimp::IOSystem
+    {
+    public:
+        explicit AssimpIOSystem(FileSystem *fs);
+
+        bool Exists(const char *path) const override final;
+        auto getOsSeparator() const -> char override final { return '/'; }
+        auto Open(const char *path, const char *mode) -> Assimp::IOStream* override final;
+        void Close(Assimp::IOStream *stream) override final;
+
+    private:
+        FileSystem *fs_ = nullptr;
+    };
+}
@@ -14,18 +14,26 @@ BulletStaticMeshCollider::BulletStaticMeshCollider(sptr<MeshData> data):
 {
     SL_DEBUG_PANIC(data_->indexData().empty(), "Collision mesh index data is empty");
 
+    const auto &indices = data_->indexData().front();
+    const auto shortIndices = data_->partIndexElementSize(0) == IndexElementSize::Bits16;
+    const auto indexType = shortIndices ? PHY_SHORT : PHY_INTEGER;
+    if (shortIndices)
+        shortIndices_ = Mesh::narrowIndices(indices.data(), static_cast<u32>(indices.size()));
+
     mesh_ = std::make_unique<btIndexedMesh>();
-    mesh_->m_indexType = PHY_INTEGER;
+    mesh_->m_indexType = indexType;
     mesh_->m_vertexType = PHY_FLOAT;
-    mesh_->m_numTriangles = data_->indexData().front().size() / 3;
+    mesh_->m_numTriangles = indices.size() / 3;
     mesh_->m_numVertices = data_->vertexCount();
-    mesh_->m_triangleIndexBase = reinterpret_cast<const u8*>(data_->indexData().front().data());
-    mesh_->m_triangleIndexStride = 3 * sizeof(u32);
+    mesh_->m_triangleIndexBase = shortIndices
+        ? reinterpret_cast<const u8*>(shortIndices_.data())
+        : reinterpret_cast<const u8*>(indices.data());
+    mesh_->m_triangleIndexStride = 3 * (shortIndices ? sizeof(u16) : sizeof(u32));
     mesh_->m_vertexBase = reinterpret_cast<const u8*>(data_->vertexData().data());
     mesh_->m_vertexStride = 3 * sizeof(float);
 
     arr_ = std::make_unique<btTriangleIndexVertexArray>();
-    arr_->addIndexedMesh(*mesh_, PHY_INTEGER); // TODO support for 16-bit indices?
+    arr_->addIndexedMesh(*mesh_, indexType);
 
     shape_ = std::make_unique<btBvhTriangleMeshShape>(arr_.get(), true);
 }
@@ -22,6 +22,7 @@ namespace solo
 
     private:
         sptr<MeshData> data_;
+        vec<u16> shortIndices_;
         uptr<btIndexedMesh> mesh_;
         uptr<btTriangleIndexVertexArray> arr_;
         uptr<btBvhTriangleMeshShape> shape_;
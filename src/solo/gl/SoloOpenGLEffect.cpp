@@ -7,8 +7,18 @@
 
 #ifdef SL_OPENGL_RENDERER
 
+#include "SoloDevice.h"
+#include "SoloFileSystem.h"
+#include "SoloHash.h"
+#include "SoloStringUtils.h"
+#include <cstring>
+
 using namespace solo;
 
+// Bump when the cache file layout changes
+static const u32 programCacheVersion = 1;
+static const u32 programCacheHeaderSize = 4 * sizeof(u32);
+
 static auto compileShader(GLuint type, const void *src, u32 length) -> GLint
 {
     static umap<GLuint, str> typeNames =
@@ -38,9 +48,11 @@ static auto compileShader(GLuint type, const void *src, u32 length) -> GLint
     return shader;
 }
 
-static auto linkProgram(GLuint vs, GLuint fs) -> GLint
+static auto linkProgram(GLuint vs, GLuint fs, bool retrievable) -> GLint
 {
     const auto program = glCreateProgram();
+    if (retrievable)
+        glProgramParameteri(program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
     glAttachShader(program, vs);
     glAttachShader(program, fs);
     glLinkProgram(program);
@@ -60,18 +72,105 @@ static auto linkProgram(GLuint vs, GLuint fs) -> GLint
     return program;
 }
 
-OpenGLEffect::OpenGLEffect(const void *vsSrc, u32 vsSrcLen, const void *fsSrc, u32 fsSrcLen)
+// The minimum GL version is only enforced in debug builds, and drivers may expose
+// the extension while supporting no binary formats at all
+static bool programBinarySupported()
+{
+    if (!GLEW_VERSION_4_1 && !GLEW_ARB_get_program_binary)
+        return false;
+
+    GLint formatCount = 0;
+    glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formatCount);
+    return formatCount > 0;
+}
+
+static auto programCacheKey(const void *vsSrc, u32 vsSrcLen, const void *fsSrc, u32 fsSrcLen) -> u64
+{
+    // Binaries are only valid for the driver that produced them
+    const auto renderer = reinterpret_cast<const s8*>(glGetString(GL_RENDERER));
+    const auto version = reinterpret_cast<const s8*>(glGetString(GL_VERSION));
+
+    auto hash = hashBytes(&vsSrcLen, sizeof(vsSrcLen));
+    hash = hashBytes(vsSrc, vsSrcLen, hash);
+    hash = hashBytes(&fsSrcLen, sizeof(fsSrcLen), hash);
+    hash = hashBytes(fsSrc, fsSrcLen, hash);
+    hash = hashBytes(renderer, std::strlen(renderer), hash);
+    hash = hashBytes(version, std::strlen(version), hash);
+    return hashBytes(&programCacheVersion, sizeof(programCacheVersion), hash);
+}
+
+// Returns 0 if the data is stale or the driver rejects the binary
+static auto loadProgramBinary(const vec<u8> &data, u64 key) -> GLuint
+{
+    if (data.size() <= programCacheHeaderSize)
+        return 0;
+
+    u32 header[4];
+    memcpy(header, data.data(), programCacheHeaderSize);
+    const auto storedKey = static_cast<u64>(header[1]) | (static_cast<u64>(header[2]) << 32);
+    if (header[0] != programCacheVersion || storedKey != key)
+        return 0;
+
+    const auto program = glCreateProgram();
+    glProgramBinary(program, header[3], data.data() + programCacheHeaderSize,
+        static_cast<GLsizei>(data.size() - programCacheHeaderSize));
+
+    GLint status;
+    glGetProgramiv(program, GL_LINK_STATUS, &status);
+    if (status == GL_FALSE)
+    {
+        glDeleteProgram(program);
+        return 0;
+    }
+
+    return program;
+}
+
+static void saveProgramBinary(FileSystem *fs, const str &path, u64 key, GLuint program)
+{
+    GLint length = 0;
+    glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &length);
+    if (length <= 0)
+        return;
+
+    vec<u8> data(programCacheHeaderSize + length);
+    GLenum format = 0;
+    glGetProgramBinary(program, length, nullptr, &format, data.data() + programCacheHeaderSize);
+
+    const u32 header[4] = {programCacheVersion, static_cast<u32>(key), static_cast<u32>(key >> 32), format};
+    memcpy(data.data(), header, programCacheHeaderSize);
+
+    fs->replaceBytes(path, data);
+}
+
+OpenGLEffect::OpenGLEffect(Device *device, const void *vsSrc, u32 vsSrcLen, const void *fsSrc, u32 fsSrcLen)
 {
-    const auto vs = compileShader(GL_VERTEX_SHADER, vsSrc, vsSrcLen);
-    const auto fs = compileShader(GL_FRAGMENT_SHADER, fsSrc, fsSrcLen);
-    handle_ = linkProgram(vs, fs);
+    const auto cacheDir = programBinarySupported() ? device->shaderCacheDirectory() : str();
+    const auto fs = device->fileSystem();
+    const auto key = cacheDir.empty() ? 0 : programCacheKey(vsSrc, vsSrcLen, fsSrc, fsSrcLen);
+    const auto cachePath = cacheDir.empty() ? str() : cacheDir + "/" + stringutils::toHex(key) + ".glprog";
 
-    glDetachShader(handle_, vs);
-    glDeleteShader(vs);
-    glDetachShader(handle_, fs);
-    glDeleteShader(fs);
+    if (!cachePath.empty() && fs->exists(cachePath))
+        handle_ = loadProgramBinary(fs->readBytes(cachePath), key);
+
+    // Cache miss or the driver has changed since the binary was saved
+    if (!handle_)
+    {
+        const auto vertexShader = compileShader(GL_VERTEX_SHADER, vsSrc, vsSrcLen);
+        const auto fragmentShader = compileShader(GL_FRAGMENT_SHADER, fsSrc, fsSrcLen);
+        handle_ = linkProgram(vertexShader, fragmentShader, !cachePath.empty());
+
+        glDetachShader(handle_, vertexShader);
+        glDeleteShader(vertexShader);
+        glDetachShader(handle_, fragmentShader);
+        glDeleteShader(fragmentShader);
+
+        if (!cachePath.empty())
+            saveProgramBinary(fs, cachePath, key, handle_);
+    }
 
     introspectUniforms();
+    introspectUniformBlocks();
     introspectAttributes();
 }
 
@@ -119,6 +218,12 @@ void OpenGLEffect::introspectUniforms()
     {
         GLint size;
         GLenum type;
+        GLint blockIndex;
+        const auto index = static_cast<GLuint>(i);
+        glGetActiveUniformsiv(handle_, 1, &index, GL_UNIFORM_BLOCK_INDEX, &blockIndex);
+        if (blockIndex >= 0)
+            continue; // see introspectUniformBlocks
+
         glGetActiveUniform(handle_, i, nameMaxLength, nullptr, &size, &type, nameArr.data());
         
         nameArr[nameMaxLength] = '\0';
@@ -143,6 +248,69 @@ void OpenGLEffect::introspectUniforms()
     }
 }
 
+void OpenGLEffect::introspectUniformBlocks()
+{
+    GLint activeBlocks;
+    glGetProgramiv(handle_, GL_ACTIVE_UNIFORM_BLOCKS, &activeBlocks);
+    if (activeBlocks <= 0)
+        return;
+
+    GLint nameMaxLength;
+    glGetProgramiv(handle_, GL_ACTIVE_UNIFORM_BLOCK_MAX_NAME_LENGTH, &nameMaxLength);
+    GLint memberNameMaxLength;
+    glGetProgramiv(handle_, GL_ACTIVE_UNIFORM_MAX_LENGTH, &memberNameMaxLength);
+
+    vec<GLchar> nameArr(nameMaxLength + 1);
+    vec<GLchar> memberNameArr(memberNameMaxLength + 1);
+    for (GLint i = 0; i < activeBlocks; ++i)
+    {
+        const auto blockIndex = static_cast<GLuint>(i);
+
+        glGetActiveUniformBlockName(handle_, blockIndex, nameMaxLength, nullptr, nameArr.data());
+        nameArr[nameMaxLength] = '\0';
+
+        // Generated blocks are named _<buffer> (see generateEffectSource), parameters refer to them as <buffer>
+        str name = nameArr.data();
+        if (!name.empty() && name[0] == '_')
+            name.erase(0, 1);
+
+        // Program's own block indices are used as binding points, there are few blocks per program
+        glUniformBlockBinding(handle_, blockIndex, blockIndex);
+
+        GLint size;
+        glGetActiveUniformBlockiv(handle_, blockIndex, GL_UNIFORM_BLOCK_DATA_SIZE, &size);
+        GLint memberCount;
+        glGetActiveUniformBlockiv(handle_, blockIndex, GL_UNIFORM_BLOCK_ACTIVE_UNIFORMS, &memberCount);
+
+        auto &block = uniformBlocks_[name];
+        block.binding = blockIndex;
+        block.size = size;
+
+        vec<GLint> memberIndices(memberCount);
+        glGetActiveUniformBlockiv(handle_, blockIndex, GL_UNIFORM_BLOCK_ACTIVE_UNIFORM_INDICES, memberIndices.data());
+        for (const auto memberIndex: memberIndices)
+        {
+            const auto index = static_cast<GLuint>(memberIndex);
+
+            GLint offset;
+            glGetActiveUniformsiv(handle_, 1, &index, GL_UNIFORM_OFFSET, &offset);
+            glGetActiveUniformName(handle_, index, memberNameMaxLength, nullptr, memberNameArr.data());
+            memberNameArr[memberNameMaxLength] = '\0';
+
+            // Members of blocks with an instance name are reported as <block>.<member>
+            str memberName = memberNameArr.data();
+            const auto dotIndex = memberName.find('.');
+            if (dotIndex != str::npos)
+                memberName.erase(0, dotIndex + 1);
+            const auto bracketIndex = memberName.find('[');
+            if (bracketIndex != str::npos)
+                memberName.erase(bracketIndex);
+
+            block.memberOffsets[memberName] = offset;
+        }
+    }
+}
+
 void OpenGLEffect::introspectAttributes()
 {
     GLint activeAttributes;
@@ -163,6 +331,8 @@ void OpenGLEffect::introspectAttributes()
         str name = nameArr.data();
         attributes_[name].location = glGetAttribLocation(handle_, name.c_str());
     }
+
+    instanced_ = attributes_.count(instanceWorldAttributeName) > 0;
 }
 
 #endif
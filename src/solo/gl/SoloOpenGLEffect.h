@@ -28,21 +28,31 @@ namespace solo
             u32 location;
         };
 
-        OpenGLEffect(const void *vsSrc, u32 vsSrcLen, const void *fsSrc, u32 fsSrcLen);
+        struct UniformBlockInfo
+        {
+            u32 binding;
+            u32 size;
+            umap<str, u32> memberOffsets;
+        };
+
+        OpenGLEffect(Device *device, const void *vsSrc, u32 vsSrcLen, const void *fsSrc, u32 fsSrcLen);
         ~OpenGLEffect();
 
         auto handle() const -> GLuint { return handle_; }
 
         auto uniformInfo(const str &name) -> UniformInfo;
+        auto uniformBlocks() const -> const umap<str, UniformBlockInfo>& { return uniformBlocks_; }
         auto hasAttribute(const str &name) -> bool;
         auto attributeInfo(const str &name) -> AttributeInfo;
 
     private:
         GLuint handle_ = 0;
         umap<str, UniformInfo> uniforms_;
+        umap<str, UniformBlockInfo> uniformBlocks_;
         umap<str, AttributeInfo> attributes_;
 
         void introspectUniforms();
+        void introspectUniformBlocks();
         void introspectAttributes();
     };
 }
@@ -10,24 +10,125 @@
 #include "SoloDevice.h"
 #include "SoloCamera.h"
 #include "SoloOpenGLTexture.h"
+#include "SoloOpenGLStateCache.h"
 #include "SoloTransform.h"
 #include "SoloTexture.h"
+#include "SoloOpenGLUniformBufferRing.h"
+#include <cstring>
 
 using namespace solo;
 
+template <class T>
+static auto writeValue(void *dst, const T &value) -> bool
+{
+    std::memcpy(dst, &value, sizeof(value));
+    return true;
+}
+
+// Writes the bound value into dst, returns false if there's nothing to write (e.g. no camera)
+static auto writeBinding(ParameterBinding binding, const Camera *camera, const Transform *nodeTransform, void *dst) -> bool
+{
+    switch (binding)
+    {
+        case ParameterBinding::WorldMatrix:
+            return nodeTransform && writeValue(dst, nodeTransform->worldMatrix());
+        case ParameterBinding::ViewMatrix:
+            return camera && writeValue(dst, camera->viewMatrix());
+        case ParameterBinding::ProjectionMatrix:
+            return camera && writeValue(dst, camera->projectionMatrix());
+        case ParameterBinding::WorldViewMatrix:
+            return camera && nodeTransform && writeValue(dst, nodeTransform->worldViewMatrix(camera));
+        case ParameterBinding::ViewProjectionMatrix:
+            return camera && writeValue(dst, camera->viewProjectionMatrix());
+        case ParameterBinding::WorldViewProjectionMatrix:
+            return camera && nodeTransform && writeValue(dst, nodeTransform->worldViewProjMatrix(camera));
+        case ParameterBinding::InverseTransposedWorldMatrix:
+            return nodeTransform && writeValue(dst, nodeTransform->invTransposedWorldMatrix());
+        case ParameterBinding::InverseTransposedWorldViewMatrix:
+            return camera && nodeTransform && writeValue(dst, nodeTransform->invTransposedWorldViewMatrix(camera));
+        case ParameterBinding::CameraWorldPosition:
+            return camera && writeValue(dst, camera->transform()->worldPosition());
+        default:
+            SL_DEBUG_PANIC(true, "Unsupported parameter binding");
+            return false;
+    }
+}
+
 OpenGLMaterial::OpenGLMaterial(sptr<Effect> effect):
     effect_(std::static_pointer_cast<OpenGLEffect>(effect))
 {
+    for (const auto &p: effect_->uniformBlocks())
+    {
+        auto &buffer = buffers_[p.first];
+        buffer.binding = p.second.binding;
+        buffer.data.resize(p.second.size, 0);
+        buffer.dirtyEnd = p.second.size;
+    }
 }
 
-void OpenGLMaterial::applyParams(const Camera *camera, const Transform *nodeTransform) const
+OpenGLMaterial::~OpenGLMaterial()
+{
+    for (auto &p: buffers_)
+    {
+        if (p.second.handle)
+            glDeleteBuffers(1, &p.second.handle);
+    }
+}
+
+void OpenGLMaterial::applyParams(const Camera *camera, const Transform *nodeTransform, OpenGLStateCache &state, OpenGLUniformBufferRing &ring)
 {
     for (const auto &p : appliers_)
         p.second(camera, nodeTransform);
+
+    for (auto &p: buffers_)
+    {
+        auto &buffer = p.second;
+        const auto size = static_cast<u32>(buffer.data.size());
+
+        if (!buffer.bindings.empty())
+        {
+            for (const auto &b: buffer.bindings)
+                writeBinding(b.second, camera, nodeTransform, buffer.data.data() + b.first);
+            const auto offset = ring.push(buffer.data.data(), size);
+            state.bindUniformBuffer(buffer.binding, ring.handle(), offset, size);
+
+            // In case the bindings get replaced with values and the block stops being streamed
+            buffer.dirtyBegin = 0;
+            buffer.dirtyEnd = size;
+            continue;
+        }
+
+        if (buffer.dirtyEnd > buffer.dirtyBegin)
+        {
+            if (!buffer.handle)
+            {
+                glGenBuffers(1, &buffer.handle);
+                SL_DEBUG_PANIC(!buffer.handle, "Unable to create uniform buffer");
+                glBindBuffer(GL_UNIFORM_BUFFER, buffer.handle);
+                glBufferData(GL_UNIFORM_BUFFER, size, buffer.data.data(), GL_DYNAMIC_DRAW);
+            }
+            else
+            {
+                glBindBuffer(GL_UNIFORM_BUFFER, buffer.handle);
+                glBufferSubData(GL_UNIFORM_BUFFER, buffer.dirtyBegin, buffer.dirtyEnd - buffer.dirtyBegin, buffer.data.data() + buffer.dirtyBegin);
+            }
+            glBindBuffer(GL_UNIFORM_BUFFER, 0);
+
+            buffer.dirtyBegin = buffer.dirtyEnd = 0;
+        }
+
+        state.bindUniformBuffer(buffer.binding, buffer.handle, 0, size);
+    }
+
+    for (const auto &p : textures_)
+        state.bindTexture(p.second.unit, p.second.texture.get());
 }
 
 void OpenGLMaterial::setFloatParameter(const str &name, float value)
 {
+    if (setBufferValue(name, &value, sizeof(value)))
+        return;
+
     setParameter(name, [value](GLuint location, GLuint)
     {
         return [location, value](const Camera *, const Transform *)
@@ -39,6 +140,9 @@ void OpenGLMaterial::setFloatParameter(const str &name, float value)
 
 void OpenGLMaterial::setVector2Parameter(const str &name, const Vector2 &value)
 {
+    if (setBufferValue(name, &value, sizeof(value)))
+        return;
+
     setParameter(name, [value](GLuint location, GLuint)
     {
         return [location, value](const Camera *, const Transform *)
@@ -50,6 +154,9 @@ void OpenGLMaterial::setVector2Parameter(const str &name, const Vector2 &value)
 
 void OpenGLMaterial::setVector3Parameter(const str &name, const Vector3 &value)
 {
+    if (setBufferValue(name, &value, sizeof(value)))
+        return;
+
     setParameter(name, [value](GLuint location, GLuint)
     {
         return [location, value](const Camera *, const Transform *)
@@ -61,6 +168,9 @@ void OpenGLMaterial::setVector3Parameter(const str &name, const Vector3 &value)
 
 void OpenGLMaterial::setVector4Parameter(const str &name, const Vector4 &value)
 {
+    if (setBufferValue(name, &value, sizeof(value)))
+        return;
+
     setParameter(name, [value](GLuint location, GLuint)
     {
         return [location, value](const Camera *, const Transform *)
@@ -72,6 +182,9 @@ void OpenGLMaterial::setVector4Parameter(const str &name, const Vector4 &value)
 
 void OpenGLMaterial::setMatrixParameter(const str &name, const Matrix &value)
 {
+    if (setBufferValue(name, &value, sizeof(value)))
+        return;
+
     setParameter(name, [value](GLuint location, GLuint)
     {
         return [location, value](const Camera *, const Transform *)
@@ -84,170 +197,174 @@ void OpenGLMaterial::setMatrixParameter(const str &name, const Matrix &value)
 void OpenGLMaterial::setTextureParameter(const str &name, sptr<Texture> value)
 {
     auto tex = std::dynamic_pointer_cast<OpenGLTexture>(value);
-    setParameter(name, [tex](GLuint location, GLuint index)
+    GLuint unit = 0;
+    setParameter(name, [&unit](GLuint location, GLuint index)
     {
-        return [location, index, tex](const Camera *, const Transform *)
+        unit = index;
+        return [location, index](const Camera *, const Transform *)
         {
-            glActiveTexture(GL_TEXTURE0 + index);
             glUniform1i(location, index);
-            tex->bind();
         };
     });
+    textures_[name] = {unit, tex};
 }
 
 void OpenGLMaterial::bindParameter(const str &name, ParameterBinding binding)
 {
-    switch (binding)
+    UniformBuffer *buffer;
+    u32 offset;
+    if (findBufferMember(name, buffer, offset))
     {
-        case ParameterBinding::WorldMatrix:
-        {
-            setParameter(name, [](GLuint location, GLuint)
-            {
-                return [location](const Camera *, const Transform *nodeTransform)
-                {
-                    if (nodeTransform)
-                    {
-                        auto data = nodeTransform->worldMatrix().columns();
-                        glUniformMatrix4fv(location, 1, GL_FALSE, data);
-                    }
-                };
-            });
-            break;
-        }
+        buffer->bindings[offset] = binding;
+        return;
+    }
 
-        case ParameterBinding::ViewMatrix:
+    setParameter(name, [binding](GLuint location, GLuint)
+    {
+        return [location, binding](const Camera *camera, const Transform *nodeTransform)
         {
-            setParameter(name, [](GLuint location, GLuint)
+            if (binding == ParameterBinding::CameraWorldPosition)
             {
-                return [location](const Camera *camera, const Transform *)
-                {
-                    if (camera)
-                    {
-                        auto data = camera->viewMatrix().columns();
-                        glUniformMatrix4fv(location, 1, GL_FALSE, data);
-                    }
-                };
-            });
-            break;
-        }
-
-        case ParameterBinding::ProjectionMatrix:
-        {
-            setParameter(name, [](GLuint location, GLuint)
+                Vector3 pos;
+                if (writeBinding(binding, camera, nodeTransform, &pos))
+                    glUniform3f(location, pos.x(), pos.y(), pos.z());
+            }
+            else
             {
-                return [location](const Camera *camera, const Transform *)
-                {
-                    if (camera)
-                    {
-                        auto data = camera->projectionMatrix().columns();
-                        glUniformMatrix4fv(location, 1, GL_FALSE, data);
-                    }
-                };
-            });
-            break;
-        }
+                Matrix matrix;
+                if (writeBinding(binding, camera, nodeTransform, &matrix))
+                    glUniformMatrix4fv(location, 1, GL_FALSE, matrix.columns());
+            }
+        };
+    });
+}
 
-        case ParameterBinding::WorldViewMatrix:
-        {
-            setParameter(name, [](GLuint location, GLuint)
-            {
-                return [location](const Camera *camera, const Transform *nodeTransform)
-                {
-                    if (nodeTransform && camera)
-                    {
-                        auto data = nodeTransform->worldViewMatrix(camera).columns();
-                        glUniformMatrix4fv(location, 1, GL_FALSE, data);
-                    }
-                };
-            });
-            break;
-        }
+auto OpenGLMaterial::findBufferMember(const str &name, UniformBuffer *&buffer, u32 &offset) -> bool
+{
+    const auto idx = name.find(':');
+    if (idx == str::npos)
+        return false;
 
-        case ParameterBinding::ViewProjectionMatrix:
-        {
-            setParameter(name, [](GLuint location, GLuint)
-            {
-                return [location](const Camera *camera, const Transform *)
-                {
-                    if (camera)
-                    {
-                        auto data = camera->viewProjectionMatrix().columns();
-                        glUniformMatrix4fv(location, 1, GL_FALSE, data);
-                    }
-                };
-            });
-            break;
-        }
+    const auto bufferName = name.substr(0, idx);
+    const auto bufferIt = buffers_.find(bufferName);
+    if (bufferIt == buffers_.end())
+        return false;
 
-        case ParameterBinding::WorldViewProjectionMatrix:
-        {
-            setParameter(name, [](GLuint location, GLuint)
-            {
-                return [location](const Camera *camera, const Transform *nodeTransform)
-                {
-                    if (nodeTransform && camera)
-                    {
-                        auto data = nodeTransform->worldViewProjMatrix(camera).columns();
-                        glUniformMatrix4fv(location, 1, GL_FALSE, data);
-                    }
-                };
-            });
-            break;
-        }
+    const auto &members = effect_->uniformBlocks().at(bufferName).memberOffsets;
+    const auto memberIt = members.find(name.substr(idx + 1));
+    SL_DEBUG_PANIC(memberIt == members.end(), "Material parameter ", name, " not found");
+    if (memberIt == members.end())
+        return false;
 
-        case ParameterBinding::InverseTransposedWorldMatrix:
-        {
-            setParameter(name, [](GLuint location, GLuint)
-            {
-                return [location](const Camera *, const Transform *nodeTransform)
-                {
-                    if (nodeTransform)
-                    {
-                        auto data = nodeTransform->invTransposedWorldMatrix().columns();
-                        glUniformMatrix4fv(location, 1, GL_FALSE, data);
-                    }
-                };
-            });
-            break;
-        }
+    buffer = &bufferIt->second;
+    offset = memberIt->second;
+    return true;
+}
 
-        case ParameterBinding::InverseTransposedWorldViewMatrix:
-        {
-            setParameter(name, [](GLuint location, GLuint)
-            {
-                return [location](const Camera *camera, const Transform *nodeTransform)
-                {
-                    if (nodeTransform && camera)
-                    {
-                        auto data = nodeTransform->invTransposedWorldViewMatrix(camera).columns();
-                        glUniformMatrix4fv(location, 1, GL_FALSE, data);
-                    }
-                };
-            });
-            break;
-        }
+auto OpenGLMaterial::setBufferValue(const str &name, const void *value, u32 size) -> bool
+{
+    UniformBuffer *buffer;
+    u32 offset;
+    if (!findBufferMember(name, buffer, offset))
+        return false;
 
-        case ParameterBinding::CameraWorldPosition:
-        {
-            setParameter(name, [](GLuint location, GLuint)
-            {
-                return [location](const Camera *camera, const Transform *)
-                {
-                    if (camera)
-                    {
-                        auto pos = camera->transform()->worldPosition();
-                        glUniform3f(location, pos.x(), pos.y(), pos.z());
-                    }
-                };
-            });
-            break;
-        }
+    writeBufferValue(*buffer, offset, value, size);
+    return true;
+}
 
-        default:
-            SL_DEBUG_PANIC(true, "Unsupported parameter binding")
+void OpenGLMaterial::writeBufferValue(UniformBuffer &buffer, u32 offset, const void *value, u32 size)
+{
+    SL_DEBUG_PANIC(offset + size > buffer.data.size(), "Material parameter at offset ", offset, " does not fit into its uniform buffer");
+
+    std::memcpy(buffer.data.data() + offset, value, size);
+    buffer.bindings.erase(offset);
+
+    if (buffer.dirtyEnd > buffer.dirtyBegin)
+    {
+        buffer.dirtyBegin = (std::min)(buffer.dirtyBegin, offset);
+        buffer.dirtyEnd = (std::max)(buffer.dirtyEnd, offset + size);
+    }
+    else
+    {
+        buffer.dirtyBegin = offset;
+        buffer.dirtyEnd = offset + size;
     }
 }
 
+auto OpenGLMaterial::parameterHandle(const str &name) -> ParamHandle
+{
+    const auto existing = parameterHandles_.find(name);
+    if (existing != parameterHandles_.end())
+        return existing->second;
+
+    ParameterSlot slot{name, nullptr, 0};
+    findBufferMember(name, slot.buffer, slot.offset);
+
+    const auto handle = static_cast<ParamHandle>(parameterSlots_.size());
+    parameterSlots_.push_back(slot);
+    parameterHandles_[name] = handle;
+    return handle;
+}
+
+void OpenGLMaterial::setFloatParameter(ParamHandle handle, float value)
+{
+    const auto &slot = parameterSlots_.at(handle);
+    if (slot.buffer)
+        writeBufferValue(*slot.buffer, slot.offset, &value, sizeof(value));
+    else
+        setFloatParameter(slot.name, value);
+}
+
+void OpenGLMaterial::setVector2Parameter(ParamHandle handle, const Vector2 &value)
+{
+    const auto &slot = parameterSlots_.at(handle);
+    if (slot.buffer)
+        writeBufferValue(*slot.buffer, slot.offset, &value, sizeof(value));
+    else
+        setVector2Parameter(slot.name, value);
+}
+
+void OpenGLMaterial::setVector3Parameter(ParamHandle handle, const Vector3 &value)
+{
+    const auto &slot = parameterSlots_.at(handle);
+    if (slot.buffer)
+        writeBufferValue(*slot.buffer, slot.offset, &value, sizeof(value));
+    else
+        setVector3Parameter(slot.name, value);
+}
+
+void OpenGLMaterial::setVector4Parameter(ParamHandle handle, const Vector4 &value)
+{
+    const auto &slot = parameterSlots_.at(handle);
+    if (slot.buffer)
+        writeBufferValue(*slot.buffer, slot.offset, &value, sizeof(value));
+    else
+        setVector4Parameter(slot.name, value);
+}
+
+void OpenGLMaterial::setMatrixParameter(ParamHandle handle, const Matrix &value)
+{
+    const auto &slot = parameterSlots_.at(handle);
+    if (slot.buffer)
+        writeBufferValue(*slot.buffer, slot.offset, &value, sizeof(value));
+    else
+        setMatrixParameter(slot.name, value);
+}
+
+void OpenGLMaterial::setTextureParameter(ParamHandle handle, sptr<Texture> value)
+{
+    setTextureParameter(parameterSlots_.at(handle).name, value);
+}
+
+void OpenGLMaterial::bindParameter(ParamHandle handle, ParameterBinding binding)
+{
+    const auto &slot = parameterSlots_.at(handle);
+    if (slot.buffer)
+        slot.buffer->bindings[slot.offset] = binding;
+    else
+        bindParameter(slot.name, binding);
+}
+
 void OpenGLMaterial::setParameter(const str &paramName, const std::function<ParameterApplier(GLuint, GLint)> &getApplier)
 {
     auto name = paramName;
@@ -255,6 +372,7 @@ void OpenGLMaterial::setParameter(const str &paramName, const std::function<Para
     if (idx != std::string::npos)
         name.replace(idx, 1, "_");
     const auto info = effect_->uniformInfo(name);
+    textures_.erase(paramName);
     appliers_[paramName] = getApplier(info.location, info.samplerIndex);
 }
 
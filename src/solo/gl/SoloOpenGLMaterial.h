@@ -22,12 +22,14 @@ namespace solo
     class OpenGLRenderer;
     class OpenGLEffect;
     class OpenGLTexture;
+    class OpenGLStateCache;
+    class OpenGLUniformBufferRing;
 
     class OpenGLMaterial final : public Material
     {
     public:
         explicit OpenGLMaterial(sptr<Effect> effect);
-        ~OpenGLMaterial() {}
+        ~OpenGLMaterial();
 
         auto effect() const -> sptr<Effect> override final { return effect_; }
 
@@ -40,16 +42,63 @@ namespace solo
 
         void bindParameter(const str &name, ParameterBinding binding) override final;
 
-        void applyParams(const Camera *camera, const Transform *nodeTransform) const;
+        auto parameterHandle(const str &name) -> ParamHandle override final;
+
+        void setFloatParameter(ParamHandle handle, float value) override final;
+        void setVector2Parameter(ParamHandle handle, const Vector2 &value) override final;
+        void setVector3Parameter(ParamHandle handle, const Vector3 &value) override final;
+        void setVector4Parameter(ParamHandle handle, const Vector4 &value) override final;
+        void setMatrixParameter(ParamHandle handle, const Matrix &value) override final;
+        void setTextureParameter(ParamHandle handle, sptr<solo::Texture> value) override final;
+
+        void bindParameter(ParamHandle handle, ParameterBinding binding) override final;
+
+        void applyParams(const Camera *camera, const Transform *nodeTransform, OpenGLStateCache &state, OpenGLUniformBufferRing &ring);
 
     protected:
         using ParameterApplier = std::function<void(const Camera *, const Transform *)>;
 
+        // CPU copy of an effect's uniform block. Blocks with bound parameters are written into the renderer's
+        // ring on every draw, the rest are kept in their own buffer and only their dirty range gets uploaded.
+        struct UniformBuffer
+        {
+            u32 binding = 0;
+            vec<u8> data;
+            u32 dirtyBegin = 0;
+            u32 dirtyEnd = 0;
+            GLuint handle = 0;
+            umap<u32, ParameterBinding> bindings; // by member offset
+        };
+
+        // Parameters outside of uniform blocks have no buffer and fall back to the name-based setters
+        struct ParameterSlot
+        {
+            str name;
+            UniformBuffer *buffer;
+            u32 offset;
+        };
+
+        struct TextureBinding
+        {
+            GLuint unit;
+            sptr<OpenGLTexture> texture;
+        };
+
         sptr<OpenGLEffect> effect_ = nullptr;
 
-        // Maybe not the fastest, but convenient and good enough for now
+        umap<str, UniformBuffer> buffers_;
+        vec<ParameterSlot> parameterSlots_;
+        umap<str, ParamHandle> parameterHandles_;
+
+        // Parameters that are not in a uniform block (e.g. in effects created from hand-written sources)
         umap<str, ParameterApplier> appliers_;
 
+        // Bound by the renderer's state cache rather than by the appliers, so that unchanged bindings are skipped
+        umap<str, TextureBinding> textures_;
+
+        auto findBufferMember(const str &name, UniformBuffer *&buffer, u32 &offset) -> bool;
+        auto setBufferValue(const str &name, const void *value, u32 size) -> bool;
+        void writeBufferValue(UniformBuffer &buffer, u32 offset, const void *value, u32 size);
         void setParameter(const str &paramName, const std::function<ParameterApplier(GLuint, GLint)> &getApplier);
     };
 }
@@ -10,6 +10,7 @@
 #include "SoloOpenGLMesh.h"
 #include "SoloDevice.h"
 #include "SoloOpenGLEffect.h"
+#include "SoloOpenGLStateCache.h"
 #include <algorithm>
 
 using namespace solo;
@@ -34,6 +35,35 @@ static auto toPrimitiveType(PrimitiveType type) -> GLenum
     return 0;
 }
 
+static void setVertexAttribPointer(GLuint location, const VertexAttribute &attr, u32 stride, u32 offset)
+{
+    const auto pointer = reinterpret_cast<void *>(static_cast<size_t>(offset));
+    switch (attr.format)
+    {
+        case VertexAttributeFormat::Float:
+            glVertexAttribPointer(location, attr.elementCount, GL_FLOAT, GL_FALSE, stride, pointer);
+            break;
+        case VertexAttributeFormat::Half:
+            glVertexAttribPointer(location, attr.elementCount, GL_HALF_FLOAT, GL_FALSE, stride, pointer);
+            break;
+        case VertexAttributeFormat::SNorm8:
+            glVertexAttribPointer(location, attr.elementCount, GL_BYTE, GL_TRUE, stride, pointer);
+            break;
+        case VertexAttributeFormat::UNorm8:
+            glVertexAttribPointer(location, attr.elementCount, GL_UNSIGNED_BYTE, GL_TRUE, stride, pointer);
+            break;
+        case VertexAttributeFormat::SNorm10_10_10_2:
+            // Packed types are only allowed with all four components
+            glVertexAttribPointer(location, 4, GL_INT_2_10_10_10_REV, GL_TRUE, stride, pointer);
+            break;
+    }
+}
+
+static auto toIndexType(IndexElementSize size) -> GLenum
+{
+    return size == IndexElementSize::Bits16 ? GL_UNSIGNED_SHORT : GL_UNSIGNED_INT;
+}
+
 OpenGLMesh::~OpenGLMesh()
 {
     resetVertexArrayCache();
@@ -43,7 +73,7 @@ OpenGLMesh::~OpenGLMesh()
         removePart(0);
 }
 
-auto OpenGLMesh::getOrCreateVertexArray(OpenGLEffect *effect) -> GLuint
+auto OpenGLMesh::getOrCreateVertexArray(OpenGLEffect *effect, OpenGLStateCache &state) -> GLuint
 {
     auto &cacheEntry = vertexArrayCache_[effect];
     cacheEntry.age = 0;
@@ -55,7 +85,8 @@ auto OpenGLMesh::getOrCreateVertexArray(OpenGLEffect *effect) -> GLuint
     glGenVertexArrays(1, &handle);
     SL_DEBUG_PANIC(!handle, "Unable to create vertex array");
 
-    glBindVertexArray(handle);
+    // Left bound - it's about to be drawn with anyway
+    state.bindVertexArray(handle);
 
     for (u32 i = 0; i < vertexBuffers_.size(); i++)
     {
@@ -88,7 +119,7 @@ auto OpenGLMesh::getOrCreateVertexArray(OpenGLEffect *effect) -> GLuint
 
             if (found)
             {
-                glVertexAttribPointer(location, attr.elementCount, GL_FLOAT, GL_FALSE, stride, reinterpret_cast<void *>(offset));
+                setVertexAttribPointer(location, attr, stride, offset);
                 glEnableVertexAttribArray(location);
             }
 
@@ -98,11 +129,27 @@ auto OpenGLMesh::getOrCreateVertexArray(OpenGLEffect *effect) -> GLuint
         glBindBuffer(GL_ARRAY_BUFFER, 0);
     }
 
-    glBindVertexArray(0);
-
     return handle;
 }
 
+void OpenGLMesh::bindInstanceBuffer(OpenGLEffect *effect, GLuint buffer, u32 offset)
+{
+    // Expects the vertex array of the effect to be bound. The offset changes from draw to draw,
+    // so unlike mesh attributes these pointers are specified every time
+    const auto location = effect->attributeInfo(Effect::instanceWorldAttributeName).location;
+    const auto stride = 16 * sizeof(float);
+
+    glBindBuffer(GL_ARRAY_BUFFER, buffer);
+    for (u32 i = 0; i < 4; i++)
+    {
+        const auto columnOffset = offset + i * 4 * sizeof(float);
+        glVertexAttribPointer(location + i, 4, GL_FLOAT, GL_FALSE, stride, reinterpret_cast<void *>(columnOffset));
+        glVertexAttribDivisor(location + i, 1);
+        glEnableVertexAttribArray(location + i);
+    }
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
 void OpenGLMesh::resetVertexArrayCache()
 {
     for (auto &p: vertexArrayCache_)
@@ -162,6 +209,7 @@ auto OpenGLMesh::addVertexBuffer(const VertexBufferLayout &layout, const void *d
     
     updateMinVertexCount();
     resetVertexArrayCache();
+    includeVertexBounds(layout, data, vertexCount, dynamic);
 
     return static_cast<u32>(vertexBuffers_.size() - 1);
 }
@@ -187,18 +235,21 @@ void OpenGLMesh::removeVertexBuffer(u32 index)
     resetVertexArrayCache();
 }
 
-auto OpenGLMesh::addPart(const void *data, u32 elementCount) -> u32
+auto OpenGLMesh::addPart(const void *data, u32 elementCount, IndexElementSize elementSize) -> u32
 {
     GLuint handle = 0;
     glGenBuffers(1, &handle);
     SL_DEBUG_PANIC(!handle, "Unable to create index buffer handle");
 
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, handle);
-    glBufferData(GL_ELEMENT_ARRAY_BUFFER, 4 * elementCount, data, GL_STATIC_DRAW); // TODO support for 16-bit indices?
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+    // The element array binding belongs to whatever vertex array the state cache has bound,
+    // so upload through a target that is not vertex array state
+    glBindBuffer(GL_COPY_WRITE_BUFFER, handle);
+    glBufferData(GL_COPY_WRITE_BUFFER, indexElementSizeInBytes(elementSize) * elementCount, data, GL_STATIC_DRAW);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
 
     indexBuffers_.push_back(handle);
     indexElementCounts_.push_back(elementCount);
+    indexElementSizes_.push_back(elementSize);
 
     return static_cast<u32>(indexBuffers_.size() - 1);
 }
@@ -209,36 +260,60 @@ void OpenGLMesh::removePart(u32 part)
     glDeleteBuffers(1, &handle);
     indexBuffers_.erase(indexBuffers_.begin() + part);
     indexElementCounts_.erase(indexElementCounts_.begin() + part);
+    indexElementSizes_.erase(indexElementSizes_.begin() + part);
+    removePartBounds(part);
 }
 
-void OpenGLMesh::draw(OpenGLEffect *effect)
+void OpenGLMesh::draw(OpenGLEffect *effect, OpenGLStateCache &state)
 {
-    const auto va = getOrCreateVertexArray(effect);
+    const auto va = getOrCreateVertexArray(effect, state);
     flushVertexArrayCache();
 
     if (indexBuffers_.empty())
     {
-        glBindVertexArray(va);
+        state.bindVertexArray(va);
         glDrawArrays(toPrimitiveType(primitiveType_), 0, minVertexCount_);
-        glBindVertexArray(0);
     }
     else
     {
         for (auto i = 0; i < indexBuffers_.size(); i++)
-            drawPart(i, effect);
+            drawPart(i, effect, state);
     }
 }
 
-void OpenGLMesh::drawPart(u32 part, OpenGLEffect *effect)
+void OpenGLMesh::drawPart(u32 part, OpenGLEffect *effect, OpenGLStateCache &state)
 {
-    const auto va = getOrCreateVertexArray(effect);
+    const auto va = getOrCreateVertexArray(effect, state);
     flushVertexArrayCache();
 
-    glBindVertexArray(va);
+    state.bindVertexArray(va);
+    // Element buffer binding is part of the vertex array state, which all parts share
     glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, indexBuffers_.at(part));
-    glDrawElements(toPrimitiveType(primitiveType_), indexElementCounts_.at(part), GL_UNSIGNED_INT, nullptr); // TODO support for 16-bit indices?
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
-    glBindVertexArray(0);
+    glDrawElements(toPrimitiveType(primitiveType_), indexElementCounts_.at(part), toIndexType(indexElementSizes_.at(part)), nullptr);
+}
+
+void OpenGLMesh::drawInstanced(s32 part, OpenGLEffect *effect, OpenGLStateCache &state, GLuint instanceBuffer, u32 instanceOffset, u32 instanceCount)
+{
+    const auto va = getOrCreateVertexArray(effect, state);
+    flushVertexArrayCache();
+
+    state.bindVertexArray(va);
+    bindInstanceBuffer(effect, instanceBuffer, instanceOffset);
+
+    const auto primitiveType = toPrimitiveType(primitiveType_);
+    if (indexBuffers_.empty())
+    {
+        glDrawArraysInstanced(primitiveType, 0, minVertexCount_, instanceCount);
+        return;
+    }
+
+    const auto first = part >= 0 ? static_cast<u32>(part) : 0;
+    const auto last = part >= 0 ? first : static_cast<u32>(indexBuffers_.size() - 1);
+    for (auto i = first; i <= last; i++)
+    {
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, indexBuffers_.at(i));
+        glDrawElementsInstanced(primitiveType, indexElementCounts_.at(i), toIndexType(indexElementSizes_.at(i)), nullptr, instanceCount);
+    }
 }
 
 #endif
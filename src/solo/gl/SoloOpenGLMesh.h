@@ -16,6 +16,7 @@ namespace solo
 {
     class Effect;
     class OpenGLEffect;
+    class OpenGLStateCache;
 
     class OpenGLMesh final : public Mesh
     {
@@ -28,15 +29,18 @@ namespace solo
         void updateDynamicVertexBuffer(u32 index, u32 vertexOffset, const void *data, u32 vertexCount) override final;
         void removeVertexBuffer(u32 index) override final;
 
-        auto addPart(const void *indexData, u32 indexElementCount) -> u32 override final;
+        auto addPart(const void *indexData, u32 indexElementCount, IndexElementSize elementSize) -> u32 override final;
         void removePart(u32 index) override final;
         auto partCount() const -> u32 override final { return static_cast<u32>(indexBuffers_.size()); }
+        auto partIndexElementSize(u32 part) const -> IndexElementSize override final { return indexElementSizes_.at(part); }
 
         auto primitiveType() const -> PrimitiveType override final { return primitiveType_; }
         void setPrimitiveType(PrimitiveType type) override final { primitiveType_ = type; }
 
-        void draw(OpenGLEffect *effect);
-        void drawPart(u32 part, OpenGLEffect *effect);
+        void draw(OpenGLEffect *effect, OpenGLStateCache &state);
+        void drawPart(u32 part, OpenGLEffect *effect, OpenGLStateCache &state);
+        // Instance world matrices are sourced from instanceBuffer starting at instanceOffset bytes. Whole mesh if part is negative
+        void drawInstanced(s32 part, OpenGLEffect *effect, OpenGLStateCache &state, GLuint instanceBuffer, u32 instanceOffset, u32 instanceCount);
 
     private:
         PrimitiveType primitiveType_ = PrimitiveType::Triangles;
@@ -44,6 +48,7 @@ namespace solo
         vec<VertexBufferLayout> layouts_;
         vec<GLuint> indexBuffers_;
         vec<u32> indexElementCounts_;
+        vec<IndexElementSize> indexElementSizes_;
         vec<u32> vertexCounts_;
         u32 minVertexCount_ = 0;
             
@@ -57,7 +62,8 @@ namespace solo
 
         auto addVertexBuffer(const VertexBufferLayout &layout, const void *data, u32 vertexCount, bool dynamic) -> u32;
 
-        auto getOrCreateVertexArray(OpenGLEffect *effect) -> GLuint;
+        auto getOrCreateVertexArray(OpenGLEffect *effect, OpenGLStateCache &state) -> GLuint;
+        void bindInstanceBuffer(OpenGLEffect *effect, GLuint buffer, u32 offset);
         void resetVertexArrayCache();
         void flushVertexArrayCache();
         void updateMinVertexCount();
@@ -9,49 +9,15 @@
 
 #include "SoloDevice.h"
 #include "SoloCamera.h"
+#include "SoloTransform.h"
 #include "SoloOpenGLMaterial.h"
 #include "SoloOpenGLMesh.h"
 #include "SoloOpenGLFrameBuffer.h"
 #include "SoloOpenGL.h"
+#include <algorithm>
 
 using namespace solo;
 
-static auto toBlendFactor(BlendFactor factor) -> GLenum
-{
-    switch (factor)
-    {
-        case BlendFactor::Zero:
-            return GL_ZERO;
-        case BlendFactor::One:
-            return GL_ONE;
-        case BlendFactor::SrcColor:
-            return GL_SRC_COLOR;
-        case BlendFactor::OneMinusSrcColor:
-            return GL_ONE_MINUS_SRC_COLOR;
-        case BlendFactor::DstColor:
-            return GL_DST_COLOR;
-        case BlendFactor::OneMinusDstColor:
-            return GL_ONE_MINUS_DST_COLOR;
-        case BlendFactor::SrcAlpha:
-            return GL_SRC_ALPHA;
-        case BlendFactor::OneMinusSrcAlpha:
-            return GL_ONE_MINUS_SRC_ALPHA;
-        case BlendFactor::DstAlpha:
-            return GL_DST_ALPHA;
-        case BlendFactor::OneMinusDstAlpha:
-            return GL_ONE_MINUS_DST_ALPHA;
-        case BlendFactor::ConstantAlpha:
-            return GL_CONSTANT_ALPHA;
-        case BlendFactor::OneMinusConstantAlpha:
-            return GL_ONE_MINUS_CONSTANT_ALPHA;
-        case BlendFactor::SrcAlphaSaturate:
-            return GL_SRC_ALPHA_SATURATE;
-    }
-
-    SL_DEBUG_PANIC(true, "Unsupported blend factor");
-    return 0;
-}
-
 static void clear(bool color, const Vector4 &clearColor)
 {
     if (color)
@@ -65,103 +31,6 @@ static void setViewport(const Vector4 &viewport)
     glViewport(viewport.x(), viewport.y(), viewport.z(), viewport.w());
 }
 
-static void setDepthWrite(bool enabled)
-{
-    glDepthMask(enabled ? GL_TRUE : GL_FALSE);
-}
-
-static void setDepthTest(bool enabled)
-{
-    enabled ? glEnable(GL_DEPTH_TEST) : glDisable(GL_DEPTH_TEST);
-}
-
-static void setDepthFunction(DepthFunction func)
-{
-    GLenum glfunc = 0;
-    switch (func)
-    {
-        case DepthFunction::Never:
-            glfunc = GL_NEVER;
-            break;
-        case DepthFunction::Less:
-            glfunc = GL_LESS;
-            break;
-        case DepthFunction::Equal:
-            glfunc = GL_EQUAL;
-            break;
-        case DepthFunction::LEqual:
-            glfunc = GL_LEQUAL;
-            break;
-        case DepthFunction::Greater:
-            glfunc = GL_GREATER;
-            break;
-        case DepthFunction::NotEqual:
-            glfunc = GL_NOTEQUAL;
-            break;
-        case DepthFunction::GEqual:
-            glfunc = GL_GEQUAL;
-            break;
-        case DepthFunction::Always:
-            glfunc = GL_ALWAYS;
-            break;
-        default:
-            break;
-    }
-    if (glfunc)
-        glDepthFunc(glfunc);
-}
-
-static void setPolygonMode(PolygonMode mode)
-{
-    GLenum glMode;
-    switch (mode)
-    {
-        case PolygonMode::Fill:
-            glMode = GL_FILL;
-            break;
-        case PolygonMode::Wireframe:
-            glMode = GL_LINE;
-            break;
-        case PolygonMode::Points:
-            glMode = GL_POINT;
-            break;
-        default:
-            return;
-    }
-
-    glPolygonMode(GL_FRONT_AND_BACK, glMode);
-}
-
-static void setFaceCull(FaceCull cull)
-{
-    switch (cull)
-    {
-        case FaceCull::None:
-            glDisable(GL_CULL_FACE);
-            break;
-        case FaceCull::Back:
-            glEnable(GL_CULL_FACE);
-            glFrontFace(GL_CCW);
-            break;
-        case FaceCull::Front:
-            glEnable(GL_CULL_FACE);
-            glFrontFace(GL_CW);
-            break;
-        default:
-            break;
-    }
-}
-
-static void setBlend(bool enabled)
-{
-    enabled ? glEnable(GL_BLEND) : glDisable(GL_BLEND);
-}
-
-static void setBlendFactor(BlendFactor srcFactor, BlendFactor dstFactor)
-{
-    glBlendFunc(toBlendFactor(srcFactor), toBlendFactor(dstFactor));
-}
-
 static auto version() -> std::pair<GLint, GLint>
 {
     GLint major, minor;
@@ -170,7 +39,8 @@ static auto version() -> std::pair<GLint, GLint>
     return {major, minor};
 }
 
-OpenGLRenderer::OpenGLRenderer(Device *device)
+OpenGLRenderer::OpenGLRenderer(Device *device):
+    uniformRing_(1024 * 1024)
 {
     auto ver = version();
     name_ = SL_FMT("OpenGL ", ver.first, ".", ver.second);
@@ -182,7 +52,7 @@ auto OpenGLRenderer::gpuName() const -> const char*
     return reinterpret_cast<const char*>(glGetString(GL_RENDERER));
 }
 
-void OpenGLRenderer::beginCamera(Camera *camera, FrameBuffer *renderTarget)
+void OpenGLRenderer::onBeginCamera(Camera *camera, FrameBuffer *renderTarget)
 {
     if (renderTarget)
     {
@@ -190,40 +60,70 @@ void OpenGLRenderer::beginCamera(Camera *camera, FrameBuffer *renderTarget)
         glBindFramebuffer(GL_FRAMEBUFFER, fb);
     }
 
+    // Resources may have been created or modified since the last camera, binding GL objects behind the cache's back
+    state_.invalidate();
+
     setViewport(camera->viewport());
-    setDepthWrite(true);
-    setDepthTest(true);
+    state_.setDepthWrite(true);
+    state_.setDepthTest(true);
     clear(camera->hasColorClearing(), camera->clearColor());
 
     currentCamera_ = camera;
 }
 
-void OpenGLRenderer::endCamera(Camera *camera, FrameBuffer *renderTarget)
+void OpenGLRenderer::onEndCamera(Camera *camera, FrameBuffer *renderTarget)
 {
+    state_.bindVertexArray(0);
     if (renderTarget)
         glBindFramebuffer(GL_FRAMEBUFFER, 0);
     currentCamera_ = nullptr;
 }
 
-void OpenGLRenderer::drawMesh(Mesh *mesh, Transform *transform, Material *material)
+void OpenGLRenderer::onDrawMesh(Mesh *mesh, Transform *transform, Material *material)
 {
     applyMaterial(material);
     const auto effect = static_cast<OpenGLEffect*>(material->effect().get());
-    static_cast<OpenGLMaterial*>(material)->applyParams(currentCamera_, transform);
-    static_cast<OpenGLMesh*>(mesh)->draw(effect);
+    static_cast<OpenGLMaterial*>(material)->applyParams(currentCamera_, transform, state_, uniformRing_);
+    static_cast<OpenGLMesh*>(mesh)->draw(effect, state_);
 }
 
-void OpenGLRenderer::drawMeshPart(Mesh *mesh, u32 part, Transform *transform, Material *material)
+void OpenGLRenderer::onDrawMeshPart(Mesh *mesh, u32 part, Transform *transform, Material *material)
 {
     applyMaterial(material);
     const auto effect = static_cast<OpenGLEffect*>(material->effect().get());
-    static_cast<OpenGLMaterial*>(material)->applyParams(currentCamera_, transform);
-    static_cast<OpenGLMesh*>(mesh)->drawPart(part, effect);
+    static_cast<OpenGLMaterial*>(material)->applyParams(currentCamera_, transform, state_, uniformRing_);
+    static_cast<OpenGLMesh*>(mesh)->drawPart(part, effect, state_);
+}
+
+void OpenGLRenderer::onDrawMeshInstanced(Mesh *mesh, s32 part, Material *material, Transform *const *transforms, u32 count)
+{
+    // Keeps each chunk of matrices well within the ring
+    constexpr u32 maxChunkSize = 4096;
+
+    applyMaterial(material);
+    const auto effect = static_cast<OpenGLEffect*>(material->effect().get());
+    static_cast<OpenGLMaterial*>(material)->applyParams(currentCamera_, transforms[0], state_, uniformRing_);
+
+    for (u32 first = 0; first < count; first += maxChunkSize)
+    {
+        const auto chunkSize = (std::min)(count - first, maxChunkSize);
+        instanceData_.resize(chunkSize * 16);
+        for (u32 i = 0; i < chunkSize; i++)
+        {
+            const auto columns = transforms[first + i]->worldMatrix().columns();
+            std::copy(columns, columns + 16, instanceData_.data() + i * 16);
+        }
+
+        // Buffer objects aren't tied to a target, so the uniform ring can stream vertex data just as well
+        const auto offset = uniformRing_.push(instanceData_.data(), chunkSize * 16 * sizeof(float));
+        static_cast<OpenGLMesh*>(mesh)->drawInstanced(part, effect, state_, uniformRing_.handle(), offset, chunkSize);
+    }
 }
 
 void OpenGLRenderer::beginFrame()
 {
     currentCamera_ = nullptr;
+    state_.resetCounters();
 }
 
 void OpenGLRenderer::endFrame()
@@ -233,14 +133,14 @@ void OpenGLRenderer::endFrame()
 void OpenGLRenderer::applyMaterial(Material *material)
 {
     const auto effect = static_cast<OpenGLEffect*>(material->effect().get());
-    glUseProgram(static_cast<const GLuint>(effect->handle()));
-    setFaceCull(material->faceCull());
-    setPolygonMode(material->polygonMode());
-    setDepthTest(material->hasDepthTest());
-    setDepthWrite(material->hasDepthWrite());
-    setDepthFunction(material->depthFunction());
-    setBlend(material->hasBlend());
-    setBlendFactor(material->srcBlendFactor(), material->dstBlendFactor());
+    state_.useProgram(static_cast<const GLuint>(effect->handle()));
+    state_.setFaceCull(material->faceCull());
+    state_.setPolygonMode(material->polygonMode());
+    state_.setDepthTest(material->hasDepthTest());
+    state_.setDepthWrite(material->hasDepthWrite());
+    state_.setDepthFunction(material->depthFunction());
+    state_.setBlend(material->hasBlend());
+    state_.setBlendFactor(material->srcBlendFactor(), material->dstBlendFactor());
 }
 
 #endif
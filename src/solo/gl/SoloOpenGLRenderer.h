@@ -10,6 +10,8 @@
 #ifdef SL_OPENGL_RENDERER
 
 #include "SoloRenderer.h"
+#include "SoloOpenGLStateCache.h"
+#include "SoloOpenGLUniformBufferRing.h"
 
 namespace solo
 {
@@ -21,21 +23,28 @@ namespace solo
         explicit OpenGLRenderer(Device *device);
         ~OpenGLRenderer() = default;
 
-        void beginCamera(Camera *camera, FrameBuffer *renderTarget) override final;
-        void endCamera(Camera *camera, FrameBuffer *renderTarget) override final;
-        void drawMesh(Mesh *mesh, Transform *transform, Material *material) override final;
-        void drawMeshPart(Mesh *mesh, u32 part, Transform *transform, Material *material) override final;
-
         auto name() const -> const char* override final { return name_.c_str(); }
         auto gpuName() const -> const char* override final;
 
+        // State changes issued to/skipped by the state cache since the beginning of the current frame
+        auto stateChanges() const -> OpenGLStateCache::Counters { return state_.counters(); }
+
     protected:
         void beginFrame() override final;
         void endFrame() override final;
 
+        void onBeginCamera(Camera *camera, FrameBuffer *renderTarget) override final;
+        void onEndCamera(Camera *camera, FrameBuffer *renderTarget) override final;
+        void onDrawMesh(Mesh *mesh, Transform *transform, Material *material) override final;
+        void onDrawMeshPart(Mesh *mesh, u32 part, Transform *transform, Material *material) override final;
+        void onDrawMeshInstanced(Mesh *mesh, s32 part, Material *material, Transform *const *transforms, u32 count) override final;
+
     private:
         str name_;
         Camera *currentCamera_ = nullptr;
+        OpenGLStateCache state_;
+        OpenGLUniformBufferRing uniformRing_;
+        vec<float> instanceData_;
 
         void applyMaterial(Material *material);
     };
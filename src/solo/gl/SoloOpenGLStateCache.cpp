@@ -0,0 +1,245 @@
+/* 
+ * Copyright (c) Aleksey Fedotov 
+ * MIT license 
+ */
+
+#include "SoloOpenGLStateCache.h"
+
+#ifdef SL_OPENGL_RENDERER
+
+#include "SoloOpenGLTexture.h"
+
+using namespace solo;
+
+static auto toBlendFactor(BlendFactor factor) -> GLenum
+{
+    switch (factor)
+    {
+        case BlendFactor::Zero:
+            return GL_ZERO;
+        case BlendFactor::One:
+            return GL_ONE;
+        case BlendFactor::SrcColor:
+            return GL_SRC_COLOR;
+        case BlendFactor::OneMinusSrcColor:
+            return GL_ONE_MINUS_SRC_COLOR;
+        case BlendFactor::DstColor:
+            return GL_DST_COLOR;
+        case BlendFactor::OneMinusDstColor:
+            return GL_ONE_MINUS_DST_COLOR;
+        case BlendFactor::SrcAlpha:
+            return GL_SRC_ALPHA;
+        case BlendFactor::OneMinusSrcAlpha:
+            return GL_ONE_MINUS_SRC_ALPHA;
+        case BlendFactor::DstAlpha:
+            return GL_DST_ALPHA;
+        case BlendFactor::OneMinusDstAlpha:
+            return GL_ONE_MINUS_DST_ALPHA;
+        case BlendFactor::ConstantAlpha:
+            return GL_CONSTANT_ALPHA;
+        case BlendFactor::OneMinusConstantAlpha:
+            return GL_ONE_MINUS_CONSTANT_ALPHA;
+        case BlendFactor::SrcAlphaSaturate:
+            return GL_SRC_ALPHA_SATURATE;
+    }
+
+    SL_DEBUG_PANIC(true, "Unsupported blend factor");
+    return 0;
+}
+
+static auto toDepthFunction(DepthFunction func) -> GLenum
+{
+    switch (func)
+    {
+        case DepthFunction::Never:
+            return GL_NEVER;
+        case DepthFunction::Less:
+            return GL_LESS;
+        case DepthFunction::Equal:
+            return GL_EQUAL;
+        case DepthFunction::LEqual:
+            return GL_LEQUAL;
+        case DepthFunction::Greater:
+            return GL_GREATER;
+        case DepthFunction::NotEqual:
+            return GL_NOTEQUAL;
+        case DepthFunction::GEqual:
+            return GL_GEQUAL;
+        case DepthFunction::Always:
+            return GL_ALWAYS;
+    }
+
+    SL_DEBUG_PANIC(true, "Unsupported depth function");
+    return 0;
+}
+
+static auto toPolygonMode(PolygonMode mode) -> GLenum
+{
+    switch (mode)
+    {
+        case PolygonMode::Fill:
+            return GL_FILL;
+        case PolygonMode::Wireframe:
+            return GL_LINE;
+        case PolygonMode::Points:
+            return GL_POINT;
+    }
+
+    SL_DEBUG_PANIC(true, "Unsupported polygon mode");
+    return 0;
+}
+
+constexpr u32 OpenGLStateCache::unknown;
+
+OpenGLStateCache::OpenGLStateCache()
+{
+    invalidate();
+}
+
+void OpenGLStateCache::invalidate()
+{
+    program_ = unknown;
+    vertexArray_ = unknown;
+    activeTextureUnit_ = unknown;
+    for (auto &texture: textures_)
+        texture = unknown;
+    for (auto &range: uniformBuffers_)
+        range.buffer = unknown;
+    faceCull_ = unknown;
+    polygonMode_ = unknown;
+    depthTest_ = unknown;
+    depthWrite_ = unknown;
+    depthFunc_ = unknown;
+    blend_ = unknown;
+    srcBlendFactor_ = unknown;
+    dstBlendFactor_ = unknown;
+}
+
+auto OpenGLStateCache::change(u32 &current, u32 value) -> bool
+{
+    if (current == value)
+    {
+        counters_.skipped++;
+        return false;
+    }
+
+    current = value;
+    counters_.issued++;
+    return true;
+}
+
+void OpenGLStateCache::useProgram(GLuint program)
+{
+    if (change(program_, program))
+        glUseProgram(program);
+}
+
+void OpenGLStateCache::bindVertexArray(GLuint vertexArray)
+{
+    if (change(vertexArray_, vertexArray))
+        glBindVertexArray(vertexArray);
+}
+
+void OpenGLStateCache::bindTexture(u32 unit, OpenGLTexture *texture)
+{
+    if (unit >= textures_.size())
+        textures_.resize(unit + 1, unknown);
+
+    // Changed sampling parameters have to be re-applied even if the texture is already bound
+    if (!change(textures_[unit], texture->handle()) && !texture->hasDirtyParams())
+        return;
+
+    if (activeTextureUnit_ != unit)
+    {
+        activeTextureUnit_ = unit;
+        glActiveTexture(GL_TEXTURE0 + unit);
+    }
+
+    texture->bind();
+}
+
+void OpenGLStateCache::bindUniformBuffer(u32 binding, GLuint buffer, u32 offset, u32 size)
+{
+    if (binding >= uniformBuffers_.size())
+        uniformBuffers_.resize(binding + 1, {unknown, 0, 0});
+
+    auto &range = uniformBuffers_[binding];
+    if (range.buffer == buffer && range.offset == offset && range.size == size)
+    {
+        counters_.skipped++;
+        return;
+    }
+
+    range = {buffer, offset, size};
+    counters_.issued++;
+    glBindBufferRange(GL_UNIFORM_BUFFER, binding, buffer, offset, size);
+}
+
+void OpenGLStateCache::setFaceCull(FaceCull cull)
+{
+    if (!change(faceCull_, static_cast<u32>(cull)))
+        return;
+
+    switch (cull)
+    {
+        case FaceCull::None:
+            glDisable(GL_CULL_FACE);
+            break;
+        case FaceCull::Back:
+            glEnable(GL_CULL_FACE);
+            glFrontFace(GL_CCW);
+            break;
+        case FaceCull::Front:
+            glEnable(GL_CULL_FACE);
+            glFrontFace(GL_CW);
+            break;
+        default:
+            break;
+    }
+}
+
+void OpenGLStateCache::setPolygonMode(PolygonMode mode)
+{
+    if (change(polygonMode_, static_cast<u32>(mode)))
+        glPolygonMode(GL_FRONT_AND_BACK, toPolygonMode(mode));
+}
+
+void OpenGLStateCache::setDepthTest(bool enabled)
+{
+    if (change(depthTest_, enabled))
+        enabled ? glEnable(GL_DEPTH_TEST) : glDisable(GL_DEPTH_TEST);
+}
+
+void OpenGLStateCache::setDepthWrite(bool enabled)
+{
+    if (change(depthWrite_, enabled))
+        glDepthMask(enabled ? GL_TRUE : GL_FALSE);
+}
+
+void OpenGLStateCache::setDepthFunction(DepthFunction func)
+{
+    if (change(depthFunc_, static_cast<u32>(func)))
+        glDepthFunc(toDepthFunction(func));
+}
+
+void OpenGLStateCache::setBlend(bool enabled)
+{
+    if (change(blend_, enabled))
+        enabled ? glEnable(GL_BLEND) : glDisable(GL_BLEND);
+}
+
+void OpenGLStateCache::setBlendFactor(BlendFactor srcFactor, BlendFactor dstFactor)
+{
+    if (srcBlendFactor_ == static_cast<u32>(srcFactor) && dstBlendFactor_ == static_cast<u32>(dstFactor))
+    {
+        counters_.skipped++;
+        return;
+    }
+
+    srcBlendFactor_ = static_cast<u32>(srcFactor);
+    dstBlendFactor_ = static_cast<u32>(dstFactor);
+    counters_.issued++;
+    glBlendFunc(toBlendFactor(srcFactor), toBlendFactor(dstFactor));
+}
+
+#endif
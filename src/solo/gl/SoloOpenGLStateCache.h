@@ -0,0 +1,80 @@
+/* 
+ * Copyright (c) Aleksey Fedotov 
+ * MIT license 
+ */
+
+#pragma once
+
+#include "SoloCommon.h"
+
+#ifdef SL_OPENGL_RENDERER
+
+#include "SoloMaterial.h"
+#include "SoloOpenGL.h"
+
+namespace solo
+{
+    class OpenGLTexture;
+
+    // Shadow copy of the GL state touched while drawing. Setters issue GL calls only when the value
+    // actually changes. GL objects are also bound outside of it (e.g. when creating resources), so
+    // the renderer invalidates it at the start of each camera.
+    class OpenGLStateCache final
+    {
+    public:
+        struct Counters
+        {
+            u32 issued = 0;
+            u32 skipped = 0;
+        };
+
+        OpenGLStateCache();
+
+        void invalidate();
+        void resetCounters() { counters_ = Counters(); }
+        auto counters() const -> Counters { return counters_; }
+
+        void useProgram(GLuint program);
+        void bindVertexArray(GLuint vertexArray);
+        void bindTexture(u32 unit, OpenGLTexture *texture);
+        void bindUniformBuffer(u32 binding, GLuint buffer, u32 offset, u32 size);
+
+        void setFaceCull(FaceCull cull);
+        void setPolygonMode(PolygonMode mode);
+        void setDepthTest(bool enabled);
+        void setDepthWrite(bool enabled);
+        void setDepthFunction(DepthFunction func);
+        void setBlend(bool enabled);
+        void setBlendFactor(BlendFactor srcFactor, BlendFactor dstFactor);
+
+    private:
+        static constexpr u32 unknown = ~0u;
+
+        struct UniformBufferRange
+        {
+            u32 buffer;
+            u32 offset;
+            u32 size;
+        };
+
+        u32 program_;
+        u32 vertexArray_;
+        u32 activeTextureUnit_;
+        vec<u32> textures_;
+        vec<UniformBufferRange> uniformBuffers_;
+        u32 faceCull_;
+        u32 polygonMode_;
+        u32 depthTest_;
+        u32 depthWrite_;
+        u32 depthFunc_;
+        u32 blend_;
+        u32 srcBlendFactor_;
+        u32 dstBlendFactor_;
+
+        Counters counters_;
+
+        auto change(u32 &current, u32 value) -> bool;
+    };
+}
+
+#endif
@@ -262,6 +262,8 @@ auto OpenGLTexture2D::empty(u32 width, u32 height, TextureFormat format) -> sptr
 void OpenGLTexture2D::bind()
 {
     glBindTexture(GL_TEXTURE_2D, handle_);
+    if (!paramsDirty_)
+        return;
 
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, toMinFilter(minFilter_, mipFilter_));
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, toMagFilter(magFilter_));
@@ -269,6 +271,8 @@ void OpenGLTexture2D::bind()
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, toWrap(verticalWrap_));
 
     glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_MAX_ANISOTROPY_EXT, anisotropyLevel_);
+
+    paramsDirty_ = false;
 }
 
 auto OpenGLCubeTexture::fromData(sptr<CubeTextureData> data) -> sptr<OpenGLCubeTexture>
@@ -302,6 +306,8 @@ OpenGLCubeTexture::OpenGLCubeTexture(TextureFormat format, u32 dimension):
 void OpenGLCubeTexture::bind()
 {
     glBindTexture(GL_TEXTURE_CUBE_MAP, handle_);
+    if (!paramsDirty_)
+        return;
 
     glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MIN_FILTER, toMinFilter(minFilter_, mipFilter_));
     glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MAG_FILTER, toMagFilter(magFilter_));
@@ -310,6 +316,8 @@ void OpenGLCubeTexture::bind()
     glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_R, toWrap(depthWrap_));
 
     glTexParameterf(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MAX_ANISOTROPY_EXT, anisotropyLevel_);
+
+    paramsDirty_ = false;
 }
 
 #endif
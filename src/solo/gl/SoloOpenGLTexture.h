@@ -21,11 +21,14 @@ namespace solo
         virtual ~OpenGLTexture();
 
         auto handle() const -> GLuint { return handle_; }
+        auto hasDirtyParams() const -> bool { return paramsDirty_; }
 
+        // Binds to the active texture unit. Sampling parameters are re-applied only when they've changed
         virtual void bind() = 0;
 
     protected:
         GLuint handle_ = 0;
+        bool paramsDirty_ = true;
     };
 
     class OpenGLTexture2D final: public Texture2D, public OpenGLTexture
@@ -38,6 +41,8 @@ namespace solo
 
     private:
         OpenGLTexture2D(TextureFormat format, Vector2 dimensions);
+
+        void rebuild() override final { paramsDirty_ = true; }
     };
 
     class OpenGLCubeTexture final : public CubeTexture, public OpenGLTexture
@@ -49,6 +54,8 @@ namespace solo
 
     private:
         OpenGLCubeTexture(TextureFormat format, u32 dimension);
+
+        void rebuild() override final { paramsDirty_ = true; }
     };
 }
 
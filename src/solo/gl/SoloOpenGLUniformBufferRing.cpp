@@ -0,0 +1,61 @@
+/* 
+ * Copyright (c) Aleksey Fedotov 
+ * MIT license 
+ */
+
+#include "SoloOpenGLUniformBufferRing.h"
+
+#ifdef SL_OPENGL_RENDERER
+
+#include <cstring>
+
+using namespace solo;
+
+OpenGLUniformBufferRing::OpenGLUniformBufferRing(u32 size):
+    size_(size)
+{
+    GLint alignment;
+    glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &alignment);
+    alignment_ = alignment;
+
+    glGenBuffers(1, &handle_);
+    SL_DEBUG_PANIC(!handle_, "Unable to create uniform buffer ring");
+
+    glBindBuffer(GL_UNIFORM_BUFFER, handle_);
+    glBufferData(GL_UNIFORM_BUFFER, size_, nullptr, GL_STREAM_DRAW);
+    glBindBuffer(GL_UNIFORM_BUFFER, 0);
+}
+
+OpenGLUniformBufferRing::~OpenGLUniformBufferRing()
+{
+    if (handle_)
+        glDeleteBuffers(1, &handle_);
+}
+
+auto OpenGLUniformBufferRing::push(const void *data, u32 size) -> u32
+{
+    SL_DEBUG_PANIC(size > size_, "Uniform data of size ", size, " does not fit into the ring");
+
+    glBindBuffer(GL_UNIFORM_BUFFER, handle_);
+
+    auto offset = (offset_ + alignment_ - 1) / alignment_ * alignment_;
+    if (offset + size > size_)
+    {
+        glBufferData(GL_UNIFORM_BUFFER, size_, nullptr, GL_STREAM_DRAW);
+        offset = 0;
+    }
+
+    // Nothing pending reads from this range - either it's never been written since the last orphaning
+    // or the storage behind it is fresh - so there's no need to synchronize
+    const auto access = GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_RANGE_BIT | GL_MAP_UNSYNCHRONIZED_BIT;
+    const auto dst = glMapBufferRange(GL_UNIFORM_BUFFER, offset, size, access);
+    std::memcpy(dst, data, size);
+    glUnmapBuffer(GL_UNIFORM_BUFFER);
+
+    glBindBuffer(GL_UNIFORM_BUFFER, 0);
+
+    offset_ = offset + size;
+    return offset;
+}
+
+#endif
@@ -0,0 +1,38 @@
+/* 
+ * Copyright (c) Aleksey Fedotov 
+ * MIT license 
+ */
+
+#pragma once
+
+#include "SoloCommon.h"
+
+#ifdef SL_OPENGL_RENDERER
+
+#include "SoloOpenGL.h"
+
+namespace solo
+{
+    // Streams per-object uniform data. Each push lands in a fresh, suitably aligned slice of a single buffer
+    // so draws only need to rebind a range of it. Once the buffer is full its storage is orphaned
+    // and writing starts over, so slices still used by in-flight draws are never overwritten.
+    class OpenGLUniformBufferRing final: public NoCopyAndMove
+    {
+    public:
+        explicit OpenGLUniformBufferRing(u32 size);
+        ~OpenGLUniformBufferRing();
+
+        auto handle() const -> GLuint { return handle_; }
+
+        // Returns the offset the data was written at
+        auto push(const void *data, u32 size) -> u32;
+
+    private:
+        GLuint handle_ = 0;
+        u32 size_ = 0;
+        u32 alignment_ = 0;
+        u32 offset_ = 0;
+    };
+}
+
+#endif
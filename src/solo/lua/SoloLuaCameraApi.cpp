@@ -39,6 +39,12 @@ void registerCameraApi(CppBindModule<LuaBinding> &module)
     REG_METHOD(binding, Camera, projectionMatrix);
     REG_METHOD(binding, Camera, viewProjectionMatrix);
     REG_METHOD(binding, Camera, invViewProjectionMatrix);
+    REG_METHOD(binding, Camera, frustum);
+    REG_METHOD(binding, Camera, drawnCount);
+    REG_METHOD(binding, Camera, culledCount);
+    REG_METHOD(binding, Camera, occludedCount);
+    REG_METHOD(binding, Camera, hasOcclusionCulling);
+    REG_METHOD(binding, Camera, setOcclusionCulling);
     REG_PTR_EQUALITY(binding, Camera);
     binding.endClass();
 }
@@ -19,6 +19,8 @@ static void registerDevice(CppBindModule<LuaBinding> &module)
     REG_METHOD(binding, Device, canvasSize);
     REG_METHOD(binding, Device, dpiIndependentCanvasSize);
     REG_METHOD(binding, Device, isVsync);
+    REG_METHOD(binding, Device, renderThreadCount);
+    REG_METHOD(binding, Device, shaderCacheDirectory);
     REG_METHOD(binding, Device, mode);
     REG_METHOD(binding, Device, saveScreenshot);
     REG_METHOD(binding, Device, setCursorCaptured);
@@ -51,6 +53,8 @@ void registerDeviceSetup(CppBindModule<LuaBinding> &module)
     REG_FIELD(setup, DeviceSetup, fullScreen);
     REG_FIELD(setup, DeviceSetup, windowTitle);
     REG_FIELD(setup, DeviceSetup, vsync);
+    REG_FIELD(setup, DeviceSetup, renderThreadCount);
+    REG_FIELD(setup, DeviceSetup, shaderCacheDirectory);
     REG_FIELD(setup, DeviceSetup, logFilePath);
     setup.endClass();
 }
@@ -72,6 +72,15 @@ void registerEnums(CppBindModule<LuaBinding> &module)
         m.endModule();
     }
 
+    {
+        auto m = module.beginModule("RenderOrder");
+        REG_MODULE_CONSTANT(m, RenderOrder, Background);
+        REG_MODULE_CONSTANT(m, RenderOrder, Opaque);
+        REG_MODULE_CONSTANT(m, RenderOrder, Transparent);
+        REG_MODULE_CONSTANT(m, RenderOrder, Overlay);
+        m.endModule();
+    }
+
     {
         auto m = module.beginModule("DepthFunction");
         REG_MODULE_CONSTANT(m, DepthFunction, Never);
@@ -197,6 +206,13 @@ void registerEnums(CppBindModule<LuaBinding> &module)
         m.endModule();
     }
 
+    {
+        auto m = module.beginModule("IndexElementSize");
+        REG_MODULE_CONSTANT(m, IndexElementSize, Bits16);
+        REG_MODULE_CONSTANT(m, IndexElementSize, Bits32);
+        m.endModule();
+    }
+
     {
         auto m = module.beginModule("VertexAttributeUsage");
         REG_MODULE_CONSTANT(m, VertexAttributeUsage, Position);
@@ -204,6 +220,17 @@ void registerEnums(CppBindModule<LuaBinding> &module)
         REG_MODULE_CONSTANT(m, VertexAttributeUsage, TexCoord);
         REG_MODULE_CONSTANT(m, VertexAttributeUsage, Tangent);
         REG_MODULE_CONSTANT(m, VertexAttributeUsage, Binormal);
+        REG_MODULE_CONSTANT(m, VertexAttributeUsage, Color);
+        m.endModule();
+    }
+
+    {
+        auto m = module.beginModule("VertexAttributeFormat");
+        REG_MODULE_CONSTANT(m, VertexAttributeFormat, Float);
+        REG_MODULE_CONSTANT(m, VertexAttributeFormat, Half);
+        REG_MODULE_CONSTANT(m, VertexAttributeFormat, SNorm8);
+        REG_MODULE_CONSTANT(m, VertexAttributeFormat, UNorm8);
+        REG_MODULE_CONSTANT(m, VertexAttributeFormat, SNorm10_10_10_2);
         m.endModule();
     }
 }
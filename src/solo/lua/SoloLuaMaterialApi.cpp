@@ -12,13 +12,22 @@ void registerMaterialApi(CppBindModule<LuaBinding> &module)
 {
     auto binding = BEGIN_CLASS(module, Material);
     REG_STATIC_METHOD(binding, Material, fromEffect);
-    REG_METHOD(binding, Material, setFloatParameter);
-    REG_METHOD(binding, Material, setVector2Parameter);
-    REG_METHOD(binding, Material, setVector3Parameter);
-    REG_METHOD(binding, Material, setVector4Parameter);
-    REG_METHOD(binding, Material, setMatrixParameter);
-    REG_METHOD(binding, Material, setTextureParameter);
-    REG_METHOD(binding, Material, bindParameter);
+    REG_METHOD_OVERLOADED(binding, Material, setFloatParameter, "setFloatParameter", void, , const str&, float);
+    REG_METHOD_OVERLOADED(binding, Material, setVector2Parameter, "setVector2Parameter", void, , const str&, const Vector2&);
+    REG_METHOD_OVERLOADED(binding, Material, setVector3Parameter, "setVector3Parameter", void, , const str&, const Vector3&);
+    REG_METHOD_OVERLOADED(binding, Material, setVector4Parameter, "setVector4Parameter", void, , const str&, const Vector4&);
+    REG_METHOD_OVERLOADED(binding, Material, setMatrixParameter, "setMatrixParameter", void, , const str&, const Matrix&);
+    REG_METHOD_OVERLOADED(binding, Material, setTextureParameter, "setTextureParameter", void, , const str&, sptr<Texture>);
+    REG_METHOD_OVERLOADED(binding, Material, bindParameter, "bindParameter", void, , const str&, ParameterBinding);
+    REG_METHOD(binding, Material, parameterHandle);
+    // Lua has no overloading, so handle-based setters go by shorter names
+    REG_METHOD_OVERLOADED(binding, Material, setFloatParameter, "setFloat", void, , ParamHandle, float);
+    REG_METHOD_OVERLOADED(binding, Material, setVector2Parameter, "setVector2", void, , ParamHandle, const Vector2&);
+    REG_METHOD_OVERLOADED(binding, Material, setVector3Parameter, "setVector3", void, , ParamHandle, const Vector3&);
+    REG_METHOD_OVERLOADED(binding, Material, setVector4Parameter, "setVector4", void, , ParamHandle, const Vector4&);
+    REG_METHOD_OVERLOADED(binding, Material, setMatrixParameter, "setMatrix", void, , ParamHandle, const Matrix&);
+    REG_METHOD_OVERLOADED(binding, Material, setTextureParameter, "setTexture", void, , ParamHandle, sptr<Texture>);
+    REG_METHOD_OVERLOADED(binding, Material, bindParameter, "bind", void, , ParamHandle, ParameterBinding);
     REG_METHOD(binding, Material, effect);
     REG_METHOD(binding, Material, polygonMode);
     REG_METHOD(binding, Material, setPolygonMode);
@@ -35,6 +44,8 @@ void registerMaterialApi(CppBindModule<LuaBinding> &module)
     REG_METHOD(binding, Material, setDepthTest);
     REG_METHOD(binding, Material, depthFunction);
     REG_METHOD(binding, Material, setDepthFunction);
+    REG_METHOD(binding, Material, renderOrder);
+    REG_METHOD(binding, Material, setRenderOrder);
     REG_PTR_EQUALITY(binding, Material);
     binding.endClass();
 }
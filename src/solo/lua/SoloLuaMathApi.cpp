@@ -11,6 +11,8 @@
 #include "SoloQuaternion.h"
 #include "SoloMatrix.h"
 #include "SoloRay.h"
+#include "SoloBoundingBox.h"
+#include "SoloFrustum.h"
 #include "SoloLuaCommon.h"
 
 using namespace solo;
@@ -217,6 +219,28 @@ static void registerRay(CppBindModule<LuaBinding> &module)
     binding.endClass();
 }
 
+static void registerBoundingBox(CppBindModule<LuaBinding> &module)
+{
+    auto binding = BEGIN_CLASS(module, BoundingBox);
+    REG_CTOR(binding, const Vector3&, const Vector3&);
+    REG_METHOD(binding, BoundingBox, min);
+    REG_METHOD(binding, BoundingBox, max);
+    REG_METHOD(binding, BoundingBox, center);
+    REG_METHOD(binding, BoundingBox, extents);
+    REG_METHOD(binding, BoundingBox, isEmpty);
+    REG_METHOD(binding, BoundingBox, isInfinite);
+    REG_METHOD(binding, BoundingBox, transformed);
+    binding.endClass();
+}
+
+static void registerFrustum(CppBindModule<LuaBinding> &module)
+{
+    auto binding = BEGIN_CLASS(module, Frustum);
+    REG_CTOR(binding, const Matrix&);
+    REG_METHOD(binding, Frustum, intersects);
+    binding.endClass();
+}
+
 void registerMathApi(CppBindModule<LuaBinding> &module)
 {
     registerRadians(module);
@@ -227,4 +251,6 @@ void registerMathApi(CppBindModule<LuaBinding> &module)
     registerQuaternion(module);
     registerMatrix(module);
     registerRay(module);
+    registerBoundingBox(module);
+    registerFrustum(module);
 }
@@ -5,6 +5,7 @@
 
 #include "SoloLuaCommon.h"
 #include "SoloMesh.h"
+#include "SoloCookedMesh.h"
 
 using namespace solo;
 
@@ -23,9 +24,10 @@ static void updateDynamicVertexBuffer(Mesh *mesh, u32 index, u32 vertexOffset, c
     mesh->updateDynamicVertexBuffer(index, vertexOffset, data.data(), vertexCount);
 }
 
-static auto addPart(Mesh *mesh, const vec<u32> &indexData, u32 indexElementCount) -> u32 // TODO 16-bit index support?
+static auto addPart(Mesh *mesh, const vec<u32> &indexData, u32 indexElementCount) -> u32
 {
-    return mesh->addPart(indexData.data(), indexElementCount);
+    SL_DEBUG_PANIC(indexElementCount > indexData.size(), "Index element count exceeds index data size");
+    return mesh->addCompactPart(vec<u32>(indexData.begin(), indexData.begin() + indexElementCount));
 }
 
 static void registerVertexBufferLayout(CppBindModule<LuaBinding> &module)
@@ -37,11 +39,13 @@ static void registerVertexBufferLayout(CppBindModule<LuaBinding> &module)
     REG_FIELD(el, VertexAttribute, size);
     REG_FIELD(el, VertexAttribute, offset);
     REG_FIELD(el, VertexAttribute, usage);
+    REG_FIELD(el, VertexAttribute, format);
     el.endClass();
 
     auto layout = BEGIN_CLASS(module, VertexBufferLayout);
     REG_CTOR(layout);
     REG_METHOD_OVERLOADED(layout, VertexBufferLayout, addAttribute, "addAttribute", void, , VertexAttributeUsage);
+    REG_METHOD_OVERLOADED(layout, VertexBufferLayout, addAttribute, "addFormattedAttribute", void, , VertexAttributeUsage, VertexAttributeFormat);
     REG_METHOD(layout, VertexBufferLayout, attribute);
     REG_METHOD(layout, VertexBufferLayout, attributeCount);
     REG_METHOD(layout, VertexBufferLayout, size);
@@ -56,6 +60,8 @@ static void registerMesh(CppBindModule<LuaBinding> &module)
         REG_STATIC_METHOD(binding, Mesh, empty);
         REG_STATIC_METHOD(binding, Mesh, fromFile);
         REG_STATIC_METHOD(binding, Mesh, fromFileAsync);
+        REG_STATIC_METHOD(binding, Mesh, fromFileWithOccluder);
+        REG_STATIC_METHOD(binding, Mesh, lodChainFromFile);
         REG_FREE_FUNC_AS_METHOD(binding, addVertexBuffer);
         REG_FREE_FUNC_AS_METHOD(binding, addDynamicVertexBuffer);
         REG_FREE_FUNC_AS_METHOD(binding, updateDynamicVertexBuffer);
@@ -63,11 +69,20 @@ static void registerMesh(CppBindModule<LuaBinding> &module)
         REG_FREE_FUNC_AS_METHOD(binding, addPart);
         REG_METHOD(binding, Mesh, removePart);
         REG_METHOD(binding, Mesh, partCount);
+        REG_METHOD(binding, Mesh, partIndexElementSize);
         REG_METHOD(binding, Mesh, primitiveType);
         REG_METHOD(binding, Mesh, setPrimitiveType);
+        REG_METHOD_OVERLOADED(binding, Mesh, setOccluderGeometry, "setOccluderGeometry", void, , const vec<float>&, const vec<u32>&);
+        REG_METHOD(binding, Mesh, hasOccluderGeometry);
         REG_PTR_EQUALITY(binding, Mesh);
         binding.endClass();
     }
+    {
+        auto binding = BEGIN_CLASS(module, CookedMesh);
+        REG_STATIC_METHOD(binding, CookedMesh, isCookedPath);
+        REG_STATIC_METHOD(binding, CookedMesh, cookFile);
+        binding.endClass();
+    }
     {
         auto binding = BEGIN_CLASS_RENAMED(module, AsyncHandle<Mesh>, "MeshAsyncHandle");
         REG_METHOD(binding, AsyncHandle<Mesh>, done);
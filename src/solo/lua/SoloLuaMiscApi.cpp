@@ -7,6 +7,7 @@
 #include "SoloLuaCommon.h"
 #include "SoloScene.h"
 #include "SoloMeshRenderer.h"
+#include "SoloLodGroup.h"
 #include "SoloEffect.h"
 #include "SoloFileSystem.h"
 #include "SoloSpectator.h"
@@ -33,6 +34,10 @@ static void registerScene(CppBindModule<LuaBinding> &module)
     REG_METHOD(binding, Scene, removeNodeById);
     REG_METHOD(binding, Scene, visit);
     REG_METHOD(binding, Scene, visitByTags);
+    REG_METHOD(binding, Scene, queryRenderersInBox);
+    REG_METHOD(binding, Scene, queryRenderersInSphere);
+    REG_METHOD(binding, Scene, queryRenderersInFrustum);
+    REG_METHOD(binding, Scene, queryRenderersByRay);
     REG_PTR_EQUALITY(binding, Scene);
     binding.endClass();
 }
@@ -47,10 +52,30 @@ static void registerMeshRenderer(CppBindModule<LuaBinding> &module)
     REG_METHOD_NULLABLE_2ND_ARG(binding, MeshRenderer, setMaterial, u32, sptr<Material>);
     REG_METHOD_NULLABLE_1ST_ARG(binding, MeshRenderer, setDefaultMaterial, sptr<Material>);
     REG_METHOD(binding, MeshRenderer, materialCount);
+    REG_METHOD(binding, MeshRenderer, hasFrustumCulling);
+    REG_METHOD(binding, MeshRenderer, setFrustumCulling);
+    REG_METHOD(binding, MeshRenderer, worldBounds);
+    REG_METHOD(binding, MeshRenderer, isOccluder);
+    REG_METHOD(binding, MeshRenderer, setOccluder);
+    REG_METHOD(binding, MeshRenderer, isOccludee);
+    REG_METHOD(binding, MeshRenderer, setOccludee);
     REG_PTR_EQUALITY(binding, MeshRenderer);
     binding.endClass();
 }
 
+static void registerLodGroup(CppBindModule<LuaBinding> &module)
+{
+    auto binding = BEGIN_CLASS_EXTEND(module, LodGroup, Component);
+    REG_METHOD(binding, LodGroup, addLevel);
+    REG_METHOD(binding, LodGroup, clearLevels);
+    REG_METHOD(binding, LodGroup, levelCount);
+    REG_METHOD(binding, LodGroup, levelMesh);
+    REG_METHOD(binding, LodGroup, levelMinScreenSize);
+    REG_METHOD(binding, LodGroup, selectLevel);
+    REG_STATIC_METHOD(binding, LodGroup, screenSize);
+    REG_PTR_EQUALITY(binding, LodGroup);
+}
+
 static void registerSpectator(CppBindModule<LuaBinding> &module)
 {
     auto binding = BEGIN_CLASS_EXTEND(module, Spectator, Component);
@@ -65,17 +90,26 @@ static void registerSpectator(CppBindModule<LuaBinding> &module)
 
 static void registerEffect(CppBindModule<LuaBinding> &module)
 {
-    auto binding = BEGIN_CLASS(module, Effect);
-    REG_STATIC_METHOD(binding, Effect, fromSourceFile);
-    REG_STATIC_METHOD(binding, Effect, fromDescriptionFile);
-    REG_STATIC_METHOD(binding, Effect, fromSource);
-    REG_PTR_EQUALITY(binding, Effect);
-    binding.endClass();
+    {
+        auto binding = BEGIN_CLASS(module, Effect);
+        REG_STATIC_METHOD(binding, Effect, fromSourceFile);
+        REG_STATIC_METHOD(binding, Effect, fromDescriptionFile);
+        REG_STATIC_METHOD(binding, Effect, fromDescriptionFileAsync);
+        REG_STATIC_METHOD(binding, Effect, fromSource);
+        REG_PTR_EQUALITY(binding, Effect);
+        binding.endClass();
+    }
+    {
+        auto binding = BEGIN_CLASS_RENAMED(module, AsyncHandle<Effect>, "EffectAsyncHandle");
+        REG_METHOD(binding, AsyncHandle<Effect>, done);
+        binding.endClass();
+    }
 }
 
 static void registerFileSystem(CppBindModule<LuaBinding> &module)
 {
     auto binding = BEGIN_CLASS(module, FileSystem);
+    REG_METHOD(binding, FileSystem, exists);
     REG_METHOD(binding, FileSystem, readBytes);
     REG_METHOD(binding, FileSystem, writeBytes);
     REG_METHOD(binding, FileSystem, readText);
@@ -88,11 +122,22 @@ static void registerFileSystem(CppBindModule<LuaBinding> &module)
 
 static void registerRenderer(CppBindModule<LuaBinding> &module)
 {
-    auto binding = BEGIN_CLASS(module, Renderer);
-    REG_METHOD(binding, Renderer, name);
-    REG_METHOD(binding, Renderer, gpuName);
-    REG_PTR_EQUALITY(binding, Renderer);
-    binding.endClass();
+    {
+        auto binding = BEGIN_CLASS(module, Renderer);
+        REG_METHOD(binding, Renderer, name);
+        REG_METHOD(binding, Renderer, gpuName);
+        REG_METHOD(binding, Renderer, renderQueueStats);
+        REG_PTR_EQUALITY(binding, Renderer);
+        binding.endClass();
+    }
+    {
+        auto binding = BEGIN_CLASS_RENAMED(module, RenderQueue::Stats, "RenderQueueStats");
+        REG_FIELD(binding, RenderQueue::Stats, drawCount);
+        REG_FIELD(binding, RenderQueue::Stats, batchCount);
+        REG_FIELD(binding, RenderQueue::Stats, submittedStateChanges);
+        REG_FIELD(binding, RenderQueue::Stats, sortedStateChanges);
+        binding.endClass();
+    }
 }
 
 void registerMiscApi(CppBindModule<LuaBinding> &module)
@@ -100,6 +145,7 @@ void registerMiscApi(CppBindModule<LuaBinding> &module)
     registerFileSystem(module);
     registerEffect(module);
     registerMeshRenderer(module);
+    registerLodGroup(module);
     registerScene(module);
     registerRenderer(module);
     registerFrameBuffer(module);
@@ -6,6 +6,7 @@
 #include "SoloLuaScriptComponent.h"
 #include "SoloTransform.h"
 #include "SoloMeshRenderer.h"
+#include "SoloLodGroup.h"
 #include "SoloCamera.h"
 #include "SoloSpectator.h"
 #include "SoloLuaCommon.h"
@@ -16,6 +17,7 @@ using namespace solo;
 static umap<str, u32> builtInComponents = {
     {"Transform", Transform::getId()},
     {"MeshRenderer", MeshRenderer::getId()},
+    {"LodGroup", LodGroup::getId()},
     {"Camera", Camera::getId()},
     {"Spectator", Spectator::getId()},
     {"RigidBody", RigidBody::getId()}
@@ -33,6 +35,8 @@ static auto addComponent(Node *node, const str &name, const LuaRef& arg) -> Comp
         return node->addComponent<Transform>();
     if (name == "MeshRenderer")
         return node->addComponent<MeshRenderer>();
+    if (name == "LodGroup")
+        return node->addComponent<LodGroup>();
     if (name == "Camera")
         return node->addComponent<Camera>();
     if (name == "Spectator")
@@ -75,7 +75,8 @@ static void registerLibrary(LuaState &state)
                         and string.format("layout (location = %d) %s %s %s;", location, typeStr, type, name)
                         or string.format("%s %s %s;", typeStr, type, name)
                     all[#all + 1] = s
-                    location = location + 1
+                    -- Matrices take a location per column
+                    location = location + (type == "mat4" and 4 or type == "mat3" and 3 or 1)
                 end
                 return table.concat(all, "\n")
             end
@@ -103,40 +104,38 @@ static void registerLibrary(LuaState &state)
                 return table.concat(all, "\n")
             end
         
-            function generateBuffer(name, desc, binding)
-                local result = vulkan and string.format("layout (binding = %d) uniform _%s {\n", binding, name) or ""
+            -- On OpenGL buffers become std140 blocks, bound to the program's own block indices
+            function generateBuffer(name, desc, layout)
+                local result = string.format("layout (%s) uniform _%s {\n", vulkan and layout or "std140", name)
         
                 for varName, varType in pairs(desc or {}) do
-                    local prefix = (not vulkan) and "uniform " or ""
-                    local newVarName = vulkan and varName or string.format("%s_%s", name, varName)
-                    local varStr = string.format("%s%s %s;\n", prefix, varType, newVarName)
-                    result = result .. varStr
+                    result = result .. string.format("%s %s;\n", varType, varName)
                 end
         
-                if vulkan then
-                    result = string.format("%s} %s;", result, name)
-                end
-        
-                return result .. "\n"
+                return string.format("%s} %s;\n", result, name)
             end
         
             function generateBuffers(desc, binding)
                 local all = {}
                 local count = 0
                 for name, desc in pairs(desc or {}) do
-                    all[#all + 1] = generateBuffer(name, desc, binding)
+                    all[#all + 1] = generateBuffer(name, desc, string.format("binding = %d", binding))
                     binding = binding + 1
                     count = count + 1
                 end
                 return table.concat(all, "\n"), count
             end
+
+            -- Push constants are a single buffer, on OpenGL they become an ordinary uniform block
+            function generatePushConstants(desc)
+                for name, desc in pairs(desc or {}) do
+                    return generateBuffer(name, desc, "push_constant")
+                end
+                return ""
+            end
         
             function generateCode(raw)
-                raw = string.gsub(raw, "#([_0-9a-zA-Z]+):([_0-9a-zA-Z]+)#", function(buffer, uniform)
-                    return vulkan
-                        and string.format("%s.%s", buffer, uniform)
-                        or string.format("%s_%s", buffer, uniform)
-                end)
+                raw = string.gsub(raw, "#([_0-9a-zA-Z]+):([_0-9a-zA-Z]+)#", "%1.%2")
 
                 raw = string.gsub(raw, "SL_FIX_Y#([_0-9a-zA-Z]+)#", function(varName)
                     return vulkan and string.format("%s.y = -%s.y", varName, varName) or ""
@@ -166,6 +165,7 @@ static void registerLibrary(LuaState &state)
             local versionAttr = vulkan and "#version 450" or "#version 330"
         
             local vsUniformBuffers, vsUniformBufferCount = generateBuffers(desc.vertex.uniformBuffers, 0)
+            local vsPushConstants = generatePushConstants(desc.vertex.pushConstants)
             local vsInputs = generateAttributes(desc.vertex.inputs, "in")
             local vsOutputs = generateAttributes(desc.vertex.outputs, "out")
             local vsCode = generateCode(desc.vertex.code)
@@ -183,6 +183,7 @@ static void registerLibrary(LuaState &state)
                 %s
                 %s
                 %s
+                %s
 
                 // FRAGMENT
                 %s
@@ -192,7 +193,7 @@ static void registerLibrary(LuaState &state)
                 %s
                 %s
             ]],
-                versionAttr, vsUniformBuffers, vsInputs, vsOutputs, vsCode,
+                versionAttr, vsUniformBuffers, vsPushConstants, vsInputs, vsOutputs, vsCode,
                 versionAttr, fsUniformBuffers, fsSamplers, fsInputs, fsOutputs, fsCode
             )
 
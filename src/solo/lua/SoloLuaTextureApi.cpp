@@ -4,7 +4,7 @@
  */
 
 #include "SoloTexture.h"
-#include "SoloTexture.h"
+#include "SoloCookedTexture.h"
 #include "SoloLuaCommon.h"
 
 using namespace solo;
@@ -64,9 +64,18 @@ static void registerCubeTexture(CppBindModule<LuaBinding> &module)
     }
 }
 
+static void registerCookedTexture(CppBindModule<LuaBinding> &module)
+{
+    auto binding = BEGIN_CLASS(module, CookedTexture);
+    REG_STATIC_METHOD(binding, CookedTexture, isCookedPath);
+    REG_STATIC_METHOD(binding, CookedTexture, cookFile);
+    binding.endClass();
+}
+
 void registerTextureApi(CppBindModule<LuaBinding> &module)
 {
     registerTexture(module);
     registerTexture2D(module);
     registerCubeTexture(module);
+    registerCookedTexture(module);
 }
\ No newline at end of file
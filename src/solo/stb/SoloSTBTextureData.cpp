@@ -43,12 +43,24 @@ STBTexture2DData::~STBTexture2DData()
 
 auto STBTexture2DData::fromFile(Device *device, const str &path) -> sptr<STBTexture2DData>
 {
-    auto bytes = device->fileSystem()->readBytes(path);
+    const auto mapping = device->fileSystem()->map(path);
+    const auto result = fromBytes(mapping->data(), mapping->size(), device->mode() == DeviceMode::OpenGL);
+    SL_DEBUG_PANIC(!result, "Unable to load image ", path);
+    return result;
+}
+
+auto STBTexture2DData::fromBytes(const u8 *bytes, size_t size, bool flipVertically) -> sptr<STBTexture2DData>
+{
     int width, height, channels;
-    stbi_set_flip_vertically_on_load(device->mode() == DeviceMode::OpenGL);
+    stbi_set_flip_vertically_on_load(flipVertically);
     // According to the docs, channels are not affected by the requested channels
-    const auto data = stbi_load_from_memory(bytes.data(), bytes.size(), &width, &height, &channels, 4);
-    SL_DEBUG_PANIC(!data, "Unable to load image ", path);
+    const auto data = stbi_load_from_memory(bytes, static_cast<int>(size), &width, &height, &channels, 4);
+    if (!data)
+    {
+        // Tools decode untrusted files and report failures themselves, so this does not panic
+        Logger::global().logError(SL_FMT("Unable to decode image: ", stbi_failure_reason()));
+        return nullptr;
+    }
 
     const auto result = std::make_shared<STBTexture2DData>(toFormat(4), Vector2(width, height));
     result->channels_ = 4;
@@ -18,6 +18,7 @@ namespace solo
     public:
         static bool canLoadFromFile(const str &path);
         static auto fromFile(Device *device, const str &path) -> sptr<STBTexture2DData>;
+        static auto fromBytes(const u8 *bytes, size_t size, bool flipVertically) -> sptr<STBTexture2DData>;
 
         STBTexture2DData(TextureDataFormat format, Vector2 dimensions);
         ~STBTexture2DData();
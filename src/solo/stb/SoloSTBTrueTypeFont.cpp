@@ -56,7 +56,8 @@ bool STBTrueTypeFont::canLoadFromFile(const str &path)
 auto STBTrueTypeFont::loadFromFile(Device *device, const str &path, u32 size, u32 atlasWidth, u32 atlasHeight,
     u32 firstChar, u32 charCount, u32 oversampleX, u32 oversampleY) -> sptr<STBTrueTypeFont>
 {
-    auto data = device->fileSystem()->readBytes(path);
+    // Only needed while packing the atlas
+    const auto data = device->fileSystem()->map(path);
 
     auto result = sptr<STBTrueTypeFont>(new STBTrueTypeFont());
     result->firstChar_ = firstChar;
@@ -70,7 +71,7 @@ auto STBTrueTypeFont::loadFromFile(Device *device, const str &path, u32 size, u3
     SL_DEBUG_PANIC(!ret, "Unable to process font ", path);
 
     stbtt_PackSetOversampling(&context, oversampleX, oversampleY);
-    stbtt_PackFontRange(&context, data.data(), 0, static_cast<float>(size), firstChar, charCount, result->charInfo_.get());
+    stbtt_PackFontRange(&context, const_cast<u8*>(data->data()), 0, static_cast<float>(size), firstChar, charCount, result->charInfo_.get());
     stbtt_PackEnd(&context);
 
     const auto atlasData = Texture2DData::fromMemory(atlasWidth, atlasHeight, TextureDataFormat::Red, pixels);
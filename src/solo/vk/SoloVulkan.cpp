@@ -22,22 +22,35 @@ auto vk::createSemaphore(VkDevice device) -> VulkanResource<VkSemaphore>
     return semaphore;
 }
 
+auto vk::createCommandPool(VkDevice device, u32 queueIndex) -> VulkanResource<VkCommandPool>
+{
+    VkCommandPoolCreateInfo poolInfo{};
+    poolInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+    poolInfo.queueFamilyIndex = queueIndex;
+    poolInfo.flags = VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT;
+
+    VulkanResource<VkCommandPool> commandPool{device, vkDestroyCommandPool};
+    SL_VK_CHECK_RESULT(vkCreateCommandPool(device, &poolInfo, nullptr, commandPool.cleanRef()));
+
+    return commandPool;
+}
+
 void vk::queueSubmit(VkQueue queue, u32 waitSemaphoreCount, const VkSemaphore *waitSemaphores,
     u32 signalSemaphoreCount, const VkSemaphore *signalSemaphores,
-    u32 commandBufferCount, const VkCommandBuffer *commandBuffers)
+    u32 commandBufferCount, const VkCommandBuffer *commandBuffers, const VkPipelineStageFlags *waitStages, VkFence fence)
 {
-    VkPipelineStageFlags submitPipelineStages = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+    const vec<VkPipelineStageFlags> defaultWaitStages(waitSemaphoreCount, VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT);
 
     VkSubmitInfo info{};
     info.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
-    info.pWaitDstStageMask = &submitPipelineStages;
+    info.pWaitDstStageMask = waitStages ? waitStages : defaultWaitStages.data();
     info.waitSemaphoreCount = waitSemaphoreCount;
     info.pWaitSemaphores = waitSemaphores;
     info.signalSemaphoreCount = signalSemaphoreCount;
     info.pSignalSemaphores = signalSemaphores;
     info.commandBufferCount = commandBufferCount;
     info.pCommandBuffers = commandBuffers;
-    SL_VK_CHECK_RESULT(vkQueueSubmit(queue, 1, &info, VK_NULL_HANDLE));
+    SL_VK_CHECK_RESULT(vkQueueSubmit(queue, 1, &info, fence));
 }
 
 auto vk::findMemoryType(VkPhysicalDeviceMemoryProperties physicalDeviceMemoryProperties, u32 typeBits,
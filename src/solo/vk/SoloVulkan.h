@@ -27,9 +27,12 @@ namespace solo
     namespace vk
     {
         auto createSemaphore(VkDevice device) -> VulkanResource<VkSemaphore>;
+        auto createCommandPool(VkDevice device, u32 queueIndex) -> VulkanResource<VkCommandPool>;
+        // Waits happen at the color attachment output stage unless waitStages are given, one per semaphore
         void queueSubmit(VkQueue queue, u32 waitSemaphoreCount, const VkSemaphore *waitSemaphores,
             u32 signalSemaphoreCount, const VkSemaphore *signalSemaphores,
-            u32 commandBufferCount, const VkCommandBuffer *commandBuffers);
+            u32 commandBufferCount, const VkCommandBuffer *commandBuffers,
+            const VkPipelineStageFlags *waitStages = nullptr, VkFence fence = VK_NULL_HANDLE);
         auto findMemoryType(VkPhysicalDeviceMemoryProperties physicalDeviceMemoryProperties, u32 typeBits,
             VkMemoryPropertyFlags properties) -> s32;
         auto createFrameBuffer(VkDevice device, const vec<VkImageView> &attachments,
@@ -9,6 +9,7 @@
 
 #include "SoloVulkanRenderer.h"
 #include "SoloVulkanCmdBuffer.h"
+#include "SoloVulkanUploader.h"
 
 using namespace solo;
 
@@ -33,9 +34,9 @@ auto VulkanBuffer::uniformHostVisible(const VulkanDevice &dev, VkDeviceSize size
 
 auto VulkanBuffer::deviceLocal(const VulkanDevice &dev, VkDeviceSize size, VkBufferUsageFlags usageFlags, const void *data) -> VulkanBuffer
 {
-    auto stagingBuffer = staging(dev, size, data);
     auto buffer = VulkanBuffer(dev, size, VK_BUFFER_USAGE_TRANSFER_DST_BIT | usageFlags, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
-    stagingBuffer.transferTo(buffer);
+    if (data)
+        dev.uploader().uploadBuffer(data, size, buffer);
     return buffer;
 }
 
@@ -59,6 +60,15 @@ VulkanBuffer::VulkanBuffer(const VulkanDevice &dev, VkDeviceSize size, VkBufferU
     bufferInfo.queueFamilyIndexCount = 0;
     bufferInfo.pQueueFamilyIndices = nullptr;
 
+    // Uploads are copied on the transfer queue and consumed on the graphics one
+    const u32 queueIndices[] = {dev.queueIndex(), dev.transferQueueIndex()};
+    if (queueIndices[0] != queueIndices[1])
+    {
+        bufferInfo.sharingMode = VK_SHARING_MODE_CONCURRENT;
+        bufferInfo.queueFamilyIndexCount = 2;
+        bufferInfo.pQueueFamilyIndices = queueIndices;
+    }
+
     buffer_ = VulkanResource<VkBuffer>{dev.handle(), vkDestroyBuffer};
     SL_VK_CHECK_RESULT(vkCreateBuffer(dev.handle(), &bufferInfo, nullptr, buffer_.cleanRef()));
 
@@ -13,39 +13,57 @@
 using namespace solo;
 
 VulkanCmdBuffer::VulkanCmdBuffer(const VulkanDevice &dev):
-    device_(&dev)
+    VulkanCmdBuffer(dev.handle(), dev.commandPool(), VK_COMMAND_BUFFER_LEVEL_PRIMARY)
+{
+    device_ = &dev;
+}
+
+VulkanCmdBuffer::VulkanCmdBuffer(VkDevice device, VkCommandPool pool, VkCommandBufferLevel level)
 {
     VkCommandBufferAllocateInfo allocateInfo{};
     allocateInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
     allocateInfo.pNext = nullptr;
-    allocateInfo.commandPool = dev.commandPool();
-    allocateInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+    allocateInfo.commandPool = pool;
+    allocateInfo.level = level;
     allocateInfo.commandBufferCount = 1;
 
-    handle_ = VulkanResource<VkCommandBuffer>{dev.handle(), dev.commandPool(), vkFreeCommandBuffers};
-    SL_VK_CHECK_RESULT(vkAllocateCommandBuffers(dev.handle(), &allocateInfo, &handle_));
+    handle_ = VulkanResource<VkCommandBuffer>{device, pool, vkFreeCommandBuffers};
+    SL_VK_CHECK_RESULT(vkAllocateCommandBuffers(device, &allocateInfo, &handle_));
 }
 
 auto VulkanCmdBuffer::beginRenderPass(const VulkanRenderPass &pass, VkFramebuffer framebuffer, u32 canvasWidth,
-    u32 canvasHeight) -> VulkanCmdBuffer&
+    u32 canvasHeight, const VkClearColorValue *clearColor, VkSubpassContents contents) -> VulkanCmdBuffer&
 {
+    auto clearValues = pass.clearValues();
+    if (clearColor)
+    {
+        for (u32 i = 0; i < pass.colorAttachmentCount(); i++)
+            clearValues[i].color = *clearColor;
+    }
+
     VkRenderPassBeginInfo info{};
     info.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
     info.pNext = nullptr;
-    info.renderPass = pass;
+    info.renderPass = pass.handle(clearColor != nullptr);
     info.renderArea.offset.x = 0;
     info.renderArea.offset.y = 0;
     info.renderArea.extent.width = canvasWidth;
     info.renderArea.extent.height = canvasHeight;
-    info.clearValueCount = pass.clearValues().size();
-    info.pClearValues = pass.clearValues().data();
+    info.clearValueCount = clearValues.size();
+    info.pClearValues = clearValues.data();
     info.framebuffer = framebuffer;
 
-    vkCmdBeginRenderPass(handle_, &info, VK_SUBPASS_CONTENTS_INLINE);
+    vkCmdBeginRenderPass(handle_, &info, contents);
 
     return *this;
 }
 
+auto VulkanCmdBuffer::executeCommands(u32 count, const VkCommandBuffer *buffers) -> VulkanCmdBuffer&
+{
+    vkCmdExecuteCommands(handle_, count, buffers);
+    return *this;
+}
+
 auto VulkanCmdBuffer::endRenderPass() -> VulkanCmdBuffer&
 {
     vkCmdEndRenderPass(handle_);
@@ -93,6 +111,13 @@ auto VulkanCmdBuffer::bindDescriptorSet(VkPipelineLayout pipelineLayout, const V
     return *this;
 }
 
+auto VulkanCmdBuffer::pushConstants(VkPipelineLayout pipelineLayout, VkShaderStageFlags stages, u32 offset, u32 size,
+    const void *data) -> VulkanCmdBuffer&
+{
+    vkCmdPushConstants(handle_, pipelineLayout, stages, offset, size, data);
+    return *this;
+}
+
 auto VulkanCmdBuffer::setViewport(const Vector4 &dimentions, float minDepth, float maxDepth) -> VulkanCmdBuffer&
 {
     VkViewport vp{dimentions.x(), dimentions.y(), dimentions.z(), dimentions.w(), minDepth, maxDepth};
@@ -115,17 +140,6 @@ auto VulkanCmdBuffer::putImagePipelineBarrier(VkPipelineStageFlags srcStageMask,
     return *this;
 }
 
-auto VulkanCmdBuffer::clearColorAttachment(u32 attachment, const VkClearValue &clearValue, const VkClearRect &clearRect)
-    -> VulkanCmdBuffer&
-{
-    VkClearAttachment clear;
-    clear.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
-    clear.colorAttachment = attachment;
-    clear.clearValue = clearValue;
-    vkCmdClearAttachments(handle_, 1, &clear, 1, &clearRect); // TODO in batch
-    return *this;
-}
-
 auto VulkanCmdBuffer::copyBuffer(const VulkanBuffer &src, const VulkanBuffer &dst) -> VulkanCmdBuffer&
 {
     VkBufferCopy copyRegion{};
@@ -157,13 +171,19 @@ auto VulkanCmdBuffer::copyBuffer(const VulkanBuffer &src, const VulkanImage &dst
     return *this;
 }
 
-auto VulkanCmdBuffer::copyBuffer(const VulkanBuffer &src, const VulkanImage &dst, const VkBufferImageCopy *regions,
-    u32 regionCount) -> VulkanCmdBuffer&
+auto VulkanCmdBuffer::copyBuffer(VkBuffer src, VkBuffer dst, const VkBufferCopy &region) -> VulkanCmdBuffer&
+{
+    vkCmdCopyBuffer(handle_, src, dst, 1, &region);
+    return *this;
+}
+
+auto VulkanCmdBuffer::copyBuffer(VkBuffer src, VkImage dst, const VkBufferImageCopy *regions, u32 regionCount)
+    -> VulkanCmdBuffer&
 {
     vkCmdCopyBufferToImage(
         handle_,
-        src.handle(),
-        dst.handle(),
+        src,
+        dst,
         VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
         regionCount,
         regions);
@@ -198,6 +218,22 @@ auto VulkanCmdBuffer::begin(bool oneTime) -> VulkanCmdBuffer&
     return *this;
 }
 
+auto VulkanCmdBuffer::beginSecondary(const VulkanRenderPass &pass, VkFramebuffer framebuffer) -> VulkanCmdBuffer&
+{
+    VkCommandBufferInheritanceInfo inheritanceInfo{};
+    inheritanceInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_INFO;
+    inheritanceInfo.renderPass = pass;
+    inheritanceInfo.subpass = 0;
+    inheritanceInfo.framebuffer = framebuffer;
+
+    VkCommandBufferBeginInfo beginInfo{};
+    beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+    beginInfo.flags = VK_COMMAND_BUFFER_USAGE_RENDER_PASS_CONTINUE_BIT | VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+    beginInfo.pInheritanceInfo = &inheritanceInfo;
+    SL_VK_CHECK_RESULT(vkBeginCommandBuffer(handle_, &beginInfo));
+    return *this;
+}
+
 void VulkanCmdBuffer::end()
 {
     SL_VK_CHECK_RESULT(vkEndCommandBuffer(handle_));
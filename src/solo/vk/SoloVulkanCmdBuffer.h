@@ -24,16 +24,20 @@ namespace solo
     public:
         VulkanCmdBuffer() = default;
         VulkanCmdBuffer(const VulkanDevice &dev);
+        VulkanCmdBuffer(VkDevice device, VkCommandPool pool, VkCommandBufferLevel level);
         VulkanCmdBuffer(const VulkanCmdBuffer &other) = delete;
         VulkanCmdBuffer(VulkanCmdBuffer &&other) = default;
         ~VulkanCmdBuffer() = default;
 
         auto begin(bool oneTime) -> VulkanCmdBuffer&; // TODO avoid oneTime param
+        auto beginSecondary(const VulkanRenderPass &pass, VkFramebuffer framebuffer) -> VulkanCmdBuffer&;
         void end();
         void endAndFlush();
 
-        auto beginRenderPass(const VulkanRenderPass &pass, VkFramebuffer framebuffer, u32 canvasWidth, u32 canvasHeight)
-            -> VulkanCmdBuffer&;
+        // Color attachments are cleared to clearColor, or keep their contents when it's null
+        auto beginRenderPass(const VulkanRenderPass &pass, VkFramebuffer framebuffer, u32 canvasWidth, u32 canvasHeight,
+            const VkClearColorValue *clearColor, VkSubpassContents contents = VK_SUBPASS_CONTENTS_INLINE) -> VulkanCmdBuffer&;
+        auto executeCommands(u32 count, const VkCommandBuffer *buffers) -> VulkanCmdBuffer&;
         auto endRenderPass() -> VulkanCmdBuffer&;
 
         auto bindIndexBuffer(VkBuffer buffer, VkDeviceSize offset, VkIndexType indexType) -> VulkanCmdBuffer&;
@@ -44,6 +48,7 @@ namespace solo
 
         auto bindPipeline(VkPipeline pipeline) -> VulkanCmdBuffer&;
         auto bindDescriptorSet(VkPipelineLayout pipelineLayout, const VulkanDescriptorSet &set) -> VulkanCmdBuffer&;
+        auto pushConstants(VkPipelineLayout pipelineLayout, VkShaderStageFlags stages, u32 offset, u32 size, const void *data) -> VulkanCmdBuffer&;
 
         auto setViewport(const Vector4 &dimentions, float minDepth, float maxDepth) -> VulkanCmdBuffer&;
         auto setScissor(const Vector4 &dimentions) -> VulkanCmdBuffer&;
@@ -51,13 +56,10 @@ namespace solo
         auto putImagePipelineBarrier(VkPipelineStageFlags srcStageMask, VkPipelineStageFlags dstStageMask,
             const VkImageMemoryBarrier &barrier) -> VulkanCmdBuffer&;
 
-        auto clearColorAttachment(u32 attachment, const VkClearValue &clearValue, const VkClearRect &clearRect)
-            -> VulkanCmdBuffer&;
-
         auto copyBuffer(const VulkanBuffer &src, const VulkanBuffer &dst) -> VulkanCmdBuffer&;
         auto copyBuffer(const VulkanBuffer &src, const VulkanImage &dst) -> VulkanCmdBuffer&;
-        auto copyBuffer(const VulkanBuffer &src, const VulkanImage &dst, 
-            const VkBufferImageCopy *regions, u32 regionCount) -> VulkanCmdBuffer&;
+        auto copyBuffer(VkBuffer src, VkBuffer dst, const VkBufferCopy &region) -> VulkanCmdBuffer&;
+        auto copyBuffer(VkBuffer src, VkImage dst, const VkBufferImageCopy *regions, u32 regionCount) -> VulkanCmdBuffer&;
 
         auto blit(VkImage src, VkImage dst, VkImageLayout srcLayout, VkImageLayout dstLayout,
             const VkImageBlit &blit, VkFilter filter) -> VulkanCmdBuffer&;
@@ -68,6 +70,8 @@ namespace solo
         operator bool() const { return handle_; }
         operator const VkCommandBuffer*() { return &handle_; }
 
+        auto handle() const -> VkCommandBuffer { return handle_; }
+
     private:
         const VulkanDevice *device_ = nullptr;
         VulkanResource<VkCommandBuffer> handle_;
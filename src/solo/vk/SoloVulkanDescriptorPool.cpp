@@ -0,0 +1,84 @@
+/* 
+ * Copyright (c) Aleksey Fedotov 
+ * MIT license 
+ */
+
+#include "SoloVulkanDescriptorPool.h"
+
+#ifdef SL_VULKAN_RENDERER
+
+using namespace solo;
+
+// Average number of descriptors of each type per set, used to size new pools
+static const u32 uniformBuffersPerSet = 4;
+static const u32 samplersPerSet = 4;
+
+VulkanDescriptorPool::VulkanDescriptorPool(VkDevice device, u32 setsPerPool):
+    device_(device),
+    setsPerPool_(setsPerPool)
+{
+    pools_.push_back(createPool());
+}
+
+auto VulkanDescriptorPool::allocate(VkDescriptorSetLayout layout) -> VkDescriptorSet
+{
+    VkDescriptorSet set = VK_NULL_HANDLE;
+
+    while (currentPool_ < pools_.size())
+    {
+        if (tryAllocate(pools_[currentPool_], layout, set))
+            return set;
+        currentPool_++;
+    }
+
+    pools_.push_back(createPool());
+    const auto allocated = tryAllocate(pools_.back(), layout, set);
+    SL_DEBUG_PANIC(!allocated, "Unable to allocate descriptor set from a fresh pool");
+
+    return set;
+}
+
+void VulkanDescriptorPool::reset()
+{
+    for (const auto &pool: pools_)
+        SL_VK_CHECK_RESULT(vkResetDescriptorPool(device_, pool, 0));
+    currentPool_ = 0;
+}
+
+auto VulkanDescriptorPool::createPool() const -> VulkanResource<VkDescriptorPool>
+{
+    const vec<VkDescriptorPoolSize> sizes =
+    {
+        {VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, setsPerPool_ * uniformBuffersPerSet},
+        {VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, setsPerPool_ * samplersPerSet}
+    };
+
+    VkDescriptorPoolCreateInfo poolInfo{};
+    poolInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+    poolInfo.poolSizeCount = sizes.size();
+    poolInfo.pPoolSizes = sizes.data();
+    poolInfo.maxSets = setsPerPool_;
+
+    auto pool = VulkanResource<VkDescriptorPool>{device_, vkDestroyDescriptorPool};
+    SL_VK_CHECK_RESULT(vkCreateDescriptorPool(device_, &poolInfo, nullptr, pool.cleanRef()));
+
+    return pool;
+}
+
+auto VulkanDescriptorPool::tryAllocate(VkDescriptorPool pool, VkDescriptorSetLayout layout, VkDescriptorSet &set) const -> bool
+{
+    VkDescriptorSetAllocateInfo allocInfo{};
+    allocInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+    allocInfo.descriptorPool = pool;
+    allocInfo.descriptorSetCount = 1;
+    allocInfo.pSetLayouts = &layout;
+
+    const auto result = vkAllocateDescriptorSets(device_, &allocInfo, &set);
+    if (result == VK_ERROR_OUT_OF_POOL_MEMORY_KHR || result == VK_ERROR_FRAGMENTED_POOL)
+        return false;
+
+    SL_VK_CHECK_RESULT(result);
+    return true;
+}
+
+#endif
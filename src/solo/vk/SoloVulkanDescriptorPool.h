@@ -0,0 +1,46 @@
+/* 
+ * Copyright (c) Aleksey Fedotov 
+ * MIT license 
+ */
+
+#pragma once
+
+#include "SoloCommon.h"
+
+#ifdef SL_VULKAN_RENDERER
+
+#include "SoloVulkan.h"
+
+namespace solo
+{
+    // Hands out descriptor sets from a list of shared pools, adding a new pool when the current ones run out.
+    // Sets are never freed one by one - reset() recycles all of them at once.
+    class VulkanDescriptorPool
+    {
+    public:
+        VulkanDescriptorPool() = default;
+        VulkanDescriptorPool(VkDevice device, u32 setsPerPool);
+        VulkanDescriptorPool(VulkanDescriptorPool &&other) = default;
+        VulkanDescriptorPool(const VulkanDescriptorPool &other) = delete;
+        ~VulkanDescriptorPool() = default;
+
+        auto operator=(const VulkanDescriptorPool &other) -> VulkanDescriptorPool& = delete;
+        auto operator=(VulkanDescriptorPool &&other) -> VulkanDescriptorPool& = default;
+
+        auto allocate(VkDescriptorSetLayout layout) -> VkDescriptorSet;
+        void reset();
+
+        auto poolCount() const -> u32 { return static_cast<u32>(pools_.size()); }
+
+    private:
+        VkDevice device_ = VK_NULL_HANDLE;
+        vec<VulkanResource<VkDescriptorPool>> pools_;
+        u32 currentPool_ = 0;
+        u32 setsPerPool_ = 0;
+
+        auto createPool() const -> VulkanResource<VkDescriptorPool>;
+        auto tryAllocate(VkDescriptorPool pool, VkDescriptorSetLayout layout, VkDescriptorSet &set) const -> bool;
+    };
+}
+
+#endif
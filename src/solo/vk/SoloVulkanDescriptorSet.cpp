@@ -4,6 +4,8 @@
  */
 
 #include "SoloVulkanDescriptorSet.h"
+#include "SoloVulkanDescriptorPool.h"
+#include <algorithm>
 
 #ifdef SL_VULKAN_RENDERER
 
@@ -18,9 +20,6 @@ void VulkanDescriptorSetConfig::addUniformBuffer(u32 binding)
     b.stageFlags = VK_SHADER_STAGE_ALL_GRAPHICS; // TODO make configurable
     b.pImmutableSamplers = nullptr;
     bindings_.push_back(b);
-    // TODO More elegant
-    sizes_[VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER].type = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
-    sizes_[VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER].descriptorCount++;
 }
 
 void VulkanDescriptorSetConfig::addSampler(u32 binding)
@@ -32,15 +31,11 @@ void VulkanDescriptorSetConfig::addSampler(u32 binding)
     b.stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT; // TODO make configurable
     b.pImmutableSamplers = nullptr;
     bindings_.push_back(b);
-    // TODO More elegant
-    sizes_[VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER].type = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
-    sizes_[VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER].descriptorCount++;
 }
 
 VulkanDescriptorSet::VulkanDescriptorSet(VkDevice device, const VulkanDescriptorSetConfig &cfg):
     device_(device)
 {
-    // Layout
     VkDescriptorSetLayoutCreateInfo layoutInfo {};
     layoutInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
     layoutInfo.bindingCount = cfg.bindings_.size();
@@ -48,71 +43,82 @@ VulkanDescriptorSet::VulkanDescriptorSet(VkDevice device, const VulkanDescriptor
 
     layout_ = VulkanResource<VkDescriptorSetLayout>{device, vkDestroyDescriptorSetLayout};
     SL_VK_CHECK_RESULT(vkCreateDescriptorSetLayout(device, &layoutInfo, nullptr, layout_.cleanRef()));
+}
+
+void VulkanDescriptorSet::allocate(VulkanDescriptorPool &pool)
+{
+    set_ = pool.allocate(layout_);
+    for (auto &b: bindings_)
+        b.written = false;
+    pendingWrites_.clear();
+}
+
+void VulkanDescriptorSet::updateUniformBuffer(u32 binding, VkBuffer buffer, VkDeviceSize offset, VkDeviceSize range)
+{
+    auto &b = this->binding(binding);
+    if (b.written && b.buffer.buffer == buffer && b.buffer.offset == offset && b.buffer.range == range)
+        return;
+
+    b.buffer = {buffer, offset, range};
+    stageWrite(binding, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER);
+}
+
+void VulkanDescriptorSet::updateSampler(u32 binding, VkImageView view, VkSampler sampler, VkImageLayout layout)
+{
+    auto &b = this->binding(binding);
+    if (b.written && b.image.imageView == view && b.image.sampler == sampler && b.image.imageLayout == layout)
+        return;
+
+    b.image = {sampler, view, layout};
+    stageWrite(binding, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER);
+}
+
+void VulkanDescriptorSet::commitUpdates()
+{
+    if (pendingWrites_.empty())
+        return;
+
+    vec<VkWriteDescriptorSet> writes;
+    writes.reserve(pendingWrites_.size());
 
-    vec<VkDescriptorPoolSize> sizes;
-    for (const auto &s: cfg.sizes_)
+    for (const auto &pending: pendingWrites_)
     {
-        if (s.second.descriptorCount > 0)
-            sizes.push_back(s.second);
+        const auto &b = bindings_[pending.binding];
+        const auto isBuffer = pending.type == VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+
+        VkWriteDescriptorSet write{};
+        write.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+        write.dstSet = set_;
+        write.dstBinding = pending.binding;
+        write.dstArrayElement = 0;
+        write.descriptorType = pending.type;
+        write.descriptorCount = 1;
+        write.pBufferInfo = isBuffer ? &b.buffer : nullptr;
+        write.pImageInfo = isBuffer ? nullptr : &b.image;
+        write.pTexelBufferView = nullptr;
+        writes.push_back(write);
     }
 
-    // Pool
-    // TODO support shared pools
-    VkDescriptorPoolCreateInfo poolInfo{};
-    poolInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
-    poolInfo.poolSizeCount = sizes.size();
-    poolInfo.pPoolSizes = sizes.data();
-    poolInfo.maxSets = 1;
-
-    pool_ = VulkanResource<VkDescriptorPool>{device, vkDestroyDescriptorPool};
-    SL_VK_CHECK_RESULT(vkCreateDescriptorPool(device, &poolInfo, nullptr, pool_.cleanRef()));
-
-    // Set
-    VkDescriptorSetAllocateInfo allocInfo{};
-    allocInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
-    allocInfo.descriptorPool = pool_;
-    allocInfo.descriptorSetCount = 1;
-    allocInfo.pSetLayouts = &layout_;
-
-    SL_VK_CHECK_RESULT(vkAllocateDescriptorSets(device, &allocInfo, &set_));
+    vkUpdateDescriptorSets(device_, writes.size(), writes.data(), 0, nullptr);
+    pendingWrites_.clear();
 }
 
-// TODO do updates in batch using single vkUpdateDescriptorSets call
-void VulkanDescriptorSet::updateUniformBuffer(u32 binding, VkBuffer buffer, VkDeviceSize offset, VkDeviceSize range)
+auto VulkanDescriptorSet::binding(u32 index) -> Binding&
 {
-    VkDescriptorBufferInfo bufferInfo = {buffer, offset, range};
-
-    VkWriteDescriptorSet write{};
-    write.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
-    write.dstSet = set_;
-    write.dstBinding = binding;
-    write.dstArrayElement = 0;
-    write.descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
-    write.descriptorCount = 1;
-    write.pBufferInfo = &bufferInfo;
-    write.pImageInfo = nullptr;
-    write.pTexelBufferView = nullptr;
-
-    vkUpdateDescriptorSets(device_, 1, &write, 0, nullptr);
+    if (index >= bindings_.size())
+        bindings_.resize(index + 1);
+    return bindings_[index];
 }
 
-// TODO do updates in batch using single vkUpdateDescriptorSets call
-void VulkanDescriptorSet::updateSampler(u32 binding, VkImageView view, VkSampler sampler, VkImageLayout layout)
+void VulkanDescriptorSet::stageWrite(u32 binding, VkDescriptorType type)
 {
-    VkDescriptorImageInfo imageInfo = {sampler, view, layout};
-
-    VkWriteDescriptorSet write{};
-    write.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
-    write.dstSet = set_;
-    write.dstBinding = binding;
-    write.dstArrayElement = 0;
-    write.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
-    write.descriptorCount = 1;
-    write.pBufferInfo = nullptr;
-    write.pImageInfo = &imageInfo;
-    write.pTexelBufferView = nullptr;
-
-    vkUpdateDescriptorSets(device_, 1, &write, 0, nullptr);
+    bindings_[binding].written = true;
+
+    // Bindings staged twice before a commit simply pick up the latest info
+    const auto staged = std::find_if(pendingWrites_.begin(), pendingWrites_.end(),
+        [binding](const PendingWrite &w) { return w.binding == binding; });
+    if (staged == pendingWrites_.end())
+        pendingWrites_.push_back({binding, type});
 }
 
 #endif
\ No newline at end of file
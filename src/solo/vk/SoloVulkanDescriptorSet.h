@@ -14,6 +14,7 @@
 namespace solo
 {
     class VulkanMaterial;
+    class VulkanDescriptorPool;
 
     class VulkanDescriptorSetConfig
     {
@@ -25,7 +26,6 @@ namespace solo
         friend class VulkanDescriptorSet;
 
         vec<VkDescriptorSetLayoutBinding> bindings_;
-        umap<VkDescriptorType, VkDescriptorPoolSize> sizes_;
     };
 
     class VulkanDescriptorSet
@@ -39,8 +39,13 @@ namespace solo
 
         auto layout() const -> VkDescriptorSetLayout { return layout_; }
 
+        // Takes a set from the pool. Bound resources are forgotten, so everything gets rewritten on next commit.
+        void allocate(VulkanDescriptorPool &pool);
+
+        // Updates are only staged if the binding actually changes and are applied in one go by commitUpdates()
         void updateUniformBuffer(u32 binding, VkBuffer buffer, VkDeviceSize offset, VkDeviceSize range);
         void updateSampler(u32 binding, VkImageView view, VkSampler sampler, VkImageLayout layout);
+        void commitUpdates();
 
         auto operator=(const VulkanDescriptorSet &other) -> VulkanDescriptorSet& = delete;
         auto operator=(VulkanDescriptorSet &&other) -> VulkanDescriptorSet& = default;
@@ -49,10 +54,27 @@ namespace solo
         operator const VkDescriptorSet*() const { return &set_; }
 
     private:
+        struct Binding
+        {
+            VkDescriptorBufferInfo buffer;
+            VkDescriptorImageInfo image;
+            bool written = false;
+        };
+
+        struct PendingWrite
+        {
+            u32 binding;
+            VkDescriptorType type;
+        };
+
         VkDevice device_ = VK_NULL_HANDLE;
-        VulkanResource<VkDescriptorPool> pool_;
         VulkanResource<VkDescriptorSetLayout> layout_;
         VkDescriptorSet set_ = VK_NULL_HANDLE;
+        vec<Binding> bindings_;
+        vec<PendingWrite> pendingWrites_;
+
+        auto binding(u32 index) -> Binding&;
+        void stageWrite(u32 binding, VkDescriptorType type);
     };
 }
 
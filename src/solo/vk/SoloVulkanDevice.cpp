@@ -7,6 +7,8 @@
 
 #ifdef SL_VULKAN_RENDERER
 
+#include "SoloVulkanUploader.h"
+
 using namespace solo;
 
 static VKAPI_ATTR VkBool32 VKAPI_CALL debugCallbackFunc(VkDebugReportFlagsEXT flags, VkDebugReportObjectTypeEXT objType,
@@ -72,14 +74,49 @@ static auto selectQueueIndex(VkPhysicalDevice device, VkSurfaceKHR surface) -> u
     return 0;
 }
 
-static auto createDevice(VkPhysicalDevice physicalDevice, u32 queueIndex) -> VulkanResource<VkDevice>
+static auto selectTransferQueueIndex(VkPhysicalDevice device, u32 graphicsQueueIndex) -> u32
+{
+    u32 count;
+    vkGetPhysicalDeviceQueueFamilyProperties(device, &count, nullptr);
+
+    vec<VkQueueFamilyProperties> queueProps(count);
+    vkGetPhysicalDeviceQueueFamilyProperties(device, &count, queueProps.data());
+
+    // Prefer a pure transfer (DMA) queue, then any non-graphics one. Graphics and compute queues support
+    // transfers too, so falling back to the graphics queue is always valid.
+    const auto findFamily = [&](VkQueueFlags excluded)
+    {
+        for (u32 i = 0; i < count; i++)
+        {
+            const auto flags = queueProps[i].queueFlags;
+            if ((flags & VK_QUEUE_TRANSFER_BIT) && !(flags & excluded))
+                return i;
+        }
+        return graphicsQueueIndex;
+    };
+
+    auto index = findFamily(VK_QUEUE_GRAPHICS_BIT | VK_QUEUE_COMPUTE_BIT);
+    if (index == graphicsQueueIndex)
+        index = findFamily(VK_QUEUE_GRAPHICS_BIT);
+
+    return index;
+}
+
+static auto createDevice(VkPhysicalDevice physicalDevice, u32 queueIndex, u32 transferQueueIndex) -> VulkanResource<VkDevice>
 {
     vec<float> queuePriorities = {0.0f};
-    VkDeviceQueueCreateInfo queueCreateInfo{};
-    queueCreateInfo.sType = VK_STRUCTURE_TYPE_DEVICE_QUEUE_CREATE_INFO;
-    queueCreateInfo.queueFamilyIndex = queueIndex;
-    queueCreateInfo.queueCount = 1;
-    queueCreateInfo.pQueuePriorities = queuePriorities.data();
+    vec<VkDeviceQueueCreateInfo> queueCreateInfos;
+    for (auto index: {queueIndex, transferQueueIndex})
+    {
+        if (!queueCreateInfos.empty() && queueCreateInfos[0].queueFamilyIndex == index)
+            continue;
+        VkDeviceQueueCreateInfo queueCreateInfo{};
+        queueCreateInfo.sType = VK_STRUCTURE_TYPE_DEVICE_QUEUE_CREATE_INFO;
+        queueCreateInfo.queueFamilyIndex = index;
+        queueCreateInfo.queueCount = 1;
+        queueCreateInfo.pQueuePriorities = queuePriorities.data();
+        queueCreateInfos.push_back(queueCreateInfo);
+    }
 
     vec<const s8*> deviceExtensions = {VK_KHR_SWAPCHAIN_EXTENSION_NAME};
 
@@ -88,8 +125,8 @@ static auto createDevice(VkPhysicalDevice physicalDevice, u32 queueIndex) -> Vul
 
     VkDeviceCreateInfo deviceCreateInfo{};
     deviceCreateInfo.sType = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO;
-    deviceCreateInfo.queueCreateInfoCount = 1;
-    deviceCreateInfo.pQueueCreateInfos = &queueCreateInfo;
+    deviceCreateInfo.queueCreateInfoCount = static_cast<u32>(queueCreateInfos.size());
+    deviceCreateInfo.pQueueCreateInfos = queueCreateInfos.data();
     deviceCreateInfo.pEnabledFeatures = &enabledFeatures;
     deviceCreateInfo.enabledExtensionCount = static_cast<u32>(deviceExtensions.size());
     deviceCreateInfo.ppEnabledExtensionNames = deviceExtensions.data();
@@ -100,18 +137,11 @@ static auto createDevice(VkPhysicalDevice physicalDevice, u32 queueIndex) -> Vul
     return result;
 }
 
-static auto createCommandPool(VkDevice device, u32 queueIndex) -> VulkanResource<VkCommandPool>
-{
-    VkCommandPoolCreateInfo poolInfo{};
-    poolInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
-    poolInfo.queueFamilyIndex = queueIndex;
-    poolInfo.flags = VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT;
+VulkanDevice::VulkanDevice() = default;
+VulkanDevice::VulkanDevice(VulkanDevice &&other) noexcept = default;
+VulkanDevice::~VulkanDevice() = default;
 
-    VulkanResource<VkCommandPool> commandPool{device, vkDestroyCommandPool};
-    SL_VK_CHECK_RESULT(vkCreateCommandPool(device, &poolInfo, nullptr, commandPool.cleanRef()));
-
-    return commandPool;
-}
+auto VulkanDevice::operator=(VulkanDevice &&other) noexcept -> VulkanDevice& = default;
 
 VulkanDevice::VulkanDevice(VkInstance instance, VkSurfaceKHR surface):
     surface_(surface)
@@ -130,17 +160,24 @@ VulkanDevice::VulkanDevice(VkInstance instance, VkSurfaceKHR surface):
     detectFormatSupport(VK_FORMAT_D24_UNORM_S8_UINT);
     detectFormatSupport(VK_FORMAT_D16_UNORM_S8_UINT);
     detectFormatSupport(VK_FORMAT_D16_UNORM);
+    detectFormatSupport(VK_FORMAT_A2B10G10R10_SNORM_PACK32);
 
     auto surfaceFormats = ::selectSurfaceFormat(physical_, surface);
     colorFormat_ = std::get<0>(surfaceFormats);
     colorSpace_ = std::get<1>(surfaceFormats);
     depthFormat_ = selectDepthFormat();
 
-    const auto queueIndex = selectQueueIndex(physical_, surface);
-    handle_ = createDevice(physical_, queueIndex);
-    vkGetDeviceQueue(handle_, queueIndex, 0, &queue_);
+    queueIndex_ = selectQueueIndex(physical_, surface);
+    transferQueueIndex_ = selectTransferQueueIndex(physical_, queueIndex_);
+    handle_ = createDevice(physical_, queueIndex_, transferQueueIndex_);
+    vkGetDeviceQueue(handle_, queueIndex_, 0, &queue_);
+    vkGetDeviceQueue(handle_, transferQueueIndex_, 0, &transferQueue_);
+
+    commandPool_ = vk::createCommandPool(handle_, queueIndex_);
 
-    commandPool_ = createCommandPool(handle_, queueIndex);
+    uploader_ = std::make_unique<VulkanUploader>(handle_, physicalMemoryFeatures_,
+        physicalProperties_.limits.optimalBufferCopyOffsetAlignment,
+        queue_, queueIndex_, transferQueue_, transferQueueIndex_);
 }
 
 bool VulkanDevice::isFormatSupported(VkFormat format, VkFormatFeatureFlags features) const
@@ -148,6 +185,11 @@ bool VulkanDevice::isFormatSupported(VkFormat format, VkFormatFeatureFlags featu
     return supportedFormats_.count(format) && (supportedFormats_.at(format) & features) == features;
 }
 
+bool VulkanDevice::isBufferFormatSupported(VkFormat format, VkFormatFeatureFlags features) const
+{
+    return supportedBufferFormats_.count(format) && (supportedBufferFormats_.at(format) & features) == features;
+}
+
 void VulkanDevice::detectFormatSupport(VkFormat format)
 {
     // TODO Check for linear tiling as well
@@ -155,6 +197,8 @@ void VulkanDevice::detectFormatSupport(VkFormat format)
     vkGetPhysicalDeviceFormatProperties(physical_, format, &formatProps);
     if (formatProps.optimalTilingFeatures)
         supportedFormats_[format] = formatProps.optimalTilingFeatures;
+    if (formatProps.bufferFeatures)
+        supportedBufferFormats_[format] = formatProps.bufferFeatures;
 }
 
 auto VulkanDevice::selectDepthFormat() -> VkFormat
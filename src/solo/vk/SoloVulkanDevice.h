@@ -13,20 +13,23 @@
 
 namespace solo
 {
+    class VulkanUploader;
+
     class VulkanDevice
     {
     public:
-        VulkanDevice() = default;
+        VulkanDevice();
         VulkanDevice(VkInstance instance, VkSurfaceKHR surface);
-        VulkanDevice(VulkanDevice &&other) = default;
+        VulkanDevice(VulkanDevice &&other) noexcept;
         VulkanDevice(const VulkanDevice &other) = delete;
-        ~VulkanDevice() = default;
+        ~VulkanDevice();
 
         bool isFormatSupported(VkFormat format, VkFormatFeatureFlags features) const;
+        bool isBufferFormatSupported(VkFormat format, VkFormatFeatureFlags features) const;
         auto gpuName() const -> const char *{ return physicalProperties_.deviceName; }
 
         auto operator=(const VulkanDevice &other) -> VulkanDevice& = delete;
-        auto operator=(VulkanDevice &&other) -> VulkanDevice& = default;
+        auto operator=(VulkanDevice &&other) noexcept -> VulkanDevice&;
 
         operator VkDevice() const { return handle_; }
 
@@ -41,6 +44,10 @@ namespace solo
         auto colorSpace() const -> VkColorSpaceKHR { return colorSpace_; }
         auto commandPool() const -> VkCommandPool { return commandPool_; }
         auto queue() const -> VkQueue { return queue_; }
+        auto queueIndex() const -> u32 { return queueIndex_; }
+        auto transferQueue() const -> VkQueue { return transferQueue_; }
+        auto transferQueueIndex() const -> u32 { return transferQueueIndex_; }
+        auto uploader() const -> VulkanUploader& { return *uploader_; }
 
     private:
         VulkanResource<VkDevice> handle_;
@@ -54,8 +61,13 @@ namespace solo
         VkFormat depthFormat_ = VK_FORMAT_UNDEFINED;
         VkColorSpaceKHR colorSpace_ = VK_COLOR_SPACE_MAX_ENUM_KHR;
         VkQueue queue_ = nullptr;
+        u32 queueIndex_ = 0;
+        VkQueue transferQueue_ = nullptr;
+        u32 transferQueueIndex_ = 0;
         VulkanResource<VkDebugReportCallbackEXT> debugCallback_;
         umap<VkFormat, VkFormatFeatureFlags> supportedFormats_;
+        umap<VkFormat, VkFormatFeatureFlags> supportedBufferFormats_;
+        uptr<VulkanUploader> uploader_;
 
         void selectPhysicalDevice(VkInstance instance);
         void detectFormatSupport(VkFormat format);
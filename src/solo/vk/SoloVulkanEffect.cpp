@@ -10,10 +10,14 @@
 #include "SoloDevice.h"
 #include "SoloVulkan.h"
 #include "SoloVulkanRenderer.h"
+#include "SoloFileSystem.h"
+#include "SoloHash.h"
+#include "SoloStringUtils.h"
 #include <spirv_cross/spirv.hpp>
 #include <spirv_cross/spirv_cross.hpp>
 #include <spirv_cross/spirv_glsl.hpp>
 #include <shaderc/shaderc.hpp>
+#include <cstring>
 
 using namespace solo;
 
@@ -32,16 +36,258 @@ static auto createShaderModule(VkDevice device, const void *data, u32 size) -> V
     return module;
 }
 
+// Anything that changes the produced SPIR-V or reflection must be reflected here to invalidate old cache entries
+static const u32 shaderCacheVersion = 1;
+
+// Everything shaders are compiled with, hashed into cache keys as it is
+struct ShaderCompileSettings
+{
+    u32 sourceLanguage;
+    u32 targetEnv;
+    u32 optimizationLevel;
+};
+
+static const ShaderCompileSettings shaderCompileSettings{
+    shaderc_source_language_glsl,
+    shaderc_target_env_vulkan,
+    shaderc_optimization_level_zero
+};
+
+static auto compileOptions() -> shaderc::CompileOptions
+{
+    shaderc::CompileOptions options;
+    options.SetSourceLanguage(static_cast<shaderc_source_language>(shaderCompileSettings.sourceLanguage));
+    options.SetTargetEnvironment(static_cast<shaderc_target_env>(shaderCompileSettings.targetEnv), 0);
+    options.SetOptimizationLevel(static_cast<shaderc_optimization_level>(shaderCompileSettings.optimizationLevel));
+    return options;
+}
+
+// Shaderc exposes no version of its own, so a fixed shader is compiled once and its SPIR-V hashed instead.
+// That covers the generator version in the SPIR-V header as well as code generation changes
+static auto compilerFingerprint() -> u64
+{
+    static const auto fingerprint = []
+    {
+        const str probe = "#version 450\nlayout (location = 0) in vec4 p;\nvoid main() { gl_Position = p * 2.0; }\n";
+        shaderc::Compiler compiler{};
+        const auto result = compiler.CompileGlslToSpv(probe.c_str(), probe.size(), shaderc_glsl_vertex_shader, "<probe>", compileOptions());
+        const vec<u32> spirv(result.begin(), result.end());
+        return hashBytes(spirv.data(), spirv.size() * sizeof(u32));
+    }();
+    return fingerprint;
+}
+
+static auto shaderCacheKey(const void *src, u32 srcLen, bool vertex) -> u64
+{
+    auto hash = hashBytes(src, srcLen);
+    const u8 stage = vertex ? 0 : 1;
+    hash = hashBytes(&stage, sizeof(stage), hash);
+    hash = hashBytes(&shaderCompileSettings, sizeof(shaderCompileSettings), hash);
+    const auto compiler = compilerFingerprint();
+    hash = hashBytes(&compiler, sizeof(compiler), hash);
+    return hashBytes(&shaderCacheVersion, sizeof(shaderCacheVersion), hash);
+}
+
+static auto shaderCachePath(const str &directory, u64 key, bool vertex) -> str
+{
+    return directory + "/" + stringutils::toHex(key) + (vertex ? ".vert.spvc" : ".frag.spvc");
+}
+
+class ShaderCacheWriter
+{
+public:
+    auto data() const -> const vec<u8>& { return data_; }
+
+    void write(u32 value)
+    {
+        const auto bytes = reinterpret_cast<const u8*>(&value);
+        data_.insert(data_.end(), bytes, bytes + sizeof(value));
+    }
+
+    void write(u64 value)
+    {
+        write(static_cast<u32>(value));
+        write(static_cast<u32>(value >> 32));
+    }
+
+    void write(const str &value)
+    {
+        write(static_cast<u32>(value.size()));
+        data_.insert(data_.end(), value.begin(), value.end());
+    }
+
+    void write(const VulkanEffect::UniformBuffer &buffer)
+    {
+        write(buffer.binding);
+        write(buffer.size);
+        write(static_cast<u32>(buffer.members.size()));
+        for (const auto &p: buffer.members)
+        {
+            write(p.first);
+            write(p.second.offset);
+            write(p.second.size);
+        }
+    }
+
+private:
+    vec<u8> data_;
+};
+
+class ShaderCacheReader
+{
+public:
+    explicit ShaderCacheReader(const vec<u8> &data): data_(data) {}
+
+    // Once a read fails all subsequent reads fail too, so the result only needs to be checked at the end
+    bool ok() const { return ok_; }
+
+    auto readU32() -> u32
+    {
+        u32 value = 0;
+        if (!canRead(sizeof(value)))
+            return 0;
+        memcpy(&value, data_.data() + pos_, sizeof(value));
+        pos_ += sizeof(value);
+        return value;
+    }
+
+    auto readU64() -> u64
+    {
+        const u64 low = readU32();
+        const u64 high = readU32();
+        return low | (high << 32);
+    }
+
+    auto readStr() -> str
+    {
+        const auto size = readU32();
+        if (!canRead(size))
+            return "";
+        str value(reinterpret_cast<const s8*>(data_.data() + pos_), size);
+        pos_ += size;
+        return value;
+    }
+
+    auto readUniformBuffer() -> VulkanEffect::UniformBuffer
+    {
+        VulkanEffect::UniformBuffer buffer;
+        buffer.binding = readU32();
+        buffer.size = readU32();
+        const auto memberCount = readU32();
+        for (u32 i = 0; i < memberCount && ok_; i++)
+        {
+            const auto name = readStr();
+            auto &member = buffer.members[name];
+            member.offset = readU32();
+            member.size = readU32();
+        }
+        return buffer;
+    }
+
+    void readWords(vec<u32> &words, u32 count)
+    {
+        if (!canRead(count * sizeof(u32)))
+            return;
+        words.resize(count);
+        memcpy(words.data(), data_.data() + pos_, count * sizeof(u32));
+        pos_ += count * sizeof(u32);
+    }
+
+private:
+    const vec<u8> &data_;
+    size_t pos_ = 0;
+    bool ok_ = true;
+
+    bool canRead(size_t size)
+    {
+        ok_ = ok_ && pos_ + size <= data_.size();
+        return ok_;
+    }
+};
+
+static auto serializeShader(u64 key, const VulkanEffect::CompiledStage &shader) -> vec<u8>
+{
+    ShaderCacheWriter writer;
+    writer.write(shaderCacheVersion);
+    writer.write(key);
+
+    writer.write(static_cast<u32>(shader.spirv.size()));
+    for (auto word: shader.spirv)
+        writer.write(word);
+
+    const auto &refl = shader.reflection;
+    writer.write(static_cast<u32>(refl.uniformBuffers.size()));
+    for (const auto &p: refl.uniformBuffers)
+    {
+        writer.write(p.first);
+        writer.write(p.second);
+    }
+
+    writer.write(refl.pushConstantBufferName);
+    writer.write(refl.pushConstantBuffer);
+
+    writer.write(static_cast<u32>(refl.samplers.size()));
+    for (const auto &p: refl.samplers)
+    {
+        writer.write(p.first);
+        writer.write(p.second.binding);
+    }
+
+    writer.write(static_cast<u32>(refl.vertexAttributes.size()));
+    for (const auto &p: refl.vertexAttributes)
+    {
+        writer.write(p.first);
+        writer.write(p.second.location);
+    }
+
+    return writer.data();
+}
+
+static bool deserializeShader(const vec<u8> &data, u64 key, VulkanEffect::CompiledStage &shader)
+{
+    ShaderCacheReader reader{data};
+    if (reader.readU32() != shaderCacheVersion || reader.readU64() != key)
+        return false;
+
+    reader.readWords(shader.spirv, reader.readU32());
+
+    auto &refl = shader.reflection;
+    const auto bufferCount = reader.readU32();
+    for (u32 i = 0; i < bufferCount && reader.ok(); i++)
+    {
+        const auto name = reader.readStr();
+        refl.uniformBuffers[name] = reader.readUniformBuffer();
+    }
+
+    refl.pushConstantBufferName = reader.readStr();
+    refl.pushConstantBuffer = reader.readUniformBuffer();
+
+    const auto samplerCount = reader.readU32();
+    for (u32 i = 0; i < samplerCount && reader.ok(); i++)
+    {
+        const auto name = reader.readStr();
+        refl.samplers[name].binding = reader.readU32();
+    }
+
+    const auto attributeCount = reader.readU32();
+    for (u32 i = 0; i < attributeCount && reader.ok(); i++)
+    {
+        const auto name = reader.readStr();
+        refl.vertexAttributes[name].location = reader.readU32();
+    }
+
+    return reader.ok() && !shader.spirv.empty();
+}
+
 static auto compileToSpv(const void *src, u32 srcLen, const str &fileName, bool vertex) -> shaderc::SpvCompilationResult
 {
     shaderc::Compiler compiler{};
-    const shaderc::CompileOptions options{};
     auto result = compiler.CompileGlslToSpv(
         static_cast<const s8*>(src),
         srcLen,
         vertex ? shaderc_glsl_vertex_shader : shaderc_glsl_fragment_shader,
         fileName.c_str(),
-        options
+        compileOptions()
     );
 
     const auto compilationStatus = result.GetCompilationStatus();
@@ -51,27 +297,78 @@ static auto compileToSpv(const void *src, u32 srcLen, const str &fileName, bool
     return result;
 }
 
+static auto compileShader(Device *device, const void *src, u32 srcLen, bool vertex) -> VulkanEffect::CompiledStage
+{
+    const auto &cacheDir = device->shaderCacheDirectory();
+    const auto fs = device->fileSystem();
+    // The key hashes the source and compiles a probe shader once, so skip it when nothing is cached
+    const auto key = cacheDir.empty() ? 0 : shaderCacheKey(src, srcLen, vertex);
+    const auto cachePath = cacheDir.empty() ? str() : shaderCachePath(cacheDir, key, vertex);
+
+    VulkanEffect::CompiledStage shader;
+    if (!cachePath.empty() && fs->exists(cachePath))
+    {
+        if (deserializeShader(fs->readBytes(cachePath), key, shader))
+            return shader;
+        shader = VulkanEffect::CompiledStage(); // corrupted or stale, recompile and overwrite
+    }
+
+    const auto result = compileToSpv(src, srcLen, "<memory>", vertex);
+    shader.spirv.assign(result.begin(), result.end());
+    shader.reflection = VulkanEffect::reflect(shader.spirv.data(), static_cast<u32>(shader.spirv.size()), vertex);
+
+    // Effects compile on job workers, which may all be writing the same stage
+    if (!cachePath.empty())
+        fs->replaceBytes(cachePath, serializeShader(key, shader));
+
+    return shader;
+}
+
 auto VulkanEffect::fromSources(Device *device, const void *vsSrc, u32 vsSrcLen, const void *fsSrc, u32 fsSrcLen)
     -> sptr<VulkanEffect>
 {
-    const auto vsCompilationResult = compileToSpv(vsSrc, vsSrcLen, "<memory>", true);
-    const auto fsCompilationResult = compileToSpv(fsSrc, fsSrcLen, "<memory>", false);
-    const auto vsSize = (vsCompilationResult.end() - vsCompilationResult.begin()) * sizeof(u32);
-    const auto fsSize = (fsCompilationResult.end() - fsCompilationResult.begin()) * sizeof(u32);
+    return fromCompiledSources(device, *compileSources(device, vsSrc, vsSrcLen, fsSrc, fsSrcLen));
+}
+
+auto VulkanEffect::fromCompiledSources(Device *device, const CompiledSources &sources) -> sptr<VulkanEffect>
+{
+    const auto &vs = sources.vertex;
+    const auto &fs = sources.fragment;
     return std::make_shared<VulkanEffect>(
         device,
-        vsCompilationResult.begin(), static_cast<u32>(vsSize),
-        fsCompilationResult.begin(), static_cast<u32>(fsSize)
+        vs.spirv.data(), static_cast<u32>(vs.spirv.size() * sizeof(u32)), vs.reflection,
+        fs.spirv.data(), static_cast<u32>(fs.spirv.size() * sizeof(u32)), fs.reflection
     );
 }
 
-VulkanEffect::VulkanEffect(Device *device, const void *vsSrc, u32 vsSrcLen, const void *fsSrc, u32 fsSrcLen)
+auto VulkanEffect::compileSources(Device *device, const void *vsSrc, u32 vsSrcLen, const void *fsSrc, u32 fsSrcLen)
+    -> sptr<CompiledSources>
+{
+    auto result = std::make_shared<CompiledSources>();
+    result->vertex = compileShader(device, vsSrc, vsSrcLen, true);
+    result->fragment = compileShader(device, fsSrc, fsSrcLen, false);
+    return result;
+}
+
+VulkanEffect::VulkanEffect(Device *device, const void *vsSrc, u32 vsSrcLen, const void *fsSrc, u32 fsSrcLen):
+    VulkanEffect(device,
+        vsSrc, vsSrcLen, reflect(static_cast<const u32*>(vsSrc), vsSrcLen / sizeof(u32), true),
+        fsSrc, fsSrcLen, reflect(static_cast<const u32*>(fsSrc), fsSrcLen / sizeof(u32), false))
+{
+}
+
+VulkanEffect::VulkanEffect(Device *device, const void *vsSrc, u32 vsSrcLen, const StageReflection &vsReflection,
+    const void *fsSrc, u32 fsSrcLen, const StageReflection &fsReflection)
 {
     renderer_ = dynamic_cast<VulkanRenderer*>(device->renderer());
     vs_ = createShaderModule(renderer_->device(), vsSrc, vsSrcLen);
     fs_ = createShaderModule(renderer_->device(), fsSrc, fsSrcLen);
-    introspectShader(static_cast<const u32*>(vsSrc), vsSrcLen / sizeof(u32), true);
-    introspectShader(static_cast<const u32*>(fsSrc), fsSrcLen / sizeof(u32), false);
+    applyReflection(vsReflection, true);
+    applyReflection(fsReflection, false);
+    instanced_ = vertexAttributes_.count(instanceWorldAttributeName) > 0;
+
+    SL_DEBUG_PANIC(pushConstantBuffer_.size > renderer_->device().physicalProperties().limits.maxPushConstantsSize,
+        "Push constant buffer ", pushConstantBufferName_, " exceeds device push constants size limit");
 }
 
 auto VulkanEffect::uniformBuffer(const str &name) -> UniformBuffer
@@ -86,15 +383,17 @@ auto VulkanEffect::sampler(const str &name) -> Sampler
     return samplers_.at(name);
 }
 
-void VulkanEffect::introspectShader(const u32 *src, u32 len, bool vertex)
+auto VulkanEffect::reflect(const u32 *src, u32 len, bool vertex) -> StageReflection
 {
+    StageReflection result;
     spirv_cross::CompilerGLSL compiler{src, len};
     const auto resources = compiler.get_shader_resources();
 
     for (auto &buffer: resources.uniform_buffers)
     {
         const auto& name = compiler.get_name(buffer.id);
-        uniformBuffers_[name].binding = compiler.get_decoration(buffer.id, spv::DecorationBinding);
+        auto &uniformBuffer = result.uniformBuffers[name];
+        uniformBuffer.binding = compiler.get_decoration(buffer.id, spv::DecorationBinding);
 
         u32 size = 0;
         const auto ranges = compiler.get_active_buffer_ranges(buffer.id);
@@ -103,18 +402,37 @@ void VulkanEffect::introspectShader(const u32 *src, u32 len, bool vertex)
             auto memberName = compiler.get_member_name(buffer.base_type_id, range.index);
             if (memberName.empty())
                 memberName = compiler.get_member_qualified_name(buffer.base_type_id, range.index);
-            uniformBuffers_[name].members[memberName].size = range.range;
-            uniformBuffers_[name].members[memberName].offset = range.offset;
+            uniformBuffer.members[memberName].size = range.range;
+            uniformBuffer.members[memberName].offset = range.offset;
             size += range.range;
         }
 
-        uniformBuffers_[name].size = size;
+        uniformBuffer.size = size;
+    }
+
+    for (auto &buffer: resources.push_constant_buffers)
+    {
+        result.pushConstantBufferName = compiler.get_name(buffer.id);
+
+        const auto ranges = compiler.get_active_buffer_ranges(buffer.id);
+        for (auto &range: ranges)
+        {
+            auto memberName = compiler.get_member_name(buffer.base_type_id, range.index);
+            if (memberName.empty())
+                memberName = compiler.get_member_qualified_name(buffer.base_type_id, range.index);
+            result.pushConstantBuffer.members[memberName].size = range.range;
+            result.pushConstantBuffer.members[memberName].offset = range.offset;
+        }
+
+        // Members are pushed by their offsets, so the block is sized as declared rather than by summing ranges
+        const auto size = compiler.get_declared_struct_size(compiler.get_type(buffer.base_type_id));
+        result.pushConstantBuffer.size = static_cast<u32>(size);
     }
 
     for (auto &sampler: resources.sampled_images)
     {
         const auto binding = compiler.get_decoration(sampler.id, spv::DecorationBinding);
-        samplers_[sampler.name].binding = binding;
+        result.samplers[sampler.name].binding = binding;
     }
 
     if (vertex)
@@ -123,9 +441,42 @@ void VulkanEffect::introspectShader(const u32 *src, u32 len, bool vertex)
         {
             const auto name = stageInput.name;
             const auto location = compiler.get_decoration(stageInput.id, spv::DecorationLocation);
-            vertexAttributes_[name].location = location;
+            result.vertexAttributes[name].location = location;
         }
     }
+
+    return result;
+}
+
+void VulkanEffect::applyReflection(const StageReflection &reflection, bool vertex)
+{
+    for (const auto &p: reflection.uniformBuffers)
+    {
+        auto &buffer = uniformBuffers_[p.first];
+        buffer.binding = p.second.binding;
+        buffer.size = p.second.size;
+        for (const auto &member: p.second.members)
+            buffer.members[member.first] = member.second;
+    }
+
+    if (!reflection.pushConstantBufferName.empty())
+    {
+        const auto &name = reflection.pushConstantBufferName;
+        SL_DEBUG_PANIC(!pushConstantBufferName_.empty() && pushConstantBufferName_ != name,
+            "Only one push constant buffer per effect is supported");
+
+        pushConstantBufferName_ = name;
+        pushConstantStages_ |= vertex ? VK_SHADER_STAGE_VERTEX_BIT : VK_SHADER_STAGE_FRAGMENT_BIT;
+        for (const auto &member: reflection.pushConstantBuffer.members)
+            pushConstantBuffer_.members[member.first] = member.second;
+        pushConstantBuffer_.size = std::max(pushConstantBuffer_.size, reflection.pushConstantBuffer.size);
+    }
+
+    for (const auto &p: reflection.samplers)
+        samplers_[p.first] = p.second;
+
+    for (const auto &p: reflection.vertexAttributes)
+        vertexAttributes_[p.first] = p.second;
 }
 
 #endif
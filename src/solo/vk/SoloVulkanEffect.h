@@ -42,10 +42,41 @@ namespace solo
             u32 location;
         };
 
+        // What a single shader stage exposes, extracted from its SPIR-V
+        struct StageReflection
+        {
+            umap<str, UniformBuffer> uniformBuffers;
+            str pushConstantBufferName;
+            UniformBuffer pushConstantBuffer;
+            umap<str, Sampler> samplers;
+            umap<str, VertexAttribute> vertexAttributes;
+        };
+
+        struct CompiledStage
+        {
+            vec<u32> spirv;
+            StageReflection reflection;
+        };
+
+        struct CompiledSources
+        {
+            CompiledStage vertex;
+            CompiledStage fragment;
+        };
+
         static auto fromSources(Device *device, const void *vsSrc, u32 vsSrcLen, const void *fsSrc, u32 fsSrcLen)
             -> sptr<VulkanEffect>;
+        static auto fromCompiledSources(Device *device, const CompiledSources &sources) -> sptr<VulkanEffect>;
+
+        // Compiles and reflects both stages without touching the Vulkan device, safe to call from any thread
+        static auto compileSources(Device *device, const void *vsSrc, u32 vsSrcLen, const void *fsSrc, u32 fsSrcLen)
+            -> sptr<CompiledSources>;
+
+        static auto reflect(const u32 *src, u32 len, bool vertex) -> StageReflection;
 
         VulkanEffect(Device *device, const void *vsSrc, u32 vsSrcLen, const void *fsSrc, u32 fsSrcLen);
+        VulkanEffect(Device *device, const void *vsSrc, u32 vsSrcLen, const StageReflection &vsReflection,
+            const void *fsSrc, u32 fsSrcLen, const StageReflection &fsReflection);
         ~VulkanEffect() = default;
 
         auto vsModule() const -> VkShaderModule { return vs_; }
@@ -55,6 +86,10 @@ namespace solo
         auto sampler(const str &name) -> Sampler;
 
         auto uniformBuffers() const -> umap<str, UniformBuffer> const& { return uniformBuffers_; }
+        auto pushConstantBufferName() const -> str const& { return pushConstantBufferName_; }
+        auto pushConstantBuffer() const -> UniformBuffer const& { return pushConstantBuffer_; }
+        auto pushConstantStages() const -> VkShaderStageFlags { return pushConstantStages_; }
+        bool hasPushConstants() const { return pushConstantBuffer_.size > 0; }
         auto samplers() const -> umap<str, Sampler> const& { return samplers_; }
         auto vertexAttributes() const -> umap<str, VertexAttribute> const& { return vertexAttributes_; }
 
@@ -64,10 +99,13 @@ namespace solo
         VulkanResource<VkShaderModule> fs_;
             
         umap<str, UniformBuffer> uniformBuffers_;
+        str pushConstantBufferName_;
+        UniformBuffer pushConstantBuffer_;
+        VkShaderStageFlags pushConstantStages_ = 0;
         umap<str, Sampler> samplers_;
         umap<str, VertexAttribute> vertexAttributes_;
 
-        void introspectShader(const u32 *src, u32 len, bool vertex);
+        void applyReflection(const StageReflection &reflection, bool vertex);
     };
 }
 
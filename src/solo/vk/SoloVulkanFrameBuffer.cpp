@@ -31,13 +31,15 @@ auto VulkanFrameBuffer::fromAttachments(Device *device, const vec<sptr<Texture2D
         else
         {
             result->colorAttachments_.push_back(texture);
-            config.addColorAttachment(texture->image().format(), VK_IMAGE_LAYOUT_GENERAL); // TODO better layout
+            config.addColorAttachment(texture->image().format(), texture->image().layout());
             views.push_back(texture->image().view());
         }
     }
 
     result->dimensions_ = attachments[0]->dimensions();
 
+    // Only a depth texture provided by the user can be sampled later, an internal one needn't be stored
+    const auto preserveDepth = result->depthAttachment_ != nullptr;
     if (!result->depthAttachment_)
     {
         result->depthAttachment_ = VulkanTexture2D::empty(device,
@@ -45,7 +47,7 @@ auto VulkanFrameBuffer::fromAttachments(Device *device, const vec<sptr<Texture2D
     }
 
     views.push_back(result->depthAttachment_->image().view());
-    config.setDepthAttachment(result->depthAttachment_->image().format());
+    config.setDepthAttachment(result->depthAttachment_->image().format(), preserveDepth);
 
     result->renderPass_ = VulkanRenderPass(renderer->device(), config);
     result->frameBuffer_ = vk::createFrameBuffer(renderer->device(), views, result->renderPass_, result->dimensions_.x(), result->dimensions_.y());
@@ -12,6 +12,8 @@
 #include "SoloVulkanBuffer.h"
 #include "SoloTextureData.h"
 #include "SoloVulkanCmdBuffer.h"
+#include "SoloVulkanUploader.h"
+#include <cstring>
 
 using namespace solo;
 
@@ -33,8 +35,11 @@ static auto toVulkanFormat(TextureFormat format) -> VkFormat
 }
 
 static auto createImage(VkDevice device, VkFormat format, u32 width, u32 height, u32 mipLevels,
-    u32 arrayLayers, VkImageCreateFlags createFlags, VkImageUsageFlags usageFlags) -> VulkanResource<VkImage>
+    u32 arrayLayers, VkImageCreateFlags createFlags, VkImageUsageFlags usageFlags,
+    u32 queueIndex, u32 transferQueueIndex) -> VulkanResource<VkImage>
 {
+    const u32 queueIndices[] = {queueIndex, transferQueueIndex};
+
     VkImageCreateInfo imageCreateInfo{};
     imageCreateInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
     imageCreateInfo.imageType = VK_IMAGE_TYPE_2D;
@@ -49,6 +54,14 @@ static auto createImage(VkDevice device, VkFormat format, u32 width, u32 height,
     imageCreateInfo.usage = usageFlags;
     imageCreateInfo.flags = createFlags;
 
+    // Images filled on the transfer queue are then used on the graphics one
+    if ((usageFlags & VK_IMAGE_USAGE_TRANSFER_DST_BIT) && queueIndex != transferQueueIndex)
+    {
+        imageCreateInfo.sharingMode = VK_SHARING_MODE_CONCURRENT;
+        imageCreateInfo.queueFamilyIndexCount = 2;
+        imageCreateInfo.pQueueFamilyIndices = queueIndices;
+    }
+
     VulkanResource<VkImage> image{device, vkDestroyImage};
     SL_VK_CHECK_RESULT(vkCreateImage(device, &imageCreateInfo, nullptr, image.cleanRef()));
 
@@ -76,7 +89,7 @@ static auto allocateImageMemory(VkDevice device, VkPhysicalDeviceMemoryPropertie
 auto VulkanImage::empty(const VulkanDevice &dev, u32 width, u32 height, TextureFormat format) -> VulkanImage
 {
     const auto isDepth = format == TextureFormat::Depth24;
-    const auto layout = VK_IMAGE_LAYOUT_GENERAL; // TODO better
+    const auto layout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL; // render passes bring it back here when done
     const auto usage = VK_IMAGE_USAGE_SAMPLED_BIT |
         (isDepth
             ? VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT
@@ -110,13 +123,11 @@ auto VulkanImage::empty(const VulkanDevice &dev, u32 width, u32 height, TextureF
         range
     );
 
-    VulkanCmdBuffer(dev)
-        .begin(true)
+    dev.uploader().graphicsCmdBuffer()
         .putImagePipelineBarrier(
             VK_PIPELINE_STAGE_ALL_COMMANDS_BIT,
             VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT,
-            barrier)
-        .endAndFlush();
+            barrier);
 
     return image;
 }
@@ -127,7 +138,7 @@ auto VulkanImage::fromData(const VulkanDevice &dev, Texture2DData *data, bool ge
     const auto width = static_cast<u32>(data->dimensions().x());
     const auto height = static_cast<u32>(data->dimensions().y());
     const auto format = toVulkanFormat(data->textureFormat());
-    const auto layout = VK_IMAGE_LAYOUT_GENERAL;
+    const auto layout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
     auto usage =
         VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT |
         VK_IMAGE_USAGE_SAMPLED_BIT |
@@ -162,28 +173,37 @@ auto VulkanImage::fromData(const VulkanDevice &dev, Texture2DData *data, bool ge
     range.levelCount = 1;
     range.layerCount = 1;
 
-    const auto barrier = vk::makeImagePipelineBarrier(
-        image.image_,
-        VK_IMAGE_LAYOUT_UNDEFINED,
-        VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
-        range
-    );
+    auto &uploader = dev.uploader();
+    const auto staging = uploader.stage(data->size());
+    memcpy(staging.data, data->data(), data->size());
 
-    const auto srcBuf = VulkanBuffer::staging(dev, data->size(), data->data());
+    VkBufferImageCopy region{};
+    region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+    region.imageSubresource.layerCount = 1;
+    region.imageExtent.width = width;
+    region.imageExtent.height = height;
+    region.imageExtent.depth = 1;
+    region.bufferOffset = staging.offset;
 
-    auto initCmdBuf = VulkanCmdBuffer(dev);
-    initCmdBuf.begin(true);
-    initCmdBuf.putImagePipelineBarrier(
-        VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT,
-        VK_PIPELINE_STAGE_TRANSFER_BIT,
-        barrier
-    );
+    uploader.transferCmdBuffer()
+        .putImagePipelineBarrier(
+            VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT,
+            VK_PIPELINE_STAGE_TRANSFER_BIT,
+            vk::makeImagePipelineBarrier(
+                image.image_,
+                VK_IMAGE_LAYOUT_UNDEFINED,
+                VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+                range
+            )
+        )
+        .copyBuffer(staging.buffer, image.image_, &region, 1);
 
-    initCmdBuf.copyBuffer(srcBuf, image);
+    // Blits and the final transition need a graphics queue, they run once the copy is done
+    auto &cmdBuf = uploader.graphicsCmdBuffer();
 
     if (generateMipmaps)
     {
-        initCmdBuf.putImagePipelineBarrier(
+        cmdBuf.putImagePipelineBarrier(
             VK_PIPELINE_STAGE_TRANSFER_BIT,
             VK_PIPELINE_STAGE_TRANSFER_BIT,
             vk::makeImagePipelineBarrier(
@@ -193,10 +213,6 @@ auto VulkanImage::fromData(const VulkanDevice &dev, Texture2DData *data, bool ge
                 range
             )
         );
-        initCmdBuf.endAndFlush();
-
-        auto blitCmdBuf = VulkanCmdBuffer(dev);
-        blitCmdBuf.begin(true);
 
         for (u32 i = 1; i < mipLevels; i++)
         {
@@ -224,7 +240,7 @@ auto VulkanImage::fromData(const VulkanDevice &dev, Texture2DData *data, bool ge
             mipSubRange.levelCount = 1;
             mipSubRange.layerCount = 1;
 
-            blitCmdBuf.putImagePipelineBarrier(
+            cmdBuf.putImagePipelineBarrier(
                 VK_PIPELINE_STAGE_TRANSFER_BIT,
                 VK_PIPELINE_STAGE_TRANSFER_BIT,
                 vk::makeImagePipelineBarrier(
@@ -235,7 +251,7 @@ auto VulkanImage::fromData(const VulkanDevice &dev, Texture2DData *data, bool ge
                 )
             );
 
-            blitCmdBuf.blit(
+            cmdBuf.blit(
                 image.image_,
                 image.image_,
                 VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
@@ -244,7 +260,7 @@ auto VulkanImage::fromData(const VulkanDevice &dev, Texture2DData *data, bool ge
                 VK_FILTER_LINEAR
             );
 
-            blitCmdBuf.putImagePipelineBarrier(
+            cmdBuf.putImagePipelineBarrier(
                 VK_PIPELINE_STAGE_TRANSFER_BIT,
                 VK_PIPELINE_STAGE_TRANSFER_BIT,
                 vk::makeImagePipelineBarrier(
@@ -258,7 +274,7 @@ auto VulkanImage::fromData(const VulkanDevice &dev, Texture2DData *data, bool ge
 
         range.levelCount = static_cast<u32>(mipLevels);
 
-        blitCmdBuf.putImagePipelineBarrier(
+        cmdBuf.putImagePipelineBarrier(
             VK_PIPELINE_STAGE_TRANSFER_BIT,
             VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT,
             vk::makeImagePipelineBarrier(
@@ -268,12 +284,10 @@ auto VulkanImage::fromData(const VulkanDevice &dev, Texture2DData *data, bool ge
                 range
             )
         );
-
-        blitCmdBuf.endAndFlush();
     }
     else
     {
-        initCmdBuf.putImagePipelineBarrier(
+        cmdBuf.putImagePipelineBarrier(
             VK_PIPELINE_STAGE_TRANSFER_BIT,
             VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT,
             vk::makeImagePipelineBarrier(
@@ -283,7 +297,6 @@ auto VulkanImage::fromData(const VulkanDevice &dev, Texture2DData *data, bool ge
                 range
             )
         );
-        initCmdBuf.endAndFlush();
     }
 
     return image;
@@ -296,7 +309,7 @@ auto VulkanImage::fromCubeData(const VulkanDevice &dev, CubeTextureData *data) -
     const auto width = data->dimension();
     const auto height = width;
     const auto format = toVulkanFormat(data->textureFormat());
-    const auto layout = VK_IMAGE_LAYOUT_GENERAL;
+    const auto layout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
     const auto usage =
         VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT |
         VK_IMAGE_USAGE_SAMPLED_BIT |
@@ -320,8 +333,8 @@ auto VulkanImage::fromCubeData(const VulkanDevice &dev, CubeTextureData *data) -
     range.levelCount = mipLevels;
     range.layerCount = layers;
 
-    auto cmdBuf = VulkanCmdBuffer(dev);
-    cmdBuf.begin(true);
+    auto &uploader = dev.uploader();
+    auto &cmdBuf = uploader.transferCmdBuffer();
 
     cmdBuf.putImagePipelineBarrier(
         VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT,
@@ -334,7 +347,7 @@ auto VulkanImage::fromCubeData(const VulkanDevice &dev, CubeTextureData *data) -
         )
     );
 
-    auto srcBuf = VulkanBuffer::staging(dev, data->size());
+    const auto staging = uploader.stage(data->size());
 
     // Engine provides faces in order +X, -X, +Y, -Y, +Z, -Z
     // Vulkan's Y axis is inverted, so we invert
@@ -345,7 +358,7 @@ auto VulkanImage::fromCubeData(const VulkanDevice &dev, CubeTextureData *data) -
     VkBufferImageCopy copyRegions[copyRegionCount];
     for (u32 layer = 0; layer < layers; layer++)
     {
-        srcBuf.updatePart(data->faceData(layerFaceMapping[layer]), offset, data->faceSize(layerFaceMapping[layer]));
+        memcpy(staging.data + offset, data->faceData(layerFaceMapping[layer]), data->faceSize(layerFaceMapping[layer]));
 
         for (u32 level = 0; level < mipLevels; level++)
         {
@@ -357,7 +370,7 @@ auto VulkanImage::fromCubeData(const VulkanDevice &dev, CubeTextureData *data) -
             region.imageExtent.width = data->dimension();
             region.imageExtent.height = data->dimension();
             region.imageExtent.depth = 1;
-            region.bufferOffset = offset;
+            region.bufferOffset = staging.offset + offset;
 
             copyRegions[mipLevels * layer + level] = region;
 
@@ -366,13 +379,13 @@ auto VulkanImage::fromCubeData(const VulkanDevice &dev, CubeTextureData *data) -
     }
 
     cmdBuf.copyBuffer(
-        srcBuf,
-        image,
+        staging.buffer,
+        image.image_,
         copyRegions,
         copyRegionCount
     );
 
-    cmdBuf.putImagePipelineBarrier(
+    uploader.graphicsCmdBuffer().putImagePipelineBarrier(
         VK_PIPELINE_STAGE_TRANSFER_BIT,
         VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT,
         vk::makeImagePipelineBarrier(
@@ -383,8 +396,6 @@ auto VulkanImage::fromCubeData(const VulkanDevice &dev, CubeTextureData *data) -
         )
     );
 
-    cmdBuf.endAndFlush();
-
     return image;
 }
 
@@ -407,7 +418,8 @@ VulkanImage::VulkanImage(const VulkanDevice &dev, u32 width, u32 height, u32 mip
     height_(height),
     aspectMask_(aspectMask)
 {
-    image_ = createImage(dev.handle(), format, width, height, mipLevels, layers, createFlags, usageFlags);
+    image_ = createImage(dev.handle(), format, width, height, mipLevels, layers, createFlags, usageFlags,
+        dev.queueIndex(), dev.transferQueueIndex());
     memory_ = allocateImageMemory(dev.handle(), dev.physicalMemoryFeatures(), image_);
     view_ = vk::createImageView(dev.handle(), format, viewType, mipLevels, layers, image_, aspectMask);
 }
@@ -15,6 +15,8 @@
 #include "SoloVulkanRenderer.h"
 #include "SoloVulkanTexture.h"
 #include "SoloVulkanPipeline.h"
+#include <cstring>
+#include <algorithm>
 
 using namespace solo;
 
@@ -52,9 +54,31 @@ static auto convertBlendFactor(BlendFactor factor) -> VkBlendFactor
     return VK_BLEND_FACTOR_MAX_ENUM;
 }
 
+static bool isPerObjectBinding(ParameterBinding binding)
+{
+    switch (binding)
+    {
+        case ParameterBinding::WorldMatrix:
+        case ParameterBinding::WorldViewMatrix:
+        case ParameterBinding::WorldViewProjectionMatrix:
+        case ParameterBinding::InverseTransposedWorldMatrix:
+        case ParameterBinding::InverseTransposedWorldViewMatrix:
+            return true;
+        default:
+            return false;
+    }
+}
+
+template <class T>
+static void writeValue(void *dst, u32 size, const T &value)
+{
+    std::memcpy(dst, &value, (std::min)(size, static_cast<u32>(sizeof(T))));
+}
+
 VulkanMaterial::VulkanMaterial(const sptr<Effect> &effect):
     effect_(std::static_pointer_cast<VulkanEffect>(effect))
 {
+    pushConstantData_.resize(effect_->pushConstantBuffer().size);
 }
 
 auto VulkanMaterial::stateHash() const -> size_t
@@ -118,206 +142,266 @@ void VulkanMaterial::configurePipeline(VulkanPipelineConfig &cfg)
 
 void VulkanMaterial::setFloatParameter(const str &name, float value)
 {
-    setUniformParameter(name, [value](auto &buffer, auto offset, auto size, auto, auto)
-    {
-        buffer.updatePart(&value, offset, size);
-    });
+    setParameter(parameterHandle(name), &value, sizeof(value));
 }
 
 void VulkanMaterial::setVector2Parameter(const str &name, const Vector2 &value)
 {
-    setUniformParameter(name, [value](auto &buffer, auto offset, auto size, auto, auto)
-    {
-        buffer.updatePart(&value, offset, size);
-    });
+    setParameter(parameterHandle(name), &value, sizeof(value));
 }
 
 void VulkanMaterial::setVector3Parameter(const str &name, const Vector3 &value)
 {
-    setUniformParameter(name, [value](auto &buffer, auto offset, auto size, auto, auto)
-    {
-        buffer.updatePart(&value, offset, size);
-    });
+    setParameter(parameterHandle(name), &value, sizeof(value));
 }
 
 void VulkanMaterial::setVector4Parameter(const str &name, const Vector4 &value)
 {
-    setUniformParameter(name, [value](auto &buffer, auto offset, auto size, auto, auto)
-    {
-        buffer.updatePart(&value, offset, size);
-    });
+    setParameter(parameterHandle(name), &value, sizeof(value));
 }
 
 void VulkanMaterial::setMatrixParameter(const str &name, const Matrix &value)
 {
-    // TODO avoid copy-paste
-    setUniformParameter(name, [value](auto &buffer, auto offset, auto size, auto, auto)
-    {
-        buffer.updatePart(&value, offset, size);
-    });
+    setParameter(parameterHandle(name), &value, sizeof(value));
 }
 
-void VulkanMaterial::setUniformParameter(const str &name, const ParameterWriteFunc &write)
+auto VulkanMaterial::useSlot(ParamHandle handle) -> ParameterSlot&
 {
-    auto parsedName = parseName(name);
-    auto bufferName = std::get<0>(parsedName);
-    auto fieldName = std::get<1>(parsedName);
-    SL_DEBUG_PANIC(bufferName.empty() || fieldName.empty(), "Invalid material parameter name ", name);
-
-    auto bufferInfo = effect_->uniformBuffer(bufferName);
-    const auto itemInfo = bufferInfo.members.at(fieldName);
-
-    auto &item = bufferItems_[bufferName][fieldName];
-    item.write = [itemInfo, write](VulkanBuffer &buffer, const Camera *camera, const Transform *transform)
+    auto &slot = parameterSlots_.at(handle);
+    if (!slot.used)
     {
-        write(buffer, itemInfo.offset, itemInfo.size, camera, transform);
-    };
+        slot.used = true;
+        if (slot.pushConstant)
+            pushConstantSlots_.push_back(handle);
+        else
+            bufferSlots_[slot.bufferName].push_back(handle);
+    }
+    return slot;
 }
 
-void VulkanMaterial::setTextureParameter(const str &name, sptr<Texture> value)
+void VulkanMaterial::setParameter(ParamHandle handle, const void *value, u32 size)
 {
-    const auto samplerInfo = effect_->sampler(name);
-    auto &sampler = samplers_[name];
-    sampler.binding = samplerInfo.binding;
-    sampler.texture = std::dynamic_pointer_cast<VulkanTexture>(value);
-    // TODO Optimize and mark only this sampler as dirty
+    const auto &info = parameterSlots_.at(handle);
+    SL_DEBUG_PANIC(info.bufferName.empty() || info.fieldName.empty(), "Invalid material parameter name ", info.name);
+    if (info.fieldName.empty())
+        return;
+
+    auto &slot = useSlot(handle);
+    const auto wasBound = slot.bound;
+    slot.bound = false;
+    slot.valueSize = (std::min)(size, static_cast<u32>(sizeof(slot.value)));
+    std::memcpy(slot.value, value, slot.valueSize);
+
+    if (wasBound && !slot.pushConstant)
+        updatePerObjectFlag();
 }
 
-void VulkanMaterial::bindParameter(const str &name, ParameterBinding binding)
+void VulkanMaterial::updatePerObjectFlag()
 {
-    auto parsedName = parseName(name);
-    auto bufferName = std::get<0>(parsedName);
-    auto fieldName = std::get<1>(parsedName);
-    SL_DEBUG_PANIC(bufferName.empty() || fieldName.empty(), "Invalid material parameter name ", name);
+    hasPerObjectBufferItems_ = false;
+    for (const auto &buffer: bufferSlots_)
+    {
+        for (const auto handle: buffer.second)
+        {
+            const auto &slot = parameterSlots_[handle];
+            hasPerObjectBufferItems_ = hasPerObjectBufferItems_ || (slot.bound && isPerObjectBinding(slot.binding));
+        }
+    }
+}
 
-    auto bufferInfo = effect_->uniformBuffer(bufferName);
-    SL_DEBUG_PANIC(!bufferInfo.size || bufferInfo.members.empty(), "Material parameter ", name, " not found");
+bool VulkanMaterial::writeSlot(const ParameterSlot &slot, void *dst, const Camera *camera, const Transform *transform) const
+{
+    const auto size = slot.info.size;
 
-    auto itemInfo = bufferInfo.members.at(fieldName);
-    auto &item = bufferItems_[bufferName][fieldName];
+    if (!slot.bound)
+    {
+        std::memcpy(dst, slot.value, (std::min)(size, slot.valueSize));
+        return true;
+    }
 
-    switch (binding)
+    switch (slot.binding)
     {
         case ParameterBinding::WorldMatrix:
-        {
-            item.write = [itemInfo](VulkanBuffer &buffer, const Camera *camera, const Transform *nodeTransform)
-            {
-                if (nodeTransform)
-                {
-                    auto value = nodeTransform->worldMatrix();
-                    buffer.updatePart(&value, itemInfo.offset, itemInfo.size);
-                }
-            };
-            break;
-        }
+            if (!transform)
+                return false;
+            writeValue(dst, size, transform->worldMatrix());
+            return true;
 
         case ParameterBinding::ViewMatrix:
-        {
-            item.write = [itemInfo](VulkanBuffer &buffer, const Camera *camera, const Transform *nodeTransform)
-            {
-                if (camera)
-                {
-                    auto value = camera->viewMatrix();
-                    buffer.updatePart(&value, itemInfo.offset, itemInfo.size);
-                }
-            };
-            break;
-        }
+            if (!camera)
+                return false;
+            writeValue(dst, size, camera->viewMatrix());
+            return true;
 
         case ParameterBinding::ProjectionMatrix:
-        {
-            item.write = [itemInfo](VulkanBuffer &buffer, const Camera *camera, const Transform *nodeTransform)
-            {
-                if (camera)
-                {
-                    auto value = camera->projectionMatrix();
-                    buffer.updatePart(&value, itemInfo.offset, itemInfo.size);
-                }
-            };
-            break;
-        }
+            if (!camera)
+                return false;
+            writeValue(dst, size, camera->projectionMatrix());
+            return true;
 
         case ParameterBinding::WorldViewMatrix:
-        {
-            item.write = [itemInfo](VulkanBuffer &buffer, const Camera *camera, const Transform *nodeTransform)
-            {
-                if (camera && nodeTransform)
-                {
-                    auto value = nodeTransform->worldViewMatrix(camera);
-                    buffer.updatePart(&value, itemInfo.offset, itemInfo.size);
-                }
-            };
-            break;
-        }
+            if (!camera || !transform)
+                return false;
+            writeValue(dst, size, transform->worldViewMatrix(camera));
+            return true;
 
         case ParameterBinding::ViewProjectionMatrix:
-        {
-            item.write = [itemInfo](VulkanBuffer &buffer, const Camera *camera, const Transform *nodeTransform)
-            {
-                if (camera)
-                {
-                    auto value = camera->viewProjectionMatrix();
-                    buffer.updatePart(&value, itemInfo.offset, itemInfo.size);
-                }
-            };
-            break;
-        }
+            if (!camera)
+                return false;
+            writeValue(dst, size, camera->viewProjectionMatrix());
+            return true;
 
         case ParameterBinding::WorldViewProjectionMatrix:
-        {
-            item.write = [itemInfo](VulkanBuffer &buffer, const Camera *camera, const Transform *nodeTransform)
-            {
-                if (nodeTransform && camera)
-                {
-                    auto value = nodeTransform->worldViewProjMatrix(camera);
-                    buffer.updatePart(&value, itemInfo.offset, itemInfo.size);
-                }
-            };
-            break;
-        }
+            if (!camera || !transform)
+                return false;
+            writeValue(dst, size, transform->worldViewProjMatrix(camera));
+            return true;
 
         case ParameterBinding::InverseTransposedWorldMatrix:
-        {
-            item.write = [itemInfo](VulkanBuffer &buffer, const Camera *camera, const Transform *nodeTransform)
-            {
-                if (nodeTransform)
-                {
-                    auto value = nodeTransform->invTransposedWorldMatrix();
-                    buffer.updatePart(&value, itemInfo.offset, itemInfo.size);
-                }
-            };
-            break;
-        }
+            if (!transform)
+                return false;
+            writeValue(dst, size, transform->invTransposedWorldMatrix());
+            return true;
 
         case ParameterBinding::InverseTransposedWorldViewMatrix:
+            if (!camera || !transform)
+                return false;
+            writeValue(dst, size, transform->invTransposedWorldViewMatrix(camera));
+            return true;
+
+        case ParameterBinding::CameraWorldPosition:
+            if (!camera)
+                return false;
+            writeValue(dst, size, camera->transform()->worldPosition());
+            return true;
+
+        default:
+            return false;
+    }
+}
+
+auto VulkanMaterial::parameterHandle(const str &name) -> ParamHandle
+{
+    const auto existing = parameterHandles_.find(name);
+    if (existing != parameterHandles_.end())
+        return existing->second;
+
+    ParameterSlot slot;
+    slot.name = name;
+
+    // Names without a buffer are samplers, those are only set by name
+    auto parsedName = parseName(name);
+    slot.bufferName = std::get<0>(parsedName);
+    slot.fieldName = std::get<1>(parsedName);
+    if (!slot.fieldName.empty())
+    {
+        if (slot.bufferName == effect_->pushConstantBufferName())
         {
-            item.write = [itemInfo](VulkanBuffer &buffer, const Camera *camera, const Transform *nodeTransform)
-            {
-                if (nodeTransform && camera)
-                {
-                    auto value = nodeTransform->invTransposedWorldViewMatrix(camera);
-                    buffer.updatePart(&value, itemInfo.offset, itemInfo.size);
-                }
-            };
-            break;
+            const auto &members = effect_->pushConstantBuffer().members;
+            SL_DEBUG_PANIC(!members.count(slot.fieldName), "Material parameter ", name, " not found");
+            slot.pushConstant = true;
+            slot.info = members.at(slot.fieldName);
+        }
+        else
+        {
+            auto bufferInfo = effect_->uniformBuffer(slot.bufferName);
+            SL_DEBUG_PANIC(!bufferInfo.size || !bufferInfo.members.count(slot.fieldName), "Material parameter ", name, " not found");
+            slot.info = bufferInfo.members.at(slot.fieldName);
+            SL_DEBUG_PANIC(slot.info.size > sizeof(Matrix), "Material parameter ", name, " is too large");
         }
+    }
 
-        case ParameterBinding::CameraWorldPosition:
+    const auto handle = static_cast<ParamHandle>(parameterSlots_.size());
+    parameterSlots_.push_back(slot);
+    parameterHandles_[name] = handle;
+    return handle;
+}
+
+void VulkanMaterial::setFloatParameter(ParamHandle handle, float value)
+{
+    setParameter(handle, &value, sizeof(value));
+}
+
+void VulkanMaterial::setVector2Parameter(ParamHandle handle, const Vector2 &value)
+{
+    setParameter(handle, &value, sizeof(value));
+}
+
+void VulkanMaterial::setVector3Parameter(ParamHandle handle, const Vector3 &value)
+{
+    setParameter(handle, &value, sizeof(value));
+}
+
+void VulkanMaterial::setVector4Parameter(ParamHandle handle, const Vector4 &value)
+{
+    setParameter(handle, &value, sizeof(value));
+}
+
+void VulkanMaterial::setMatrixParameter(ParamHandle handle, const Matrix &value)
+{
+    setParameter(handle, &value, sizeof(value));
+}
+
+void VulkanMaterial::setTextureParameter(ParamHandle handle, sptr<Texture> value)
+{
+    setTextureParameter(parameterSlots_.at(handle).name, value);
+}
+
+void VulkanMaterial::updateUniformBuffers(umap<str, VulkanBuffer> &buffers, const Camera *camera, const Transform *transform)
+{
+    u8 value[sizeof(Matrix)];
+
+    for (const auto &p: bufferSlots_)
+    {
+        const auto buffer = buffers.find(p.first);
+        if (buffer == buffers.end())
+            continue;
+
+        for (const auto handle: p.second)
         {
-            item.write = [itemInfo](VulkanBuffer &buffer, const Camera *camera, const Transform *nodeTransform)
-            {
-                if (camera)
-                {
-                    auto value = camera->transform()->worldPosition();
-                    buffer.updatePart(&value, itemInfo.offset, itemInfo.size);
-                }
-            };
-            break;
+            const auto &slot = parameterSlots_[handle];
+            if (writeSlot(slot, value, camera, transform))
+                buffer->second.updatePart(value, slot.info.offset, slot.info.size);
         }
+    }
+}
 
-        default:
-            SL_DEBUG_PANIC(true, "Unsupported parameter binding");
+void VulkanMaterial::updatePushConstants(const Camera *camera, const Transform *transform)
+{
+    for (const auto handle: pushConstantSlots_)
+    {
+        const auto &slot = parameterSlots_[handle];
+        writeSlot(slot, pushConstantData_.data() + slot.info.offset, camera, transform);
     }
 }
 
-#endif
+void VulkanMaterial::setTextureParameter(const str &name, sptr<Texture> value)
+{
+    const auto samplerInfo = effect_->sampler(name);
+    auto &sampler = samplers_[name];
+    sampler.binding = samplerInfo.binding;
+    sampler.texture = std::dynamic_pointer_cast<VulkanTexture>(value);
+    // TODO Optimize and mark only this sampler as dirty
+}
+
+void VulkanMaterial::bindParameter(const str &name, ParameterBinding binding)
+{
+    bindParameter(parameterHandle(name), binding);
+}
+
+void VulkanMaterial::bindParameter(ParamHandle handle, ParameterBinding binding)
+{
+    const auto &info = parameterSlots_.at(handle);
+    SL_DEBUG_PANIC(info.bufferName.empty() || info.fieldName.empty(), "Invalid material parameter name ", info.name);
+    if (info.fieldName.empty())
+        return;
+
+    auto &slot = useSlot(handle);
+    slot.bound = true;
+    slot.binding = binding;
+
+    if (!slot.pushConstant)
+        updatePerObjectFlag();
+}
+
+#endif
\ No newline at end of file
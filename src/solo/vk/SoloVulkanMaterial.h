@@ -25,11 +25,6 @@ namespace solo
     class VulkanMaterial final: public Material
     {
     public:
-        struct UniformBufferItem
-        {
-            std::function<void(VulkanBuffer &, const Camera *, const Transform *)> write;
-        };
-
         struct Sampler
         {
             u32 binding = 0;
@@ -50,20 +45,59 @@ namespace solo
 
         void bindParameter(const str &name, ParameterBinding binding) override final;
 
+        auto parameterHandle(const str &name) -> ParamHandle override final;
+
+        void setFloatParameter(ParamHandle handle, float value) override final;
+        void setVector2Parameter(ParamHandle handle, const Vector2 &value) override final;
+        void setVector3Parameter(ParamHandle handle, const Vector3 &value) override final;
+        void setVector4Parameter(ParamHandle handle, const Vector4 &value) override final;
+        void setMatrixParameter(ParamHandle handle, const Matrix &value) override final;
+        void setTextureParameter(ParamHandle handle, sptr<Texture> value) override final;
+
+        void bindParameter(ParamHandle handle, ParameterBinding binding) override final;
+
         auto samplers() const -> umap<str, Sampler> const& { return samplers_; }
-        auto bufferItems() const -> umap<str, umap<str, UniformBufferItem>> const& { return bufferItems_; } // TODO rename
+        bool hasPerObjectBufferItems() const { return hasPerObjectBufferItems_; }
+
+        // Write the current parameter values and bindings, when the renderer binds the material
+        void updateUniformBuffers(umap<str, VulkanBuffer> &buffers, const Camera *camera, const Transform *transform);
+        void updatePushConstants(const Camera *camera, const Transform *transform);
+        auto pushConstantData() const -> vec<u8> const& { return pushConstantData_; }
+
         auto stateHash() const -> size_t;
 
         void configurePipeline(VulkanPipelineConfig &cfg);
 
     private:
-        using ParameterWriteFunc = std::function<void(VulkanBuffer &, u32, u32, const Camera *, const Transform *)>;
+        // Resolved parameter name, holding either the last value set or the binding to evaluate
+        struct ParameterSlot
+        {
+            str name;
+            str bufferName;
+            str fieldName;
+            bool pushConstant = false;
+            VulkanEffect::UniformBufferMember info = {};
+            bool used = false;
+            bool bound = false;
+            ParameterBinding binding = ParameterBinding::WorldMatrix;
+            u32 valueSize = 0;
+            u8 value[sizeof(Matrix)];
+        };
 
         sptr<VulkanEffect> effect_;
-        umap<str, umap<str, UniformBufferItem>> bufferItems_;
         umap<str, Sampler> samplers_;
-
-        void setUniformParameter(const str &name, const ParameterWriteFunc &write);
+        vec<u8> pushConstantData_;
+        bool hasPerObjectBufferItems_ = false;
+        vec<ParameterSlot> parameterSlots_;
+        umap<str, ParamHandle> parameterHandles_;
+        // Handles of used slots, grouped by where they are written
+        umap<str, vec<ParamHandle>> bufferSlots_;
+        vec<ParamHandle> pushConstantSlots_;
+
+        auto useSlot(ParamHandle handle) -> ParameterSlot&;
+        void setParameter(ParamHandle handle, const void *value, u32 size);
+        bool writeSlot(const ParameterSlot &slot, void *dst, const Camera *camera, const Transform *transform) const;
+        void updatePerObjectFlag();
     };
 }
 
@@ -17,16 +17,101 @@ using namespace solo;
 
 static auto toVertexFormat(const VertexAttribute &attr) -> VkFormat
 {
-    switch (attr.elementCount)
+    // Three-component 16 and 8-bit formats are rarely supported for vertex buffers, the padded four-component
+    // ones are read instead and the shader ignores the extra component
+    switch (attr.format)
     {
-        case 1: return VK_FORMAT_R32_SFLOAT;
-        case 2: return VK_FORMAT_R32G32_SFLOAT;
-        case 3: return VK_FORMAT_R32G32B32_SFLOAT;
-        case 4: return VK_FORMAT_R32G32B32A32_SFLOAT;
-        default:
-            SL_DEBUG_PANIC(true, "Unsupported vertex attribute element count");
-            return VK_FORMAT_UNDEFINED;
+        case VertexAttributeFormat::Float:
+            switch (attr.elementCount)
+            {
+                case 1: return VK_FORMAT_R32_SFLOAT;
+                case 2: return VK_FORMAT_R32G32_SFLOAT;
+                case 3: return VK_FORMAT_R32G32B32_SFLOAT;
+                case 4: return VK_FORMAT_R32G32B32A32_SFLOAT;
+                default: break;
+            }
+            break;
+        case VertexAttributeFormat::Half:
+            switch (attr.elementCount)
+            {
+                case 1: return VK_FORMAT_R16_SFLOAT;
+                case 2: return VK_FORMAT_R16G16_SFLOAT;
+                case 3:
+                case 4: return VK_FORMAT_R16G16B16A16_SFLOAT;
+                default: break;
+            }
+            break;
+        case VertexAttributeFormat::SNorm8:
+            switch (attr.elementCount)
+            {
+                case 1: return VK_FORMAT_R8_SNORM;
+                case 2: return VK_FORMAT_R8G8_SNORM;
+                case 3:
+                case 4: return VK_FORMAT_R8G8B8A8_SNORM;
+                default: break;
+            }
+            break;
+        case VertexAttributeFormat::UNorm8:
+            switch (attr.elementCount)
+            {
+                case 1: return VK_FORMAT_R8_UNORM;
+                case 2: return VK_FORMAT_R8G8_UNORM;
+                case 3:
+                case 4: return VK_FORMAT_R8G8B8A8_UNORM;
+                default: break;
+            }
+            break;
+        case VertexAttributeFormat::SNorm10_10_10_2:
+            return VK_FORMAT_A2B10G10R10_SNORM_PACK32;
     }
+
+    SL_DEBUG_PANIC(true, "Unsupported vertex attribute format or element count");
+    return VK_FORMAT_UNDEFINED;
+}
+
+static bool hasUnsupportedFormats(const VulkanDevice &device, const VertexBufferLayout &layout)
+{
+    for (u32 i = 0; i < layout.attributeCount(); i++)
+    {
+        if (layout.attribute(i).format == VertexAttributeFormat::SNorm10_10_10_2 &&
+            !device.isBufferFormatSupported(VK_FORMAT_A2B10G10R10_SNORM_PACK32, VK_FORMAT_FEATURE_VERTEX_BUFFER_BIT))
+            return true;
+    }
+    return false;
+}
+
+// Packed 10-10-10-2 vertex input is optional, such attributes are uploaded as half floats where it's missing
+static auto supportedLayout(const VulkanDevice &device, const VertexBufferLayout &layout) -> VertexBufferLayout
+{
+    if (!hasUnsupportedFormats(device, layout))
+        return layout;
+
+    VertexBufferLayout result;
+    for (u32 i = 0; i < layout.attributeCount(); i++)
+    {
+        const auto attr = layout.attribute(i);
+        const auto packed = attr.format == VertexAttributeFormat::SNorm10_10_10_2;
+        result.addAttribute(attr.usage, packed ? VertexAttributeFormat::Half : attr.format);
+    }
+    return result;
+}
+
+static auto repack(const VertexBufferLayout &from, const VertexBufferLayout &to, const void *data, u32 vertexCount) -> vec<u8>
+{
+    vec<u8> result(static_cast<size_t>(to.size()) * vertexCount);
+    const auto src = static_cast<const u8*>(data);
+    float components[4];
+    for (u32 v = 0; v < vertexCount; v++)
+    {
+        for (u32 i = 0; i < from.attributeCount(); i++)
+        {
+            const auto fromAttr = from.attribute(i);
+            const auto toAttr = to.attribute(i);
+            VertexBufferLayout::unpackAttribute(fromAttr, src + v * from.size() + fromAttr.offset, components);
+            VertexBufferLayout::packAttribute(toAttr, components, result.data() + v * to.size() + toAttr.offset);
+        }
+    }
+    return result;
 }
 
 VulkanMesh::VulkanMesh(Device *device)
@@ -36,20 +121,30 @@ VulkanMesh::VulkanMesh(Device *device)
 
 auto VulkanMesh::addVertexBuffer(const VertexBufferLayout &layout, const void *data, u32 vertexCount) -> u32
 {
-    auto buf = VulkanBuffer::deviceLocal(renderer_->device(), layout.size() * vertexCount, VK_BUFFER_USAGE_VERTEX_BUFFER_BIT, data);
-    return addVertexBuffer(buf, layout, vertexCount);
+    const auto uploadLayout = supportedLayout(renderer_->device(), layout);
+    const auto repacked = data && hasUnsupportedFormats(renderer_->device(), layout) ? repack(layout, uploadLayout, data, vertexCount) : vec<u8>();
+    const auto uploadData = repacked.empty() ? data : repacked.data();
+    auto buf = VulkanBuffer::deviceLocal(renderer_->device(), uploadLayout.size() * vertexCount, VK_BUFFER_USAGE_VERTEX_BUFFER_BIT, uploadData);
+    includeVertexBounds(layout, data, vertexCount, false);
+    return addVertexBuffer(buf, uploadLayout, layout, vertexCount);
 }
 
 auto VulkanMesh::addDynamicVertexBuffer(const VertexBufferLayout &layout, const void *data, u32 vertexCount) -> u32
 {
-    auto buf = VulkanBuffer::hostVisible(renderer_->device(), layout.size() * vertexCount, VK_BUFFER_USAGE_VERTEX_BUFFER_BIT, data);
-    return addVertexBuffer(buf, layout, vertexCount);
+    const auto uploadLayout = supportedLayout(renderer_->device(), layout);
+    const auto repacked = data && hasUnsupportedFormats(renderer_->device(), layout) ? repack(layout, uploadLayout, data, vertexCount) : vec<u8>();
+    const auto uploadData = repacked.empty() ? data : repacked.data();
+    auto buf = VulkanBuffer::hostVisible(renderer_->device(), uploadLayout.size() * vertexCount, VK_BUFFER_USAGE_VERTEX_BUFFER_BIT, uploadData);
+    includeVertexBounds(layout, data, vertexCount, true);
+    return addVertexBuffer(buf, uploadLayout, layout, vertexCount);
 }
 
-auto VulkanMesh::addVertexBuffer(VulkanBuffer &buffer, const VertexBufferLayout &layout, u32 vertexCount) -> s32
+auto VulkanMesh::addVertexBuffer(VulkanBuffer &buffer, const VertexBufferLayout &layout, const VertexBufferLayout &sourceLayout,
+    u32 vertexCount) -> s32
 {
     vertexBuffers_.push_back(std::move(buffer));
     layouts_.push_back(layout);
+    sourceLayouts_.push_back(sourceLayout);
     vertexCounts_.push_back(vertexCount);
 
     updateMinVertexCount();
@@ -59,24 +154,31 @@ auto VulkanMesh::addVertexBuffer(VulkanBuffer &buffer, const VertexBufferLayout
 
 void VulkanMesh::updateDynamicVertexBuffer(u32 index, u32 vertexOffset, const void *data, u32 vertexCount)
 {
-    const auto vertexSize = layouts_[index].size();
-    vertexBuffers_[index].updatePart(data, vertexOffset * vertexSize, vertexCount * vertexSize);
+    const auto &layout = layouts_[index];
+    const auto &sourceLayout = sourceLayouts_[index];
+    const auto vertexSize = layout.size();
+    if (!hasUnsupportedFormats(renderer_->device(), sourceLayout))
+        vertexBuffers_[index].updatePart(data, vertexOffset * vertexSize, vertexCount * vertexSize);
+    else
+        vertexBuffers_[index].updatePart(repack(sourceLayout, layout, data, vertexCount).data(), vertexOffset * vertexSize, vertexCount * vertexSize);
 }
 
 void VulkanMesh::removeVertexBuffer(u32 index)
 {
     vertexBuffers_.erase(vertexBuffers_.begin() + index);
     layouts_.erase(layouts_.begin() + index);
+    sourceLayouts_.erase(sourceLayouts_.begin() + index);
     vertexCounts_.erase(vertexCounts_.begin() + index);
     updateMinVertexCount();
 }
 
-auto VulkanMesh::addPart(const void *indexData, u32 indexElementCount) -> u32
+auto VulkanMesh::addPart(const void *indexData, u32 indexElementCount, IndexElementSize elementSize) -> u32
 {
-    const auto size = sizeof(u32) * indexElementCount; // TODO 16-bit index support?
+    const auto size = indexElementSizeInBytes(elementSize) * indexElementCount;
     auto buf = VulkanBuffer::deviceLocal(renderer_->device(), size, VK_BUFFER_USAGE_INDEX_BUFFER_BIT, indexData);
     indexBuffers_.push_back(std::move(buf));
     indexElementCounts_.push_back(indexElementCount);
+    indexElementSizes_.push_back(elementSize);
     return static_cast<u32>(indexElementCounts_.size() - 1);
 }
 
@@ -84,6 +186,13 @@ void VulkanMesh::removePart(u32 index)
 {
     indexBuffers_.erase(indexBuffers_.begin() + index);
     indexElementCounts_.erase(indexElementCounts_.begin() + index);
+    indexElementSizes_.erase(indexElementSizes_.begin() + index);
+    removePartBounds(index);
+}
+
+auto VulkanMesh::partIndexType(u32 index) const -> VkIndexType
+{
+    return indexElementSizes_.at(index) == IndexElementSize::Bits16 ? VK_INDEX_TYPE_UINT16 : VK_INDEX_TYPE_UINT32;
 }
 
 auto VulkanMesh::primitiveType() const -> PrimitiveType
@@ -117,6 +226,7 @@ auto VulkanMesh::layoutHash() const -> size_t
             combineHash(seed, unsignedHasher(attr.location));
             combineHash(seed, unsignedHasher(attr.offset));
             combineHash(seed, unsignedHasher(attr.size));
+            combineHash(seed, unsignedHasher(static_cast<u32>(attr.format)));
         }
     }
 
@@ -167,6 +277,17 @@ void VulkanMesh::configurePipeline(VulkanPipelineConfig &cfg, VulkanEffect *effe
             offset += attr.size;
         }
     }
+
+    // Per-instance world matrices come from an extra binding after the mesh buffers, one vec4 column per location
+    if (effect->isInstanced())
+    {
+        const auto binding = vertexBufferCount();
+        const auto location = effectVertexAttrs.at(Effect::instanceWorldAttributeName).location;
+        const auto columnSize = static_cast<u32>(4 * sizeof(float));
+        cfg.withVertexBinding(binding, 4 * columnSize, VK_VERTEX_INPUT_RATE_INSTANCE);
+        for (u32 i = 0; i < 4; i++)
+            cfg.withVertexAttribute(location + i, binding, VK_FORMAT_R32G32B32A32_SFLOAT, i * columnSize);
+    }
 }
 
 #endif
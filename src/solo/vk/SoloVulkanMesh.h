@@ -30,9 +30,10 @@ namespace solo
         void updateDynamicVertexBuffer(u32 index, u32 vertexOffset, const void *data, u32 vertexCount) override final;
         void removeVertexBuffer(u32 index) override final;
 
-        auto addPart(const void *indexData, u32 indexElementCount) -> u32 override final;
+        auto addPart(const void *indexData, u32 indexElementCount, IndexElementSize elementSize) -> u32 override final;
         void removePart(u32 index) override final;
         auto partCount() const -> u32 override final { return static_cast<u32>(indexBuffers_.size()); }
+        auto partIndexElementSize(u32 part) const -> IndexElementSize override final { return indexElementSizes_.at(part); }
 
         auto primitiveType() const -> PrimitiveType override final;
         void setPrimitiveType(PrimitiveType type) override final;
@@ -42,6 +43,7 @@ namespace solo
         auto vertexBuffer(u32 index) const -> VkBuffer { return vertexBuffers_.at(index).handle(); }
         auto partBuffer(u32 index) const -> VkBuffer { return indexBuffers_.at(index).handle(); }
         auto partIndexElementCount(u32 index) const -> u32 { return indexElementCounts_.at(index); }
+        auto partIndexType(u32 index) const -> VkIndexType;
         auto minVertexCount() const -> u32 { return minVertexCount_; }
 
         void configurePipeline(VulkanPipelineConfig &cfg, VulkanEffect *effect);
@@ -54,12 +56,15 @@ namespace solo
         vec<VulkanBuffer> vertexBuffers_;
         vec<VulkanBuffer> indexBuffers_;
         vec<VertexBufferLayout> layouts_;
+        vec<VertexBufferLayout> sourceLayouts_; // as given, differ from layouts_ when repacked
         vec<u32> vertexCounts_;
         vec<u32> indexElementCounts_;
+        vec<IndexElementSize> indexElementSizes_;
         u32 minVertexCount_ = 0;
 
         void updateMinVertexCount();
-        auto addVertexBuffer(VulkanBuffer &buffer, const VertexBufferLayout &layout, u32 vertexCount) -> s32;
+        auto addVertexBuffer(VulkanBuffer &buffer, const VertexBufferLayout &layout, const VertexBufferLayout &sourceLayout,
+            u32 vertexCount) -> s32;
     };
 }
 
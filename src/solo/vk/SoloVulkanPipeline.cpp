@@ -32,8 +32,8 @@ VulkanPipeline::VulkanPipeline(VkDevice device, VkRenderPass renderPass, const V
     layoutInfo.flags = 0;
     layoutInfo.setLayoutCount = config.descSetLayouts_.size();
     layoutInfo.pSetLayouts = config.descSetLayouts_.data();
-    layoutInfo.pushConstantRangeCount = 0;
-    layoutInfo.pPushConstantRanges = nullptr;
+    layoutInfo.pushConstantRangeCount = config.pushConstantRanges_.size();
+    layoutInfo.pPushConstantRanges = config.pushConstantRanges_.data();
 
     layout_ = VulkanResource<VkPipelineLayout>{device, vkDestroyPipelineLayout};
     SL_VK_CHECK_RESULT(vkCreatePipelineLayout(device, &layoutInfo, nullptr, layout_.cleanRef()));
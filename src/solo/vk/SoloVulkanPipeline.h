@@ -23,6 +23,7 @@ namespace solo
         auto withVertexAttribute(u32 location, u32 binding, VkFormat format, u32 offset) -> VulkanPipelineConfig&;
         auto withVertexBinding(u32 binding, u32 stride, VkVertexInputRate inputRate) -> VulkanPipelineConfig&;
         auto withDescriptorSetLayout(VkDescriptorSetLayout layout) -> VulkanPipelineConfig&;
+        auto withPushConstantRange(VkShaderStageFlags stages, u32 offset, u32 size) -> VulkanPipelineConfig&;
         auto withFrontFace(VkFrontFace frontFace) -> VulkanPipelineConfig&;
         auto withCullMode(VkCullModeFlags cullFlags) -> VulkanPipelineConfig&;
         auto withDepthTest(bool write, bool test) -> VulkanPipelineConfig&;
@@ -43,6 +44,7 @@ namespace solo
         vec<VkVertexInputAttributeDescription> vertexAttrs_;
         vec<VkVertexInputBindingDescription> vertexBindings_;
         vec<VkDescriptorSetLayout> descSetLayouts_;
+        vec<VkPushConstantRange> pushConstantRanges_;
 
         VkPrimitiveTopology topology_ = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST;
     };
@@ -87,6 +89,12 @@ namespace solo
         return *this;
     }
 
+    inline auto VulkanPipelineConfig::withPushConstantRange(VkShaderStageFlags stages, u32 offset, u32 size) -> VulkanPipelineConfig&
+    {
+        pushConstantRanges_.push_back({stages, offset, size});
+        return *this;
+    }
+
     inline auto VulkanPipelineConfig::withFrontFace(VkFrontFace frontFace) -> VulkanPipelineConfig&
     {
         rasterStateInfo_.frontFace = frontFace;
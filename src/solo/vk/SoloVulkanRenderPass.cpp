@@ -9,42 +9,26 @@
 
 using namespace solo;
 
-VulkanRenderPass::VulkanRenderPass(VkDevice device, const VulkanRenderPassConfig &config)
+static auto createRenderPass(VkDevice device, const vec<VkAttachmentDescription> &attachments,
+    const VkSubpassDescription &subpass) -> VulkanResource<VkRenderPass>
 {
-    const auto colorAttachments = config.colorAttachmentRefs_.empty() ? nullptr : config.colorAttachmentRefs_.data();
-    const auto depthAttachment = config.depthAttachmentRef_.layout != VK_IMAGE_LAYOUT_UNDEFINED ? &config.depthAttachmentRef_ : nullptr;
-    clearValues_.resize(config.colorAttachmentRefs_.size() + 1);
-    clearValues_.rbegin()->depthStencil = {1, 0};
-
-    colorAttachmentCount_ = config.colorAttachmentRefs_.size();
-
-    VkSubpassDescription subpass{};
-    subpass.pipelineBindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS;
-    subpass.flags = 0;
-    subpass.inputAttachmentCount = 0;
-    subpass.pInputAttachments = nullptr;
-    subpass.colorAttachmentCount = config.colorAttachmentRefs_.size();
-    subpass.pColorAttachments = colorAttachments;
-    subpass.pResolveAttachments = nullptr;
-    subpass.pDepthStencilAttachment = depthAttachment;
-    subpass.preserveAttachmentCount = 0;
-    subpass.pPreserveAttachments = nullptr;
-
     arr<VkSubpassDependency, 2> dependencies;
 
     dependencies[0].srcSubpass = VK_SUBPASS_EXTERNAL;
     dependencies[0].dstSubpass = 0;
     dependencies[0].srcStageMask = VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT;
-    dependencies[0].dstStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT;
+    dependencies[0].dstStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT |
+        VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT;
     dependencies[0].srcAccessMask = VK_ACCESS_MEMORY_READ_BIT | VK_ACCESS_SHADER_READ_BIT;
     dependencies[0].dstAccessMask = VK_ACCESS_COLOR_ATTACHMENT_READ_BIT | VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT |
         VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
     dependencies[0].dependencyFlags = VK_DEPENDENCY_BY_REGION_BIT;
 
+    // Attachments of render targets are sampled by later passes
     dependencies[1].srcSubpass = 0;
     dependencies[1].dstSubpass = VK_SUBPASS_EXTERNAL;
     dependencies[1].srcStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT;
-    dependencies[1].dstStageMask = VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT;
+    dependencies[1].dstStageMask = VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT | VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT;
     dependencies[1].srcAccessMask = VK_ACCESS_COLOR_ATTACHMENT_READ_BIT | VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT |
         VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
     dependencies[1].dstAccessMask = VK_ACCESS_MEMORY_READ_BIT | VK_ACCESS_SHADER_READ_BIT;
@@ -54,37 +38,52 @@ VulkanRenderPass::VulkanRenderPass(VkDevice device, const VulkanRenderPassConfig
     renderPassInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO;
     renderPassInfo.flags = 0;
     renderPassInfo.pNext = nullptr;
-    renderPassInfo.attachmentCount = config.attachments_.size();
-    renderPassInfo.pAttachments = config.attachments_.data();
+    renderPassInfo.attachmentCount = attachments.size();
+    renderPassInfo.pAttachments = attachments.data();
     renderPassInfo.subpassCount = 1;
     renderPassInfo.pSubpasses = &subpass;
     renderPassInfo.dependencyCount = dependencies.size();
     renderPassInfo.pDependencies = dependencies.data();
 
-    pass_ = VulkanResource<VkRenderPass>{device, vkDestroyRenderPass};
-    SL_VK_CHECK_RESULT(vkCreateRenderPass(device, &renderPassInfo, nullptr, pass_.cleanRef()));
-}
+    VulkanResource<VkRenderPass> pass{device, vkDestroyRenderPass};
+    SL_VK_CHECK_RESULT(vkCreateRenderPass(device, &renderPassInfo, nullptr, pass.cleanRef()));
 
-void VulkanRenderPass::begin(VkCommandBuffer cmdBuf, VkFramebuffer framebuffer, u32 canvasWidth, u32 canvasHeight)
-{
-    VkRenderPassBeginInfo info{};
-    info.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
-    info.pNext = nullptr;
-    info.renderPass = pass_;
-    info.renderArea.offset.x = 0;
-    info.renderArea.offset.y = 0;
-    info.renderArea.extent.width = canvasWidth;
-    info.renderArea.extent.height = canvasHeight;
-    info.clearValueCount = clearValues_.size();
-    info.pClearValues = clearValues_.data();
-    info.framebuffer = framebuffer;
-
-    vkCmdBeginRenderPass(cmdBuf, &info, VK_SUBPASS_CONTENTS_INLINE);
+    return pass;
 }
 
-void VulkanRenderPass::end(VkCommandBuffer cmdBuf)
+VulkanRenderPass::VulkanRenderPass(VkDevice device, const VulkanRenderPassConfig &config)
 {
-    vkCmdEndRenderPass(cmdBuf);
+    const auto colorAttachments = config.colorAttachmentRefs_.empty() ? nullptr : config.colorAttachmentRefs_.data();
+    const auto depthAttachment = config.depthAttachmentRef_.layout != VK_IMAGE_LAYOUT_UNDEFINED ? &config.depthAttachmentRef_ : nullptr;
+    clearValues_.resize(config.colorAttachmentRefs_.size() + 1);
+    clearValues_.rbegin()->depthStencil = {1, 0};
+
+    colorAttachmentCount_ = config.colorAttachmentRefs_.size();
+
+    VkSubpassDescription subpass{};
+    subpass.pipelineBindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS;
+    subpass.flags = 0;
+    subpass.inputAttachmentCount = 0;
+    subpass.pInputAttachments = nullptr;
+    subpass.colorAttachmentCount = config.colorAttachmentRefs_.size();
+    subpass.pColorAttachments = colorAttachments;
+    subpass.pResolveAttachments = nullptr;
+    subpass.pDepthStencilAttachment = depthAttachment;
+    subpass.preserveAttachmentCount = 0;
+    subpass.pPreserveAttachments = nullptr;
+
+    pass_ = createRenderPass(device, config.attachments_, subpass);
+
+    // Same pass but with color contents preserved. Load ops don't affect render pass compatibility,
+    // so framebuffers and pipelines created against one variant work with the other.
+    auto loadAttachments = config.attachments_;
+    for (const auto &ref: config.colorAttachmentRefs_)
+    {
+        auto &desc = loadAttachments[ref.attachment];
+        desc.loadOp = VK_ATTACHMENT_LOAD_OP_LOAD;
+        desc.initialLayout = desc.finalLayout;
+    }
+    loadPass_ = createRenderPass(device, loadAttachments, subpass);
 }
 
 VulkanRenderPassConfig::VulkanRenderPassConfig():
@@ -99,7 +98,7 @@ auto VulkanRenderPassConfig::addColorAttachment(VkFormat format, VkImageLayout f
     desc.format = format;
     desc.flags = 0;
     desc.samples = VK_SAMPLE_COUNT_1_BIT;
-    desc.loadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+    desc.loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
     desc.storeOp = VK_ATTACHMENT_STORE_OP_STORE;
     desc.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
     desc.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
@@ -109,28 +108,37 @@ auto VulkanRenderPassConfig::addColorAttachment(VkFormat format, VkImageLayout f
 
     VkAttachmentReference reference{};
     reference.attachment = attachments_.size() - 1;
-    reference.layout = VK_IMAGE_LAYOUT_GENERAL; // TODO better
+    reference.layout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
     colorAttachmentRefs_.push_back(reference);
 
     return *this;
 }
 
-auto VulkanRenderPassConfig::setDepthAttachment(VkFormat format) -> VulkanRenderPassConfig&
+auto VulkanRenderPassConfig::setDepthAttachment(VkFormat format, bool preserveContents) -> VulkanRenderPassConfig&
 {
     VkAttachmentDescription desc{};
     desc.format = format;
     desc.flags = 0;
     desc.samples = VK_SAMPLE_COUNT_1_BIT;
     desc.loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
-    desc.storeOp = VK_ATTACHMENT_STORE_OP_STORE;
     desc.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
     desc.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
     desc.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
-    desc.finalLayout = VK_IMAGE_LAYOUT_GENERAL; // TODO better
+    // Depth is always cleared on load, so unless someone samples it afterwards there's no need to write it back
+    if (preserveContents)
+    {
+        desc.storeOp = VK_ATTACHMENT_STORE_OP_STORE;
+        desc.finalLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+    }
+    else
+    {
+        desc.storeOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+        desc.finalLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+    }
     attachments_.push_back(desc);
 
     depthAttachmentRef_.attachment = attachments_.size() - 1;
-    depthAttachmentRef_.layout = VK_IMAGE_LAYOUT_GENERAL; // TODO better
+    depthAttachmentRef_.layout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
 
     return *this;
 }
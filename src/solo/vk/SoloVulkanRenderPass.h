@@ -19,7 +19,7 @@ namespace solo
         VulkanRenderPassConfig();
 
         auto addColorAttachment(VkFormat colorFormat, VkImageLayout finalLayout) -> VulkanRenderPassConfig&;
-        auto setDepthAttachment(VkFormat depthFormat) -> VulkanRenderPassConfig&;
+        auto setDepthAttachment(VkFormat depthFormat, bool preserveContents) -> VulkanRenderPassConfig&;
 
     private:
         friend class VulkanRenderPass;
@@ -41,8 +41,8 @@ namespace solo
         auto clearValues() const -> const vec<VkClearValue>& { return clearValues_; }
         auto colorAttachmentCount() const -> u32 { return colorAttachmentCount_; }
 
-        void begin(VkCommandBuffer cmdBuf, VkFramebuffer framebuffer, u32 canvasWidth, u32 canvasHeight);
-        void end(VkCommandBuffer cmdBuf);
+        // Variant to begin with. Both are compatible with framebuffers and pipelines created against this pass.
+        auto handle(bool clearColor) const -> VkRenderPass { return clearColor ? pass_ : loadPass_; }
 
         auto operator=(const VulkanRenderPass &other) -> VulkanRenderPass& = delete;
         auto operator=(VulkanRenderPass &&other) -> VulkanRenderPass& = default;
@@ -52,6 +52,7 @@ namespace solo
 
     private:
         VulkanResource<VkRenderPass> pass_;
+        VulkanResource<VkRenderPass> loadPass_;
         vec<VkClearValue> clearValues_;
         u32 colorAttachmentCount_ = 0;
     };
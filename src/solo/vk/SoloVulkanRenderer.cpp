@@ -15,18 +15,26 @@
 #include "SoloVulkanMesh.h"
 #include "SoloVulkanEffect.h"
 #include "SoloVulkanTexture.h"
+#include "SoloVulkanUploader.h"
 #include "SoloCamera.h"
+#include "SoloTransform.h"
+#include "SoloWorkerPool.h"
+#include <algorithm>
 
 using namespace solo;
 
-static auto genPipelineContextKey(Transform *transform, Camera *camera, VulkanMaterial *material, VkRenderPass renderPass)
+static auto genPipelineContextKey(Transform *transform, Camera *camera, VulkanMaterial *material, VulkanMesh *mesh,
+    VkRenderPass renderPass)
 {
     size_t seed = 0;
     const std::hash<void*> hasher;
-    combineHash(seed, hasher(transform));
+    // Materials that deliver per-object data via push constants share one context between all objects
+    if (material->hasPerObjectBufferItems())
+        combineHash(seed, hasher(transform));
     combineHash(seed, hasher(material));
     combineHash(seed, hasher(camera));
     combineHash(seed, hasher(renderPass));
+    combineHash(seed, mesh->layoutHash());
     return seed;
 }
 
@@ -41,63 +49,97 @@ VulkanRenderer::VulkanRenderer(Device *engineDevice):
     device_ = VulkanDevice(instance, surface);
     swapchain_ = VulkanSwapchain(device_, static_cast<u32>(
         canvasSize.x()), static_cast<u32>(canvasSize.y()), engineDevice->isVsync());
+    descPool_ = VulkanDescriptorPool(device_, 64);
+
+    // Each recording worker gets its own pool because pools can't be used from several threads at once
+    const auto recordingThreadCount = engineDevice->renderThreadCount();
+    if (recordingThreadCount > 1)
+    {
+        for (u32 i = 0; i < recordingThreadCount; i++)
+            recordingCmdPools_.push_back(vk::createCommandPool(device_, device_.queueIndex()));
+    }
 }
 
-void VulkanRenderer::beginCamera(Camera *camera, FrameBuffer *renderTarget)
+void VulkanRenderer::onBeginCamera(Camera *camera, FrameBuffer *renderTarget)
 {
     currentCamera_ = camera;
     currentRenderPass_ = &swapchain_.renderPass();
+    currentFrameBuffer_ = swapchain_.currentFrameBuffer();
+    currentPipelineContextKey_ = 0;
+    boundPipelineContextKey_ = 0;
+    drawCalls_.clear();
+    pushConstantsData_.clear();
+    // Previous camera has finished executing by now, so instance data can be overwritten
+    for (auto &chunk: instanceChunks_)
+        chunk.used = 0;
     
-    auto currentFrameBuffer = swapchain_.currentFrameBuffer();
     auto dimensions = engineDevice_->canvasSize();
 
     if (renderTarget)
     {
         const auto targetFrameBuffer = static_cast<VulkanFrameBuffer*>(renderTarget);
         currentRenderPass_ = &targetFrameBuffer->renderPass();
-        currentFrameBuffer = targetFrameBuffer->handle();
+        currentFrameBuffer_ = targetFrameBuffer->handle();
         dimensions = targetFrameBuffer->dimensions();
     }
 
+    // Cached so that recording threads don't need to touch the camera
+    currentDimensions_ = dimensions;
+    currentViewport_ = currentCamera_->viewport();
+    const auto clearColor = currentCamera_->clearColor();
+    currentClearColor_ = {{clearColor.x(), clearColor.y(), clearColor.z(), clearColor.w()}};
+    currentColorClearing_ = currentCamera_->hasColorClearing();
+
     if (!renderPassContexts_.count(currentRenderPass_))
     {
-        renderPassContexts_[currentRenderPass_].cmdBuf = VulkanCmdBuffer(device_);
-        renderPassContexts_[currentRenderPass_].completeSemaphore = vk::createSemaphore(device_);
+        auto &ctx = renderPassContexts_[currentRenderPass_];
+        ctx.cmdBuf = VulkanCmdBuffer(device_);
+        ctx.completeSemaphore = vk::createSemaphore(device_);
+        for (const auto &pool: recordingCmdPools_)
+            ctx.secondaryCmdBufs.emplace_back(device_.handle(), pool, VK_COMMAND_BUFFER_LEVEL_SECONDARY);
     }
 
     auto &passContext = renderPassContexts_.at(currentRenderPass_);
     passContext.frameOfLastUse = frame_;
     
     currentCmdBuffer_ = &passContext.cmdBuf;
-    currentCmdBuffer_->begin(false);
 
-    currentCmdBuffer_->beginRenderPass(*currentRenderPass_, currentFrameBuffer,
-        static_cast<u32>(dimensions.x()), static_cast<u32>(dimensions.y()));
-
-    if (currentCamera_->hasColorClearing())
+    // When recording in parallel the primary buffer is recorded at the end of the camera, when all draws are known
+    if (!isRecordingInParallel())
     {
-        const VkClearRect clearRect{{{0, 0}, {static_cast<u32>(dimensions.x()), static_cast<u32>(dimensions.y())}}, 0, 1};
-        auto clearColor = currentCamera_->clearColor();
-        const VkClearValue clearValue{{clearColor.x(), clearColor.y(), clearColor.z(), clearColor.w()}};
-        const auto clearCount = renderTarget
-            ? static_cast<VulkanFrameBuffer*>(renderTarget)->colorAttachmentCount()
-            : 1;
-        for (u32 i = 0; i < clearCount; i++)
-            currentCmdBuffer_->clearColorAttachment(i, clearValue, clearRect);
+        currentCmdBuffer_->begin(false);
+        currentCmdBuffer_->beginRenderPass(*currentRenderPass_, currentFrameBuffer_,
+            static_cast<u32>(dimensions.x()), static_cast<u32>(dimensions.y()), currentClearColor());
+        recordCameraSetup(*currentCmdBuffer_);
     }
-
-    const auto viewport = currentCamera_->viewport();
-    currentCmdBuffer_->setViewport(viewport, 0, 1);
-    currentCmdBuffer_->setScissor(viewport);
 }
 
-void VulkanRenderer::endCamera(Camera *camera, FrameBuffer *renderTarget)
+void VulkanRenderer::onEndCamera(Camera *camera, FrameBuffer *renderTarget)
 {
     auto &ctx = renderPassContexts_.at(currentRenderPass_);
+
+    if (isRecordingInParallel())
+    {
+        ctx.cmdBuf.begin(false);
+        ctx.cmdBuf.beginRenderPass(*currentRenderPass_, currentFrameBuffer_,
+            static_cast<u32>(currentDimensions_.x()), static_cast<u32>(currentDimensions_.y()),
+            currentClearColor(), VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS);
+        recordDrawCallsInParallel(ctx);
+    }
+
     ctx.cmdBuf.endRenderPass();
     ctx.cmdBuf.end();
 
-    vk::queueSubmit(device_.queue(), 1, &prevSemaphore_, 1, &ctx.completeSemaphore, 1, ctx.cmdBuf);
+    // Resources created since the previous camera must be fully uploaded before drawing with them
+    const auto uploadSemaphore = device_.uploader().flush();
+    if (uploadSemaphore)
+    {
+        const VkSemaphore waitSemaphores[] = {prevSemaphore_, uploadSemaphore};
+        const VkPipelineStageFlags waitStages[] = {VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT};
+        vk::queueSubmit(device_.queue(), 2, waitSemaphores, 1, &ctx.completeSemaphore, 1, ctx.cmdBuf, waitStages);
+    }
+    else
+        vk::queueSubmit(device_.queue(), 1, &prevSemaphore_, 1, &ctx.completeSemaphore, 1, ctx.cmdBuf);
     SL_VK_CHECK_RESULT(vkQueueWaitIdle(device_.queue()));
 
     prevSemaphore_ = ctx.completeSemaphore;
@@ -105,31 +147,69 @@ void VulkanRenderer::endCamera(Camera *camera, FrameBuffer *renderTarget)
     currentCamera_ = nullptr;
 }
 
-void VulkanRenderer::drawMesh(Mesh *mesh, Transform *transform, Material *material)
+void VulkanRenderer::onDrawMesh(Mesh *mesh, Transform *transform, Material *material)
 {
-    const auto vkMesh = static_cast<VulkanMesh*>(mesh);
-    bindPipelineAndMesh(material, transform, mesh);
+    const auto call = prepareDrawCall(static_cast<VulkanMesh*>(mesh), -1, transform, static_cast<VulkanMaterial*>(material));
+    if (isRecordingInParallel())
+        drawCalls_.push_back(call);
+    else
+        recordDrawCall(*currentCmdBuffer_, call, boundPipelineContextKey_);
+}
+
+void VulkanRenderer::onDrawMeshPart(Mesh *mesh, u32 part, Transform *transform, Material *material)
+{
+    const auto call = prepareDrawCall(static_cast<VulkanMesh*>(mesh), static_cast<s32>(part), transform,
+        static_cast<VulkanMaterial*>(material));
+    if (isRecordingInParallel())
+        drawCalls_.push_back(call);
+    else
+        recordDrawCall(*currentCmdBuffer_, call, boundPipelineContextKey_);
+}
+
+void VulkanRenderer::onDrawMeshInstanced(Mesh *mesh, s32 part, Material *material, Transform *const *transforms, u32 count)
+{
+    auto call = prepareDrawCall(static_cast<VulkanMesh*>(mesh), part, transforms[0], static_cast<VulkanMaterial*>(material));
 
-    if (vkMesh->partCount())
+    instanceData_.resize(count * 16);
+    for (u32 i = 0; i < count; i++)
     {
-        for (u32 part = 0; part < vkMesh->partCount(); part++)
-        {
-            const auto indexBuffer = vkMesh->partBuffer(part);
-            currentCmdBuffer_->bindIndexBuffer(indexBuffer, 0, VK_INDEX_TYPE_UINT32); // TODO 16-bit index support?
-            currentCmdBuffer_->drawIndexed(vkMesh->partIndexElementCount(part), 1, 0, 0, 0);
-        }
+        const auto columns = transforms[i]->worldMatrix().columns();
+        std::copy(columns, columns + 16, instanceData_.data() + i * 16);
     }
+
+    auto &chunk = allocateInstances(count);
+    const auto matrixSize = static_cast<u32>(16 * sizeof(float));
+    chunk.buffer.updatePart(instanceData_.data(), chunk.used * matrixSize, count * matrixSize);
+
+    call.instanceBuffer = chunk.buffer;
+    call.firstInstance = chunk.used;
+    call.instanceCount = count;
+    chunk.used += count;
+
+    if (isRecordingInParallel())
+        drawCalls_.push_back(call);
     else
-        currentCmdBuffer_->draw(vkMesh->minVertexCount(), 1, 0, 0);
+        recordDrawCall(*currentCmdBuffer_, call, boundPipelineContextKey_);
 }
 
-void VulkanRenderer::drawMeshPart(Mesh *mesh, u32 part, Transform *transform, Material *material)
+auto VulkanRenderer::allocateInstances(u32 count) -> InstanceBufferChunk&
 {
-    const auto vkMesh = static_cast<VulkanMesh*>(mesh);
-    bindPipelineAndMesh(material, transform, mesh);
-    const auto indexBuffer = vkMesh->partBuffer(part);
-    currentCmdBuffer_->bindIndexBuffer(indexBuffer, 0, VK_INDEX_TYPE_UINT32); // TODO 16-bit index support?
-    currentCmdBuffer_->drawIndexed(vkMesh->partIndexElementCount(part), 1, 0, 0, 0);
+    static const u32 minChunkCapacity = 4096;
+
+    for (auto &chunk: instanceChunks_)
+    {
+        if (chunk.capacity - chunk.used >= count)
+            return chunk;
+    }
+
+    // Existing chunks may still be referenced by recorded draws, so a new one is added rather than any of them grown
+    const auto capacity = std::max(count, minChunkCapacity);
+    InstanceBufferChunk chunk;
+    chunk.buffer = VulkanBuffer(device_, capacity * 16 * sizeof(float), VK_BUFFER_USAGE_VERTEX_BUFFER_BIT,
+        VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+    chunk.capacity = capacity;
+    instanceChunks_.push_back(std::move(chunk));
+    return instanceChunks_.back();
 }
 
 auto VulkanRenderer::ensurePipelineContext(Transform *transform, VulkanMaterial *material, VulkanMesh *mesh) -> PipelineContext&
@@ -138,7 +218,7 @@ auto VulkanRenderer::ensurePipelineContext(Transform *transform, VulkanMaterial
     const auto vkEffect = static_cast<VulkanEffect*>(vkMaterial->effect().get());
     const auto vkMesh = static_cast<VulkanMesh*>(mesh);
 
-    const auto key = genPipelineContextKey(transform, currentCamera_, material, *currentRenderPass_);
+    const auto key = genPipelineContextKey(transform, currentCamera_, material, mesh, *currentRenderPass_);
     auto &context = pipelineContexts_[key];
     context.key = key;
 
@@ -160,6 +240,7 @@ auto VulkanRenderer::ensurePipelineContext(Transform *transform, VulkanMaterial
             cfg.addSampler(pair.second.binding);
 
         context.descSet = VulkanDescriptorSet(device_, cfg);
+        context.descSet.allocate(descPool_);
     }
 
     const auto materialFlagsHash = vkMaterial->stateHash();
@@ -173,6 +254,9 @@ auto VulkanRenderer::ensurePipelineContext(Transform *transform, VulkanMaterial
             .withDescriptorSetLayout(context.descSet.layout())
             .withFrontFace(VK_FRONT_FACE_COUNTER_CLOCKWISE)
             .withColorBlendAttachmentCount(currentRenderPass_->colorAttachmentCount());
+
+        if (vkEffect->hasPushConstants())
+            pipelineConfig.withPushConstantRange(vkEffect->pushConstantStages(), 0, vkEffect->pushConstantBuffer().size);
         
         vkMaterial->configurePipeline(pipelineConfig);
         vkMesh->configurePipeline(pipelineConfig, vkEffect);
@@ -185,22 +269,19 @@ auto VulkanRenderer::ensurePipelineContext(Transform *transform, VulkanMaterial
     return context;
 }
 
-void VulkanRenderer::bindPipelineAndMesh(Material *material, Transform *transform, Mesh *mesh)
+auto VulkanRenderer::prepareDrawCall(VulkanMesh *mesh, s32 part, Transform *transform, VulkanMaterial *material)
+    -> DrawCall
 {
-    const auto vkMaterial = static_cast<VulkanMaterial*>(material);
-    const auto vkEffect = static_cast<VulkanEffect*>(vkMaterial->effect().get());
-    const auto vkMesh = static_cast<VulkanMesh*>(mesh);
+    const auto vkEffect = static_cast<VulkanEffect*>(material->effect().get());
     const auto &uniformBufs = vkEffect->uniformBuffers();
-    const auto &materialSamplers = vkMaterial->samplers();
+    const auto &materialSamplers = material->samplers();
     
-    auto &context = ensurePipelineContext(transform, vkMaterial, vkMesh);
+    auto &context = ensurePipelineContext(transform, material, mesh);
     context.frameOfLastUse = frame_;
 
     if (currentPipelineContextKey_ != context.key)
     {
-        // TODO Run set updater not so often - only when something really changes
-
-        // TODO Not necessary (?), buffers don't change anyway, only their content
+        // The set only stages bindings that differ from what it already has, so this is cheap when nothing changed
         for (auto &pair : context.uniformBuffers)
         {
             const auto &info = uniformBufs.at(pair.first);
@@ -218,26 +299,121 @@ void VulkanRenderer::bindPipelineAndMesh(Material *material, Transform *transfor
                 info.texture->image().layout());
         }
 
+        context.descSet.commitUpdates();
+
         // Update buffers content
         // TODO This could probably be done outside of this big "if ()" as it should not count as DescriptorSet change?
 
-        auto &bufferItems = vkMaterial->bufferItems();
-        for (auto &p : bufferItems)
-        {
-            auto &buffer = context.uniformBuffers[p.first];
-            for (auto &pp : p.second)
-                pp.second.write(buffer, currentCamera_, transform);
-        }
-
-        currentCmdBuffer_->bindPipeline(context.pipeline);
-        currentCmdBuffer_->bindDescriptorSet(context.pipeline.layout(), context.descSet);
+        material->updateUniformBuffers(context.uniformBuffers, currentCamera_, transform);
 
         currentPipelineContextKey_ = context.key;
     }
 
+    DrawCall call;
+    call.mesh = mesh;
+    call.part = part;
+    call.context = &context;
+
+    if (vkEffect->hasPushConstants())
+    {
+        // Copy push constants aside because the material reuses its buffer for the next object
+        material->updatePushConstants(currentCamera_, transform);
+        const auto &data = material->pushConstantData();
+        call.pushConstantsOffset = static_cast<u32>(pushConstantsData_.size());
+        call.pushConstantsSize = static_cast<u32>(data.size());
+        call.pushConstantStages = vkEffect->pushConstantStages();
+        pushConstantsData_.insert(pushConstantsData_.end(), data.begin(), data.end());
+    }
+
+    return call;
+}
+
+void VulkanRenderer::recordDrawCall(VulkanCmdBuffer &buf, const DrawCall &call, size_t &boundContextKey) const
+{
+    const auto context = call.context;
+    const auto mesh = call.mesh;
+
+    if (boundContextKey != context->key)
+    {
+        buf.bindPipeline(context->pipeline.handle());
+        buf.bindDescriptorSet(context->pipeline.layout(), context->descSet);
+        boundContextKey = context->key;
+    }
+
+    if (call.pushConstantsSize)
+    {
+        buf.pushConstants(context->pipeline.layout(), call.pushConstantStages,
+            0, call.pushConstantsSize, pushConstantsData_.data() + call.pushConstantsOffset);
+    }
+
     // TODO don't rebind an already bound mesh (for instance when we draw mesh parts)
-    for (u32 i = 0; i < vkMesh->vertexBufferCount(); i++)
-        currentCmdBuffer_->bindVertexBuffer(i, vkMesh->vertexBuffer(i));
+    for (u32 i = 0; i < mesh->vertexBufferCount(); i++)
+        buf.bindVertexBuffer(i, mesh->vertexBuffer(i));
+    if (call.instanceBuffer)
+        buf.bindVertexBuffer(mesh->vertexBufferCount(), call.instanceBuffer);
+
+    if (call.part >= 0)
+    {
+        const auto part = static_cast<u32>(call.part);
+        buf.bindIndexBuffer(mesh->partBuffer(part), 0, mesh->partIndexType(part));
+        buf.drawIndexed(mesh->partIndexElementCount(part), call.instanceCount, 0, 0, call.firstInstance);
+    }
+    else if (mesh->partCount())
+    {
+        for (u32 part = 0; part < mesh->partCount(); part++)
+        {
+            buf.bindIndexBuffer(mesh->partBuffer(part), 0, mesh->partIndexType(part));
+            buf.drawIndexed(mesh->partIndexElementCount(part), call.instanceCount, 0, 0, call.firstInstance);
+        }
+    }
+    else
+        buf.draw(mesh->minVertexCount(), call.instanceCount, 0, call.firstInstance);
+}
+
+auto VulkanRenderer::currentClearColor() const -> const VkClearColorValue*
+{
+    // Clearing is done by the render pass load op, so the attachments are never read back just to be overwritten
+    return currentColorClearing_ ? &currentClearColor_ : nullptr;
+}
+
+void VulkanRenderer::recordCameraSetup(VulkanCmdBuffer &buf) const
+{
+    buf.setViewport(currentViewport_, 0, 1);
+    buf.setScissor(currentViewport_);
+}
+
+void VulkanRenderer::recordDrawCallsInParallel(RenderPassContext &ctx)
+{
+    // Small batches aren't worth waking up a thread for
+    static const u32 minDrawCallsPerThread = 64;
+
+    const auto drawCallCount = static_cast<u32>(drawCalls_.size());
+    const auto threadCount = std::max(1u, std::min(static_cast<u32>(recordingCmdPools_.size()),
+        (drawCallCount + minDrawCallsPerThread - 1) / minDrawCallsPerThread));
+    const auto drawCallsPerThread = (drawCallCount + threadCount - 1) / threadCount;
+
+    auto record = [this, &ctx, drawCallCount, drawCallsPerThread](u32 thread)
+    {
+        auto &buf = ctx.secondaryCmdBufs[thread];
+        const auto first = thread * drawCallsPerThread;
+        const auto last = std::min(first + drawCallsPerThread, drawCallCount);
+        size_t boundContextKey = 0;
+
+        buf.beginSecondary(*currentRenderPass_, currentFrameBuffer_);
+        recordCameraSetup(buf);
+        for (auto i = first; i < last; i++)
+            recordDrawCall(buf, drawCalls_[i], boundContextKey);
+        buf.end();
+    };
+
+    // Workers persist between passes, and worker i always records into the buffer of pool i
+    engineDevice_->renderWorkers()->run(threadCount, record);
+
+    // Secondary buffers run in the same order as the draw calls were issued
+    vec<VkCommandBuffer> buffers;
+    for (u32 thread = 0; thread < threadCount; thread++)
+        buffers.push_back(ctx.secondaryCmdBufs[thread].handle());
+    ctx.cmdBuf.executeCommands(threadCount, buffers.data());
 }
 
 void VulkanRenderer::beginFrame()
@@ -246,7 +422,9 @@ void VulkanRenderer::beginFrame()
     currentCamera_ = nullptr;
     currentRenderPass_ = nullptr;
     currentCmdBuffer_ = nullptr;
+    currentFrameBuffer_ = VK_NULL_HANDLE;
     currentPipelineContextKey_ = 0;
+    boundPipelineContextKey_ = 0;
     prevSemaphore_ = swapchain_.moveNext();
 }
 
@@ -260,6 +438,7 @@ void VulkanRenderer::endFrame()
     {
         cleanupUnusedPipelineContexts();
         cleanupUnusedRenderPassContexts();
+        recycleDescriptorSets();
     }
 }
 
@@ -307,4 +486,13 @@ void VulkanRenderer::cleanupUnusedPipelineContexts()
     while (removed);
 }
 
+void VulkanRenderer::recycleDescriptorSets()
+{
+    // Sets of removed contexts are not freed individually, so reclaim them by resetting the whole pool.
+    // The queue is idle at this point, and surviving contexts simply get fresh sets that are rewritten on next use.
+    descPool_.reset();
+    for (auto &p: pipelineContexts_)
+        p.second.descSet.allocate(descPool_);
+}
+
 #endif
@@ -15,8 +15,11 @@
 #include "SoloVulkan.h"
 #include "SoloVulkanBuffer.h"
 #include "SoloVulkanDescriptorSet.h"
+#include "SoloVulkanDescriptorPool.h"
 #include "SoloVulkanCmdBuffer.h"
 #include "SoloVulkanDevice.h"
+#include "SoloVector2.h"
+#include "SoloVector4.h"
 
 namespace solo
 {
@@ -31,11 +34,6 @@ namespace solo
         explicit VulkanRenderer(Device *device);
         ~VulkanRenderer() = default;
 
-        void beginCamera(Camera *camera, FrameBuffer *renderTarget) override final;
-        void endCamera(Camera *camera, FrameBuffer *renderTarget) override final;
-        void drawMesh(Mesh *mesh, Transform *transform, Material *material) override final;
-        void drawMeshPart(Mesh *mesh, u32 part, Transform *transform, Material *material) override final;
-
         auto name() const -> const char* override final { return "Vulkan"; }
         auto gpuName() const -> const char* override final { return device_.gpuName(); }
 
@@ -45,11 +43,18 @@ namespace solo
         void beginFrame() override final;
         void endFrame() override final;
 
+        void onBeginCamera(Camera *camera, FrameBuffer *renderTarget) override final;
+        void onEndCamera(Camera *camera, FrameBuffer *renderTarget) override final;
+        void onDrawMesh(Mesh *mesh, Transform *transform, Material *material) override final;
+        void onDrawMeshPart(Mesh *mesh, u32 part, Transform *transform, Material *material) override final;
+        void onDrawMeshInstanced(Mesh *mesh, s32 part, Material *material, Transform *const *transforms, u32 count) override final;
+
     private:
         Device *engineDevice_ = nullptr;
 
         VulkanDevice device_;
         VulkanSwapchain swapchain_;
+        VulkanDescriptorPool descPool_;
 
         struct PipelineContext
         {
@@ -66,25 +71,67 @@ namespace solo
         {
             VulkanResource<VkSemaphore> completeSemaphore;
             VulkanCmdBuffer cmdBuf;
+            vec<VulkanCmdBuffer> secondaryCmdBufs; // one per recording worker
             VulkanRenderPass *renderPass = nullptr;
             u32 frameOfLastUse = 0;
         };
 
+        struct DrawCall
+        {
+            VulkanMesh *mesh = nullptr;
+            PipelineContext *context = nullptr;
+            s32 part = -1; // whole mesh if negative
+            u32 pushConstantsOffset = 0;
+            u32 pushConstantsSize = 0;
+            VkShaderStageFlags pushConstantStages = 0;
+            VkBuffer instanceBuffer = VK_NULL_HANDLE; // not instanced if null
+            u32 firstInstance = 0;
+            u32 instanceCount = 1;
+        };
+
+        // Host-visible vertex buffer holding instance world matrices of the current camera
+        struct InstanceBufferChunk
+        {
+            VulkanBuffer buffer;
+            u32 capacity = 0;
+            u32 used = 0;
+        };
+
         u32 frame_ = 0;
 
+        vec<VulkanResource<VkCommandPool>> recordingCmdPools_;
         umap<VulkanRenderPass*, RenderPassContext> renderPassContexts_;
         umap<size_t, PipelineContext> pipelineContexts_;
 
+        vec<DrawCall> drawCalls_;
+        vec<u8> pushConstantsData_;
+        vec<InstanceBufferChunk> instanceChunks_;
+        vec<float> instanceData_;
+
         Camera *currentCamera_ = nullptr;
         VulkanRenderPass *currentRenderPass_ = nullptr;
+        VkFramebuffer currentFrameBuffer_ = VK_NULL_HANDLE;
+        Vector2 currentDimensions_;
+        Vector4 currentViewport_;
+        VkClearColorValue currentClearColor_{};
+        bool currentColorClearing_ = false;
         VulkanCmdBuffer *currentCmdBuffer_ = nullptr;
         VkSemaphore prevSemaphore_ = nullptr;
         size_t currentPipelineContextKey_ = 0;
+        size_t boundPipelineContextKey_ = 0;
+
+        bool isRecordingInParallel() const { return !recordingCmdPools_.empty(); }
 
-        void bindPipelineAndMesh(Material *material, Transform *transform, Mesh *mesh);
+        auto prepareDrawCall(VulkanMesh *mesh, s32 part, Transform *transform, VulkanMaterial *material) -> DrawCall;
+        void recordDrawCall(VulkanCmdBuffer &buf, const DrawCall &call, size_t &boundContextKey) const;
+        auto allocateInstances(u32 count) -> InstanceBufferChunk&;
+        void recordCameraSetup(VulkanCmdBuffer &buf) const;
+        auto currentClearColor() const -> const VkClearColorValue*;
+        void recordDrawCallsInParallel(RenderPassContext &ctx);
         auto ensurePipelineContext(Transform *transform, VulkanMaterial *material, VulkanMesh *mesh) -> PipelineContext&;
         void cleanupUnusedRenderPassContexts();
         void cleanupUnusedPipelineContexts();
+        void recycleDescriptorSets();
     };
 }
 
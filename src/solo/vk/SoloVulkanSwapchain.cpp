@@ -108,7 +108,7 @@ VulkanSwapchain::VulkanSwapchain(const VulkanDevice &dev, u32 width, u32 height,
 
     renderPass_ = VulkanRenderPass(this->device_, VulkanRenderPassConfig()
         .addColorAttachment(colorFormat, VK_IMAGE_LAYOUT_PRESENT_SRC_KHR)
-        .setDepthAttachment(depthFormat));
+        .setDepthAttachment(depthFormat, false));
     
     depthStencil_ = VulkanImage::swapchainDepthStencil(dev, width, height, depthFormat);
 
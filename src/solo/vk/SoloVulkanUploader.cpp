@@ -0,0 +1,265 @@
+/* 
+ * Copyright (c) Aleksey Fedotov 
+ * MIT license 
+ */
+
+#include "SoloVulkanUploader.h"
+
+#ifdef SL_VULKAN_RENDERER
+
+#include <cstring>
+#include <algorithm>
+
+using namespace solo;
+
+static const VkDeviceSize ringSize = 32 * 1024 * 1024;
+
+static auto alignUp(u64 value, u64 alignment) -> u64
+{
+    return (value + alignment - 1) / alignment * alignment;
+}
+
+static auto createFence(VkDevice device) -> VulkanResource<VkFence>
+{
+    VkFenceCreateInfo info{};
+    info.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
+
+    VulkanResource<VkFence> fence{device, vkDestroyFence};
+    SL_VK_CHECK_RESULT(vkCreateFence(device, &info, nullptr, fence.cleanRef()));
+
+    return fence;
+}
+
+VulkanUploader::VulkanUploader(VkDevice device, VkPhysicalDeviceMemoryProperties memProps, VkDeviceSize alignment,
+    VkQueue graphicsQueue, u32 graphicsQueueIndex, VkQueue transferQueue, u32 transferQueueIndex):
+    device_(device),
+    memProps_(memProps),
+    alignment_((std::max)(alignment, static_cast<VkDeviceSize>(16))),
+    graphicsQueue_(graphicsQueue),
+    transferQueue_(transferQueue),
+    graphicsQueueIndex_(graphicsQueueIndex),
+    transferQueueIndex_(transferQueueIndex),
+    ringSize_(ringSize)
+{
+    graphicsCmdPool_ = vk::createCommandPool(device, graphicsQueueIndex);
+    transferCmdPool_ = vk::createCommandPool(device, transferQueueIndex);
+    ringData_ = createHostVisibleBuffer(ringSize_, ringBuffer_, ringMemory_);
+}
+
+VulkanUploader::~VulkanUploader()
+{
+    if (!inFlight_.empty())
+    {
+        SL_VK_CHECK_RESULT(vkQueueWaitIdle(transferQueue_));
+        SL_VK_CHECK_RESULT(vkQueueWaitIdle(graphicsQueue_));
+    }
+}
+
+auto VulkanUploader::stage(VkDeviceSize size) -> Staging
+{
+    // Large uploads would hog the ring, they get their own buffers instead
+    if (size > ringSize_ / 2)
+        return stageDedicated(size);
+
+    makeRingSpace(size);
+
+    const auto start = ringHead_ - size;
+    const auto offset = static_cast<VkDeviceSize>(start % ringSize_);
+    return {ringBuffer_, offset, ringData_ + offset};
+}
+
+auto VulkanUploader::transferCmdBuffer() -> VulkanCmdBuffer&
+{
+    auto &batch = currentBatch();
+    if (!batch.transferUsed)
+    {
+        batch.transferCmdBuf.begin(true);
+        batch.transferUsed = true;
+    }
+    return batch.transferCmdBuf;
+}
+
+auto VulkanUploader::graphicsCmdBuffer() -> VulkanCmdBuffer&
+{
+    auto &batch = currentBatch();
+    if (!batch.graphicsUsed)
+    {
+        batch.graphicsCmdBuf.begin(true);
+        batch.graphicsUsed = true;
+    }
+    return batch.graphicsCmdBuf;
+}
+
+void VulkanUploader::uploadBuffer(const void *data, VkDeviceSize size, VkBuffer dst)
+{
+    const auto staging = stage(size);
+    std::memcpy(staging.data, data, size);
+
+    VkBufferCopy region{};
+    region.srcOffset = staging.offset;
+    region.dstOffset = 0;
+    region.size = size;
+    transferCmdBuffer().copyBuffer(staging.buffer, dst, region);
+}
+
+auto VulkanUploader::flush() -> VkSemaphore
+{
+    retire(false);
+
+    if (!current_ || (!current_->transferUsed && !current_->graphicsUsed))
+        return VK_NULL_HANDLE;
+
+    submit(*current_, true);
+    const VkSemaphore semaphore = current_->completeSemaphore;
+    inFlight_.push_back(std::move(current_));
+
+    return semaphore;
+}
+
+auto VulkanUploader::currentBatch() -> Batch&
+{
+    if (current_)
+        return *current_;
+
+    if (!free_.empty())
+    {
+        current_ = std::move(free_.back());
+        free_.pop_back();
+        return *current_;
+    }
+
+    current_ = std::make_unique<Batch>();
+    current_->transferCmdBuf = VulkanCmdBuffer(device_, transferCmdPool_, VK_COMMAND_BUFFER_LEVEL_PRIMARY);
+    current_->graphicsCmdBuf = VulkanCmdBuffer(device_, graphicsCmdPool_, VK_COMMAND_BUFFER_LEVEL_PRIMARY);
+    current_->transferCompleteSemaphore = vk::createSemaphore(device_);
+    current_->completeSemaphore = vk::createSemaphore(device_);
+    current_->fence = createFence(device_);
+
+    return *current_;
+}
+
+void VulkanUploader::submit(Batch &batch, bool signal)
+{
+    const auto signalCount = signal ? 1u : 0u;
+
+    if (batch.transferUsed)
+        batch.transferCmdBuf.end();
+    if (batch.graphicsUsed)
+        batch.graphicsCmdBuf.end();
+
+    if (batch.transferUsed && batch.graphicsUsed)
+    {
+        const VkPipelineStageFlags waitStage = VK_PIPELINE_STAGE_TRANSFER_BIT;
+        vk::queueSubmit(transferQueue_, 0, nullptr, 1, &batch.transferCompleteSemaphore, 1, batch.transferCmdBuf);
+        vk::queueSubmit(graphicsQueue_, 1, &batch.transferCompleteSemaphore, signalCount, &batch.completeSemaphore,
+            1, batch.graphicsCmdBuf, &waitStage, batch.fence);
+    }
+    else if (batch.transferUsed)
+        vk::queueSubmit(transferQueue_, 0, nullptr, signalCount, &batch.completeSemaphore, 1, batch.transferCmdBuf, nullptr, batch.fence);
+    else
+    {
+        const auto cmdBufCount = batch.graphicsUsed ? 1u : 0u;
+        vk::queueSubmit(graphicsQueue_, 0, nullptr, signalCount, &batch.completeSemaphore,
+            cmdBufCount, batch.graphicsCmdBuf, nullptr, batch.fence);
+    }
+}
+
+void VulkanUploader::retire(bool wait)
+{
+    while (!inFlight_.empty())
+    {
+        auto &batch = *inFlight_.front();
+
+        if (wait)
+        {
+            SL_VK_CHECK_RESULT(vkWaitForFences(device_, 1, &batch.fence, VK_TRUE, UINT64_MAX));
+        }
+        else if (vkGetFenceStatus(device_, batch.fence) != VK_SUCCESS)
+            break;
+
+        SL_VK_CHECK_RESULT(vkResetFences(device_, 1, &batch.fence));
+        if (batch.ringEnd)
+            ringTail_ = batch.ringEnd;
+        batch.ringEnd = 0;
+        batch.dedicatedBuffers.clear();
+        batch.dedicatedMemory.clear();
+        batch.transferUsed = false;
+        batch.graphicsUsed = false;
+
+        free_.push_back(std::move(inFlight_.front()));
+        inFlight_.pop_front();
+
+        if (wait)
+            break;
+    }
+}
+
+void VulkanUploader::makeRingSpace(VkDeviceSize size)
+{
+    auto start = alignUp(ringHead_, alignment_);
+    if (start % ringSize_ + size > ringSize_)
+        start += ringSize_ - start % ringSize_; // doesn't fit before the end, wrap around
+
+    while (start + size - ringTail_ > ringSize_)
+    {
+        if (inFlight_.empty())
+        {
+            SL_DEBUG_PANIC(!current_, "Staging ring is unexpectedly full");
+            // The whole ring is taken by the batch being recorded, so push it out and wait for it
+            submit(*current_, false);
+            inFlight_.push_back(std::move(current_));
+        }
+        retire(true);
+    }
+
+    ringHead_ = start + size;
+    currentBatch().ringEnd = ringHead_;
+}
+
+auto VulkanUploader::stageDedicated(VkDeviceSize size) -> Staging
+{
+    auto &batch = currentBatch();
+    VulkanResource<VkBuffer> buffer;
+    VulkanResource<VkDeviceMemory> memory;
+    const auto data = createHostVisibleBuffer(size, buffer, memory);
+    const Staging staging{buffer, 0, data};
+
+    batch.dedicatedBuffers.push_back(std::move(buffer));
+    batch.dedicatedMemory.push_back(std::move(memory));
+
+    return staging;
+}
+
+auto VulkanUploader::createHostVisibleBuffer(VkDeviceSize size, VulkanResource<VkBuffer> &buffer,
+    VulkanResource<VkDeviceMemory> &memory) const -> u8*
+{
+    VkBufferCreateInfo bufferInfo{};
+    bufferInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+    bufferInfo.size = size;
+    bufferInfo.usage = VK_BUFFER_USAGE_TRANSFER_SRC_BIT;
+    bufferInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+
+    buffer = VulkanResource<VkBuffer>{device_, vkDestroyBuffer};
+    SL_VK_CHECK_RESULT(vkCreateBuffer(device_, &bufferInfo, nullptr, buffer.cleanRef()));
+
+    VkMemoryRequirements memReqs;
+    vkGetBufferMemoryRequirements(device_, buffer, &memReqs);
+
+    VkMemoryAllocateInfo allocInfo{};
+    allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+    allocInfo.allocationSize = memReqs.size;
+    allocInfo.memoryTypeIndex = vk::findMemoryType(memProps_, memReqs.memoryTypeBits,
+        VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+
+    memory = VulkanResource<VkDeviceMemory>{device_, vkFreeMemory};
+    SL_VK_CHECK_RESULT(vkAllocateMemory(device_, &allocInfo, nullptr, memory.cleanRef()));
+    SL_VK_CHECK_RESULT(vkBindBufferMemory(device_, buffer, memory, 0));
+
+    // Stays mapped for the lifetime of the buffer
+    void *data = nullptr;
+    SL_VK_CHECK_RESULT(vkMapMemory(device_, memory, 0, VK_WHOLE_SIZE, 0, &data));
+
+    return static_cast<u8*>(data);
+}
+
+#endif
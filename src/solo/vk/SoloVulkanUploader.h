@@ -0,0 +1,94 @@
+/* 
+ * Copyright (c) Aleksey Fedotov 
+ * MIT license 
+ */
+
+#pragma once
+
+#include "SoloCommon.h"
+
+#ifdef SL_VULKAN_RENDERER
+
+#include "SoloVulkan.h"
+#include "SoloVulkanCmdBuffer.h"
+
+namespace solo
+{
+    // Schedules resource uploads without stalling the graphics queue. Data is copied into a persistently mapped
+    // staging ring, copies are recorded for the transfer queue and follow-up work that needs a graphics queue
+    // (layout transitions, mip blits) is recorded separately and submitted after the copies.
+    // Nothing is submitted until flush(), which returns a semaphore the next graphics submit must wait on.
+    class VulkanUploader final: public NoCopyAndMove
+    {
+    public:
+        struct Staging
+        {
+            VkBuffer buffer;
+            VkDeviceSize offset;
+            u8 *data;
+        };
+
+        VulkanUploader(VkDevice device, VkPhysicalDeviceMemoryProperties memProps, VkDeviceSize alignment,
+            VkQueue graphicsQueue, u32 graphicsQueueIndex, VkQueue transferQueue, u32 transferQueueIndex);
+        ~VulkanUploader();
+
+        bool hasDedicatedTransferQueue() const { return graphicsQueueIndex_ != transferQueueIndex_; }
+
+        // Returned memory must be filled before the next flush()
+        auto stage(VkDeviceSize size) -> Staging;
+
+        auto transferCmdBuffer() -> VulkanCmdBuffer&;
+        auto graphicsCmdBuffer() -> VulkanCmdBuffer&;
+
+        void uploadBuffer(const void *data, VkDeviceSize size, VkBuffer dst);
+
+        auto flush() -> VkSemaphore;
+
+    private:
+        struct Batch
+        {
+            VulkanCmdBuffer transferCmdBuf;
+            VulkanCmdBuffer graphicsCmdBuf;
+            VulkanResource<VkSemaphore> transferCompleteSemaphore;
+            VulkanResource<VkSemaphore> completeSemaphore;
+            VulkanResource<VkFence> fence;
+            vec<VulkanResource<VkBuffer>> dedicatedBuffers;
+            vec<VulkanResource<VkDeviceMemory>> dedicatedMemory;
+            u64 ringEnd = 0;
+            bool transferUsed = false;
+            bool graphicsUsed = false;
+        };
+
+        VkDevice device_ = VK_NULL_HANDLE;
+        VkPhysicalDeviceMemoryProperties memProps_;
+        VkDeviceSize alignment_ = 0;
+        VkQueue graphicsQueue_ = VK_NULL_HANDLE;
+        VkQueue transferQueue_ = VK_NULL_HANDLE;
+        u32 graphicsQueueIndex_ = 0;
+        u32 transferQueueIndex_ = 0;
+
+        VulkanResource<VkCommandPool> graphicsCmdPool_;
+        VulkanResource<VkCommandPool> transferCmdPool_;
+
+        VulkanResource<VkBuffer> ringBuffer_;
+        VulkanResource<VkDeviceMemory> ringMemory_;
+        u8 *ringData_ = nullptr;
+        VkDeviceSize ringSize_ = 0;
+        u64 ringHead_ = 0; // positions grow monotonically, wrapped only when addressing the buffer
+        u64 ringTail_ = 0;
+
+        uptr<Batch> current_;
+        list<uptr<Batch>> inFlight_;
+        vec<uptr<Batch>> free_;
+
+        auto currentBatch() -> Batch&;
+        void submit(Batch &batch, bool signal);
+        void retire(bool wait);
+        void makeRingSpace(VkDeviceSize size);
+        auto stageDedicated(VkDeviceSize size) -> Staging;
+        auto createHostVisibleBuffer(VkDeviceSize size, VulkanResource<VkBuffer> &buffer,
+            VulkanResource<VkDeviceMemory> &memory) const -> u8*;
+    };
+}
+
+#endif